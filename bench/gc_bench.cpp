@@ -0,0 +1,408 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: bench/gc_bench.cpp
+// ----------------------------------
+
+// Runs standard collector workloads under blocking minor collections,
+// blocking major collections and incremental steps, and reports allocation
+// throughput, total pause time and pause percentiles for each.
+//
+// Usage: gc_bench [--json] [--scale=F] [--workload=NAME]
+//   --json      print one JSON object instead of a table
+//   --scale=F   multiply every workload's size by F (default 1)
+//   --workload  run only the named workload
+
+#include "GC.h"
+#include "GCMember.h"
+#include "GCObject.h"
+#include "GCRef.h"
+#include "GCStats.h"
+#include "GCTracer.h"
+#include "GCVector.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    class TreeNode : public GCObject {
+    public:
+        GCMember<TreeNode> left, right;
+
+        GC_FIELDS(&TreeNode::left, &TreeNode::right)
+    };
+
+    class ListNode : public GCObject {
+    public:
+        GCMember<ListNode> next;
+        long value = 0;
+
+        GC_FIELDS(&ListNode::next)
+    };
+
+    class GraphNode : public GCObject {
+    public:
+        GCMember<GraphNode> a, b;
+        long value = 0;
+
+        GC_FIELDS(&GraphNode::a, &GraphNode::b)
+    };
+
+    // Fixed-size table of references, so a large object set hangs off a
+    // single root.
+    using Table = GCArray<GraphNode>;
+
+    // A vertex whose out-edges are kept in a GCVector.
+    class Vertex : public GCObject {
+    public:
+        GCMember<GCVector<Vertex>> edges;
+
+        GC_FIELDS(&Vertex::edges)
+    };
+
+    enum class Mode { Minor, Major, Incremental };
+
+    const char* modeName(Mode mode) {
+        switch (mode) {
+            case Mode::Minor: return "minor";
+            case Mode::Major: return "major";
+            case Mode::Incremental: return "incremental";
+        }
+        return "?";
+    }
+
+    // Decides when to collect. Workloads call poll() at points where every
+    // object they still need is rooted. Blocking modes collect once enough
+    // has been allocated since the last collection; incremental mode lets
+    // the heap policy start cycles and takes one step per poll.
+    class Driver {
+    public:
+        explicit Driver(Mode mode) : mode(mode) {}
+
+        void poll() {
+            size_t used = GC::heapBytes();
+            switch (mode) {
+                case Mode::Minor:
+                    if (used >= lastUsed + kMinorBytes) {
+                        GC::collectNow(false);
+                        lastUsed = GC::heapBytes();
+                    }
+                    break;
+                case Mode::Major:
+                    if (used >= max(2 * lastUsed, kMajorBytes)) {
+                        GC::collectNow(true);
+                        lastUsed = GC::heapBytes();
+                    }
+                    break;
+                case Mode::Incremental:
+                    GC::incrementalCollectStep();
+                    break;
+            }
+        }
+
+    private:
+        static constexpr size_t kMinorBytes = 4 * 1024 * 1024;
+        static constexpr size_t kMajorBytes = 8 * 1024 * 1024;
+
+        Mode mode;
+        size_t lastUsed = 0;
+    };
+
+    // Results are stored here, where the optimizer cannot see them unused,
+    // so the loops that computed them are kept.
+    volatile long sink;
+
+    void doNotOptimize(long value) { sink = value; }
+
+    size_t scaled(double scale, size_t n) { return max<size_t>(1, static_cast<size_t>(static_cast<double>(n) * scale)); }
+
+    TreeNode* buildTree(int depth) {
+        auto* node = GC::make<TreeNode>();
+        if (depth > 0) {
+            node->left = buildTree(depth - 1);
+            node->right = buildTree(depth - 1);
+        }
+        return node;
+    }
+
+    // Allocates many short-lived trees of growing depth next to one
+    // long-lived tree, as in the binary-trees benchmark.
+    void binaryTrees(Driver& drv, double scale) {
+        int maxDepth = 6 + static_cast<int>(scaled(scale, 8));
+        GCRef<TreeNode> longLived(buildTree(maxDepth));
+        drv.poll();
+        for (int depth = 4; depth <= maxDepth; depth += 2) {
+            long iterations = 1L << (maxDepth - depth + 4);
+            for (long i = 0; i < iterations; ++i) {
+                GCRef<TreeNode> tree(buildTree(depth));
+                drv.poll();
+            }
+        }
+    }
+
+    // Builds one long rooted list, so marking has to follow a deep chain,
+    // then walks it.
+    void linkedList(Driver& drv, double scale) {
+        size_t length = scaled(scale, 1000000);
+        GCRef<ListNode> head(GC::make<ListNode>());
+        ListNode* tail = head.get();
+        for (size_t i = 1; i < length; ++i) {
+            auto* node = GC::make<ListNode>();
+            node->value = static_cast<long>(i);
+            tail->next = node;
+            tail = node;
+            if (i % 256 == 0) drv.poll();
+        }
+        long sum = 0;
+        for (ListNode* n = head.get(); n; n = n->next.get()) sum += n->value;
+        doNotOptimize(sum);
+    }
+
+    // Keeps a random graph at a fixed size while replacing nodes, so most
+    // garbage is older than one collection.
+    void randomGraph(Driver& drv, double scale) {
+        size_t nodes = scaled(scale, 100000);
+        size_t replacements = scaled(scale, 2000000);
+        mt19937_64 rng(42);
+        GCRef<Table> table(GC::make<Table>(nodes));
+        for (size_t i = 0; i < nodes; ++i) table->set(i, GC::make<GraphNode>());
+        auto pick = [&] { return table->get(rng() % nodes); };
+        for (size_t i = 0; i < nodes; ++i) {
+            table->get(i)->a = pick();
+            table->get(i)->b = pick();
+        }
+        for (size_t i = 0; i < replacements; ++i) {
+            auto* node = GC::make<GraphNode>();
+            node->a = pick();
+            node->b = pick();
+            table->set(rng() % nodes, node);
+            pick()->a = node;
+            if (i % 256 == 0) drv.poll();
+        }
+    }
+
+    // Holds every object through its own root GCRef, so root scans dominate.
+    void largeRootSet(Driver& drv, double scale) {
+        size_t rootCount = scaled(scale, 200000);
+        size_t replacements = scaled(scale, 2000000);
+        mt19937_64 rng(7);
+        vector<GCRef<ListNode>> roots;
+        roots.reserve(rootCount);
+        for (size_t i = 0; i < rootCount; ++i) roots.emplace_back(GC::make<ListNode>());
+        for (size_t i = 0; i < replacements; ++i) {
+            roots[rng() % rootCount] = GC::make<ListNode>();
+            if (i % 256 == 0) drv.poll();
+        }
+    }
+
+    // Allocates short lists that die young while a small fraction of nodes
+    // is kept in a long-lived table.
+    void generational(Driver& drv, double scale) {
+        size_t kept = scaled(scale, 50000);
+        size_t batches = scaled(scale, 400000);
+        mt19937_64 rng(11);
+        GCRef<Table> table(GC::make<Table>(kept));
+        for (size_t i = 0; i < batches; ++i) {
+            GraphNode* head = nullptr;
+            for (int j = 0; j < 10; ++j) {
+                auto* node = GC::make<GraphNode>();
+                node->a = head;
+                head = node;
+            }
+            if (rng() % 100 == 0) table->set(rng() % kept, head);
+            if (i % 32 == 0) drv.poll();
+        }
+    }
+
+    // Keeps a graph of vertices with growing edge lists and rewires it, so
+    // most references live in a few large containers.
+    void adjacencyList(Driver& drv, double scale) {
+        size_t vertices = scaled(scale, 50000);
+        size_t rewires = scaled(scale, 1000000);
+        mt19937_64 rng(23);
+        GCRef<GCVector<Vertex>> graph(GC::make<GCVector<Vertex>>());
+        graph->reserve(vertices);
+        for (size_t i = 0; i < vertices; ++i) {
+            graph->push_back(GC::make<Vertex>());
+            graph->back()->edges = GC::make<GCVector<Vertex>>();
+            if (i % 256 == 0) drv.poll();
+        }
+        vector<Vertex*> targets(8);
+        for (size_t i = 0; i < rewires; ++i) {
+            size_t k = rng() % vertices;
+            if (i % 16 == 0) {
+                // Replace the vertex; it is rooted before its edge list is made.
+                graph->set(k, GC::make<Vertex>());
+                graph->get(k)->edges = GC::make<GCVector<Vertex>>();
+            }
+            GCVector<Vertex>* edges = graph->get(k)->edges.get();
+            if (edges->size() >= 64) edges->clear();
+            for (Vertex*& t : targets) t = graph->get(rng() % vertices);
+            edges->append(span<Vertex* const>(targets));
+            if (i % 256 == 0) drv.poll();
+        }
+    }
+
+    // Drops a chain of nodes that point at each other next to a live chain
+    // of the same length, so collections are dominated by sweeping. Sweep
+    // cost should grow linearly with --scale.
+    void deadChains(Driver& drv, double scale) {
+        size_t length = scaled(scale, 100000);
+        for (int round = 0; round < 10; ++round) {
+            GCRef<GraphNode> live(GC::make<GraphNode>());
+            GCRef<GraphNode> doomed(GC::make<GraphNode>());
+            GraphNode* tail = live.get();
+            for (size_t i = 0; i < length; ++i) {
+                tail->a = GC::make<GraphNode>();
+                tail = tail->a.get();
+                auto* node = GC::make<GraphNode>();
+                node->a = doomed.get();
+                node->b = doomed.get();
+                doomed = node;
+                if (i % 256 == 0) drv.poll();
+            }
+            doomed = nullptr;
+            drv.poll();
+        }
+    }
+
+    struct Workload {
+        const char* name;
+        void (*run)(Driver&, double);
+    };
+
+    const Workload kWorkloads[] = {
+        {"binary_trees", binaryTrees},
+        {"linked_list", linkedList},
+        {"random_graph", randomGraph},
+        {"large_root_set", largeRootSet},
+        {"generational", generational},
+        {"adjacency_list", adjacencyList},
+        {"dead_chains", deadChains},
+    };
+
+    struct Result {
+        const char* workload;
+        Mode mode;
+        double seconds;
+        GCStats delta;
+        GCPauseHistogram pauses;
+    };
+
+    // Runs one workload from an empty heap. Counters are reported as the
+    // difference between stats() before and after; the pause maximum is the
+    // upper bound of the highest bucket that gained pauses.
+    Result measure(const Workload& w, Mode mode, double scale) {
+        GC::init(5000, 5000, 0, 50);
+        GCHeapPolicy policy;
+        if (mode != Mode::Incremental) policy.growthRatio = 0; // the driver decides
+        GC::setHeapPolicy(policy);
+        GC::collectNow(true);
+
+        GCStats before = GC::stats();
+        auto start = chrono::steady_clock::now();
+        {
+            Driver drv(mode);
+            w.run(drv, scale);
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        GCStats after = GC::stats();
+
+        Result r{w.name, mode, seconds, after, {}};
+        r.delta.minorCollections -= before.minorCollections;
+        r.delta.majorCollections -= before.majorCollections;
+        r.delta.incrementalCycles -= before.incrementalCycles;
+        r.delta.incrementalSteps -= before.incrementalSteps;
+        r.delta.objectsAllocated -= before.objectsAllocated;
+        r.delta.bytesAllocated -= before.bytesAllocated;
+        r.delta.objectsFreed -= before.objectsFreed;
+        for (unsigned b = 0; b < GCPauseHistogram::kBuckets; ++b) {
+            r.pauses.counts[b] = after.pauses.counts[b] - before.pauses.counts[b];
+            if (r.pauses.counts[b]) {
+                auto limit = chrono::nanoseconds(static_cast<int64_t>(GCPauseHistogram::bucketLimit(b) - 1));
+                r.pauses.max = min(limit, after.pauses.max);
+            }
+        }
+        r.pauses.count = after.pauses.count - before.pauses.count;
+        r.pauses.total = after.pauses.total - before.pauses.total;
+
+        // Leave an empty heap for the next run.
+        GC::setHeapPolicy(GCHeapPolicy{});
+        GC::collectNow(true);
+        return r;
+    }
+
+    double micros(chrono::nanoseconds ns) { return static_cast<double>(ns.count()) / 1000.0; }
+
+    void printTable(const vector<Result>& results) {
+        printf("%-15s %-12s %8s %9s %8s %9s %6s %9s %9s %9s\n", "workload", "mode", "time s", "Mobj/s",
+               "MB/s", "gc ms", "pauses", "p50 us", "p99 us", "max us");
+        for (const Result& r : results) {
+            printf("%-15s %-12s %8.3f %9.2f %8.1f %9.2f %6llu %9.1f %9.1f %9.1f\n", r.workload, modeName(r.mode),
+                   r.seconds, static_cast<double>(r.delta.objectsAllocated) / r.seconds / 1e6,
+                   static_cast<double>(r.delta.bytesAllocated) / r.seconds / (1024 * 1024),
+                   micros(r.pauses.total) / 1000.0, static_cast<unsigned long long>(r.pauses.count),
+                   micros(r.pauses.percentile(0.5)), micros(r.pauses.percentile(0.99)), micros(r.pauses.max));
+        }
+    }
+
+    void printJson(const vector<Result>& results, double scale) {
+        printf("{\"benchmark\":\"gc_bench\",\"scale\":%g,\"results\":[", scale);
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            printf("%s\n{\"workload\":\"%s\",\"mode\":\"%s\",\"seconds\":%.6f,"
+                   "\"objects_allocated\":%llu,\"bytes_allocated\":%llu,\"objects_freed\":%llu,"
+                   "\"minor_collections\":%llu,\"major_collections\":%llu,\"incremental_cycles\":%llu,"
+                   "\"pauses\":%llu,\"gc_us\":%.1f,\"p50_us\":%.1f,\"p99_us\":%.1f,\"max_us\":%.1f}",
+                   i ? "," : "", r.workload, modeName(r.mode), r.seconds,
+                   static_cast<unsigned long long>(r.delta.objectsAllocated),
+                   static_cast<unsigned long long>(r.delta.bytesAllocated),
+                   static_cast<unsigned long long>(r.delta.objectsFreed),
+                   static_cast<unsigned long long>(r.delta.minorCollections),
+                   static_cast<unsigned long long>(r.delta.majorCollections),
+                   static_cast<unsigned long long>(r.delta.incrementalCycles),
+                   static_cast<unsigned long long>(r.pauses.count), micros(r.pauses.total),
+                   micros(r.pauses.percentile(0.5)), micros(r.pauses.percentile(0.99)), micros(r.pauses.max));
+        }
+        printf("\n]}\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    bool json = false;
+    double scale = 1.0;
+    string only;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (strncmp(argv[i], "--scale=", 8) == 0) {
+            scale = atof(argv[i] + 8);
+        } else if (strncmp(argv[i], "--workload=", 11) == 0) {
+            only = argv[i] + 11;
+        } else {
+            fprintf(stderr, "usage: %s [--json] [--scale=F] [--workload=NAME]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (scale <= 0) scale = 1.0;
+
+    vector<Result> results;
+    for (const Workload& w : kWorkloads) {
+        if (!only.empty() && only != w.name) continue;
+        for (Mode mode : {Mode::Minor, Mode::Major, Mode::Incremental}) results.push_back(measure(w, mode, scale));
+    }
+    if (json) {
+        printJson(results, scale);
+    } else {
+        printTable(results);
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: bench/gc_footprint.cpp
+// ----------------------------------
+
+// Reports the memory each object costs for a few common node shapes: the
+// heap cell (including page overhead) plus, on glibc, malloc'd side storage
+// such as member GCRef lists.
+
+#include "GC.h"
+#include "GCHeap.h"
+#include "GCMember.h"
+#include "GCObject.h"
+#include "GCRef.h"
+
+#include <cstdio>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+using namespace std;
+
+namespace {
+    class EmptyNode : public GCObject {
+    public:
+        int value = 0;
+    };
+
+    class RefNode : public GCObject {
+    public:
+        GCRef<RefNode> left, right;
+        int value = 0;
+
+        RefNode() : left(this, nullptr), right(this, nullptr) {}
+    };
+
+    class MemberNode : public GCObject {
+    public:
+        GCMember<MemberNode> left, right;
+        int value = 0;
+
+        GC_FIELDS(&MemberNode::left, &MemberNode::right)
+    };
+
+    size_t mallocBytes() {
+#ifdef __GLIBC__
+        return mallinfo2().uordblks;
+#else
+        return 0;
+#endif
+    }
+
+    template <typename T>
+    void measure(const char* name, int count) {
+        GC::init(1000000000, 1000000000, 1000000000, 50);
+        // The objects are not rooted; nothing collects until they are counted.
+        vector<T*> objects;
+        objects.reserve(count);
+        size_t heapBefore = GCHeap::mappedBytes();
+        size_t sideBefore = mallocBytes();
+        for (int i = 0; i < count; ++i) objects.push_back(new T());
+        double heap = double(GCHeap::mappedBytes() - heapBefore) / count;
+        double side = double(mallocBytes() - sideBefore) / count;
+        printf("%-12s sizeof %4zu  heap %6.1f B/obj  side %6.1f B/obj  total %6.1f B/obj\n",
+               name, sizeof(T), heap, side, heap + side);
+        objects.clear();
+        GC::collectNow(true);
+    }
+}
+
+int main() {
+    const int count = 200000;
+    printf("sizeof(GCObject) %zu\n", sizeof(GCObject));
+    measure<EmptyNode>("empty", count);
+    measure<RefNode>("two GCRef", count);
+    measure<MemberNode>("two GCMember", count);
+    return 0;
+}
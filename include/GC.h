@@ -8,11 +8,97 @@
 #ifndef TERMPROJECT_GC_H
 #define TERMPROJECT_GC_H
 
-#include <unordered_set>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "GCHeap.h"
+#include "GCObject.h"
+#include "GCStats.h"
+
 class GCObject;
 class GCRefBase;
+class GCWeakRefBase;
+class GCEphemeronTable;
+
+/**
+ * @enum GCSweepMode
+ * @brief How a major collection reclaims dead objects once marking is done.
+ */
+enum class GCSweepMode {
+    /** @brief Budgeted sweep steps on the mutator; collectNow() sweeps at once. */
+    Incremental,
+    /** @brief Each page is swept when the allocator needs cells of its size class. */
+    Lazy,
+    /** @brief A sweeper thread runs destructors; the mutator only frees cells. */
+    Background
+};
+
+/**
+ * @enum GCFinalization
+ * @brief Where the destructors of dead objects run.
+ */
+enum class GCFinalization {
+    /** @brief The sweep destroys each dead object as it finds it. */
+    Inline,
+    /** @brief The sweep queues dead objects for GC::runFinalizers(). */
+    Deferred,
+    /** @brief The sweep queues dead objects for a finalizer thread. */
+    Background
+};
+
+/**
+ * @struct GCHeapPolicy
+ * @brief When collections start, in bytes of objects on heap pages.
+ *
+ * After each major mark the collector sets a heap goal from the bytes that
+ * survived, and an allocation that takes the heap past the goal starts an
+ * incremental cycle. Nursery objects are not counted; the nursery has a
+ * fixed size and is emptied by every collection.
+ */
+struct GCHeapPolicy {
+    /**
+     * @brief Growth allowed over the live bytes before the next cycle.
+     *
+     * 1.0 lets the heap double, like GOGC=100. Zero disables the growth
+     * trigger, leaving only the soft target and the hard limit.
+     */
+    double growthRatio = 1.0;
+
+    /** @brief Smallest heap goal, so small heaps are not collected constantly. */
+    std::size_t minHeapBytes = 4 * 1024 * 1024;
+
+    /**
+     * @brief Soft memory target; the goal is capped here so cycles start
+     * earlier as the heap approaches it. Zero means none.
+     */
+    std::size_t softLimitBytes = 0;
+
+    /**
+     * @brief Hard limit. Zero means none.
+     *
+     * An allocation never collects, since the object whose constructor is
+     * allocating is not rooted yet. The first allocation that passes the
+     * limit is allowed and requests a full collection, which runs at the
+     * thread's next GC::safepoint(). If the heap is still at the limit
+     * after it, allocations that would pass the limit throw
+     * std::bad_alloc. Threads must poll safepoint() to keep the heap near
+     * the limit.
+     */
+    std::size_t hardLimitBytes = 0;
+
+    /**
+     * @brief If set, the soft target is also capped at three quarters of
+     * the container's memory limit, as read by GC::cgroupMemoryLimit().
+     */
+    bool useCgroupLimit = false;
+};
 
 /**
  * @file GC.h
@@ -26,6 +112,11 @@ class GCRefBase;
  * The collector supports incremental collection with optional generational
  * behavior. Objects must derive from GCObject, and references must be managed
  * through GCRef<T>.
+ *
+ * Any number of threads may allocate and hold roots. Each thread allocates
+ * from its own buffers and registers roots in its own table. Collections
+ * stop the world cooperatively: the collecting thread waits until every
+ * other thread is parked in safepoint() or inside a safe region.
  */
 class GC {
 public:
@@ -34,20 +125,93 @@ public:
      *
      * @param markBudget Maximum number of objects marked per step.
      * @param sweepBudget Maximum number of objects swept per step.
-     * @param allocThreshold Allocation count before triggering GC.
-     * @param youngThresh Survivals before promotion to old generation.
+     * @param allocThreshold Objects allocated before a cycle starts,
+     *        in addition to the byte-based GCHeapPolicy trigger; 0 disables it.
+     * @param youngThresh Unused; kept for source compatibility.
      */
     static void init(int markBudget = 20,
                      int sweepBudget = 10,
-                     int allocThreshold = 100,
+                     int allocThreshold = 0,
                      int youngThresh = 50);
 
+    /**
+     * @brief Allocates and constructs a GC-managed object.
+     *
+     * The size class is resolved at compile time, so allocation is a free
+     * list pop or pointer bump in the common case. Equivalent to `new T(...)`,
+     * which also allocates from the size-class heap. Types satisfying
+     * GCMovableType are bump-allocated in the nursery when it has room.
+     *
+     * @tparam T Type to construct; must inherit from GCObject.
+     * @param args Constructor arguments.
+     * @return Pointer to the new object.
+     */
+    template <typename T, typename... Args>
+    static T* make(Args&&... args) {
+        static_assert(std::is_base_of_v<GCObject, T>, "T must inherit GCObject");
+        static_assert(alignof(T) <= GCHeap::kCellAlign, "over-aligned GC objects are not supported");
+        static_assert(sizeof(T) <= GCHeap::kMaxLargeSize, "GC objects are limited to GCHeap::kMaxLargeSize bytes");
+
+        constexpr unsigned cls = GCHeap::sizeClassFor(sizeof(T));
+        beforeAllocate(sizeof(T));
+        void* mem = nullptr;
+        if constexpr (cls == GCHeap::kLargeClass) {
+            mem = GCHeap::allocateLarge(sizeof(T));
+        } else {
+            if constexpr (GCMovableType<T>) {
+                mem = GCHeap::allocateNursery(sizeof(T));
+            }
+            if (!mem) mem = GCHeap::allocateSmall(cls);
+        }
+        T* obj = nullptr;
+        try {
+            obj = ::new (mem) T(std::forward<Args>(args)...);
+            if constexpr (GCMovableType<T>) obj->gcHeader().initFlags(GCHeader::kMovable);
+            return obj;
+        } catch (...) {
+            if (obj) obj->~T();
+            unregisterObject(static_cast<GCObject*>(mem));
+            GCHeap::deallocate(mem);
+            throw;
+        }
+    }
+
     /**
      * @brief Registers a newly allocated object with the collector.
      * @param obj Pointer to the object.
      */
     static void registerObject(GCObject* obj);
 
+    /**
+     * @brief Undoes registerObject() for an object whose constructor threw.
+     *
+     * Rolls back the object counts and heap bytes recorded for the cell.
+     * Call it before the cell is returned with GCHeap::deallocate().
+     *
+     * @param obj Cell of the object that failed to construct.
+     */
+    static void unregisterObject(GCObject* obj);
+
+    /**
+     * @brief Records a nursery object that owns out-of-line storage.
+     *
+     * Dead nursery objects are dropped without running their destructors,
+     * so the collector releases their member-reference storage itself.
+     *
+     * @param obj Nursery object.
+     */
+    static void registerNurseryStorage(GCObject* obj);
+
+    /**
+     * @brief Sets the capacity of the copying nursery.
+     *
+     * Takes effect the next time the nursery is empty. Passing 0 disables
+     * the nursery and movable types are allocated like any other object.
+     *
+     * @param bytes Nursery capacity in bytes.
+     */
+    static void setNurserySize(std::size_t bytes);
+
     /**
      * @brief Registers a root reference.
      * @param r Pointer to the root reference.
@@ -60,8 +224,85 @@ public:
      */
     static void unregisterRoot(GCRefBase* r);
 
+    /**
+     * @brief Registers a weak reference in the calling thread's weak table.
+     * @param r Pointer to the weak reference.
+     */
+    static void registerWeakRef(GCWeakRefBase* r);
+
+    /**
+     * @brief Removes a weak reference from its thread's weak table.
+     * @param r Pointer to the weak reference.
+     */
+    static void unregisterWeakRef(GCWeakRefBase* r);
+
+    /**
+     * @brief Registers an ephemeron table so collections clear its dead keys.
+     * @param table Table to register.
+     */
+    static void registerEphemeronTable(GCEphemeronTable* table);
+
+    /**
+     * @brief Unregisters an ephemeron table.
+     * @param table Table to unregister.
+     */
+    static void unregisterEphemeronTable(GCEphemeronTable* table);
+
+    /**
+     * @brief Safepoint poll; parks the calling thread while another thread
+     * collects.
+     *
+     * Threads are only stopped at polls, so a thread that runs for a while
+     * without calling the collector should poll regularly. Objects the
+     * thread holds only through raw pointers may be freed or moved while it
+     * is parked, so hold them in GCRefs across a poll.
+     */
+    static void safepoint() {
+        if (safepointRequested.load(std::memory_order_relaxed)) {
+            parkAtSafepoint();
+        } else if (hardLimitPending.load(std::memory_order_relaxed)) {
+            collectAtHardLimit();
+        } else if (rootScanPending.load(std::memory_order_relaxed)) {
+            scanRootsAtSafepoint();
+        }
+    }
+
+    /**
+     * @brief Runs collector work owed by an allocation that is about to
+     * happen.
+     *
+     * Called by GC::make() and GCObject::operator new before they take
+     * memory. Checks the hard heap limit and, while a paced cycle is
+     * running, charges the allocation its share of the cycle, doing one
+     * incremental step once enough is owed. Does nothing unless a pause
+     * target or a hard limit is set.
+     *
+     * @param bytes Size of the object.
+     */
+    static void beforeAllocate(std::size_t bytes) {
+        if (allocationHookActive.load(std::memory_order_relaxed)) beforeAllocateSlow(bytes);
+    }
+
+    /**
+     * @brief Marks the calling thread as not touching GC objects, e.g.
+     * before it blocks, so collections need not wait for it.
+     */
+    static void enterSafeRegion();
+
+    /**
+     * @brief Ends a safe region, waiting for a running collection to finish.
+     */
+    static void leaveSafeRegion();
+
     /**
      * @brief Performs a blocking garbage collection cycle.
+     *
+     * A minor collection traces only from roots and the remembered set into
+     * the young generation, so its cost follows the young generation's size
+     * rather than the whole heap. Both kinds of collection first evacuate
+     * live nursery objects into the old generation and redirect every GCRef
+     * that pointed at them.
+     *
      * @param major If true, performs a major (full) collection.
      */
     static void collectNow(bool major = false);
@@ -81,21 +322,293 @@ public:
      * @brief Write barrier invoked on member reference updates.
      *
      * This method must be called whenever a GCObject updates a member
-     * reference to another GCObject.
+     * reference to another GCObject. It records old objects that gain a
+     * young child in the remembered set, and shades the child while an
+     * incremental mark is running.
      *
      * @param owner Owning object.
      * @param child Referenced child object.
      */
     static void writeBarrier(GCObject* owner, GCObject* child);
 
+    /**
+     * @brief Write barrier for a GCMember field.
+     *
+     * Finds the owning object from the field's address and then does the
+     * same as writeBarrier().
+     *
+     * @param slot Address of the field inside its owner.
+     * @param child Referenced child object.
+     * @throws std::length_error If slot lies beyond the first page of a large
+     *         object, where no page header can be found for it.
+     */
+    static void writeBarrierAt(const void* slot, GCObject* child);
+
+    /**
+     * @brief Write barrier for storing many children into one object at once.
+     *
+     * Does the same as calling writeBarrier() for each child, but tests
+     * the owner's generation and color only once.
+     *
+     * @param owner Owning object.
+     * @param children Stored children; null entries are skipped.
+     * @param count Number of children.
+     */
+    static void writeBarrierRange(GCObject* owner, GCObject* const* children, std::size_t count);
+
+    /**
+     * @brief Deletion barrier invoked before a member reference is overwritten.
+     *
+     * While a concurrent cycle is marking, the overwritten object is logged
+     * so the collector still traces everything that was reachable when the
+     * cycle started (snapshot at the beginning). Otherwise does nothing.
+     *
+     * @param overwritten Object the reference pointed at before the store.
+     */
+    static void deletionBarrier(GCObject* overwritten) {
+        if (snapshotActive && overwritten) recordOverwritten(overwritten);
+    }
+
+    /**
+     * @brief Barrier for reads of weakly held objects.
+     *
+     * While a concurrent cycle is marking, the object is logged like an
+     * overwritten reference, so the mutator cannot store a weakly held
+     * object somewhere the snapshot has already been traced and have the
+     * cycle clear it anyway. Otherwise does nothing.
+     *
+     * @param obj Object read through a weak reference or ephemeron table.
+     */
+    static void readBarrier(GCObject* obj) {
+        if (snapshotActive && obj) recordOverwritten(obj);
+    }
+
+    /**
+     * @brief Enables or disables concurrent marking for incremental cycles.
+     *
+     * When enabled, an incremental cycle scans roots in its first step and
+     * then marks on a background collector thread while the mutator runs.
+     * Later steps return immediately until that thread is done, then run a
+     * short final remark that only traces references overwritten since the
+     * cycle began. trace() and traceChildren() overrides must only read
+     * the object.
+     * Takes effect at the start of the next cycle.
+     *
+     * @param enabled True to mark on the collector thread.
+     */
+    static void setConcurrentMarking(bool enabled);
+
+    /**
+     * @brief Selects how major collections sweep.
+     *
+     * In Lazy and Background mode, a major collection returns to the
+     * mutator as soon as marking is done. Lazy sweeping runs destructors on
+     * the allocating thread, only when a size class runs out of cells, and
+     * finishes any leftover pages before the next collection. Background
+     * sweeping runs destructors on a dedicated thread, so destructors must
+     * not touch state the mutator uses unsynchronized; incremental steps
+     * and the allocator then only return the swept cells to the heap.
+     * Minor collections always sweep the young generation directly.
+     *
+     * @param mode Sweep mode.
+     */
+    static void setSweepMode(GCSweepMode mode);
+
+    /**
+     * @brief Selects where destructors of dead objects run.
+     *
+     * Outside Inline mode a sweep only takes a dead object out of the
+     * heap's bitmaps and queues it, so the sweep's pause does not include
+     * user destructors. The object's cell is reused once its destructor has
+     * run. Queued destructors must not touch other collected objects, and
+     * in Background mode they run concurrently with the mutator. Background
+     * sweeping already runs destructors off the mutator and is unaffected.
+     * Switching back to Inline first runs every queued destructor on the
+     * calling thread.
+     *
+     * @param mode Finalization mode.
+     */
+    static void setFinalization(GCFinalization mode);
+
+    /**
+     * @brief Runs queued destructors on the calling thread, e.g. at an idle
+     * point of the application.
+     *
+     * @param budget Time after which no further destructor is started; the
+     *        default runs until the queue is empty.
+     * @return Objects destroyed.
+     */
+    static std::size_t runFinalizers(std::chrono::nanoseconds budget = std::chrono::nanoseconds::max());
+
+    /**
+     * @brief Returns the dead objects whose destructors have not finished.
+     * @return Pending object count.
+     */
+    static std::size_t pendingFinalizers();
+
+    /**
+     * @brief Enables or disables compaction in major collections.
+     *
+     * When enabled, GC::collectNow(true) finishes its sweep and then
+     * empties the sparsest pages of each size class into the free cells of
+     * denser ones, and unmaps the emptied pages. Only objects of
+     * GCMovableType types are moved, since only they are known to be
+     * referenced through GCRef and GCMember slots, which are redirected to
+     * the new copies. A page holding a pinned object, an object of any
+     * other type, or an object waiting for its finalizer stays where it is.
+     *
+     * @param enabled True to compact in every major collection.
+     */
+    static void setCompaction(bool enabled);
+
+    /**
+     * @brief Keeps an object where it is, e.g. while native code holds its
+     * address.
+     *
+     * Pinning stops compaction from moving the object. It does not stop a
+     * movable object from being copied out of the nursery, so pin such an
+     * object once it has survived a collection.
+     *
+     * @param obj Object to pin.
+     */
+    static void pin(GCObject* obj) {
+        if (obj) obj->gcHeader().setFlags(GCHeader::kPinned);
+    }
+
+    /**
+     * @brief Lets compaction move a pinned object again.
+     * @param obj Object to unpin.
+     */
+    static void unpin(GCObject* obj) {
+        if (obj) obj->gcHeader().clearFlags(GCHeader::kPinned);
+    }
+
+    /**
+     * @brief Drives incremental cycles from allocation with a target pause.
+     *
+     * Once a cycle is triggered, its root scan runs at the next
+     * safepoint() poll. Each later allocation then owes a share of the
+     * cycle's mark and sweep work, sized so the cycle finishes within one
+     * allocation threshold's worth of allocations, and GC::make() pays off
+     * the debt with a step of its own. Step budgets are recomputed from
+     * measured step times so a step takes about maxPause. Objects a thread
+     * still needs must be held in a GCRef or GCLocal across GC::make(),
+     * as they must across safepoint().
+     *
+     * @param maxPause Target length of one step; zero turns pacing off.
+     */
+    static void setPauseTarget(std::chrono::microseconds maxPause);
+
+    /**
+     * @brief Replaces the policy that decides when cycles start.
+     *
+     * The new goal is computed from the live bytes of the last major mark.
+     *
+     * @param policy New policy.
+     */
+    static void setHeapPolicy(const GCHeapPolicy& policy);
+
+    /**
+     * @brief Returns the current heap policy.
+     * @return Policy.
+     */
+    static GCHeapPolicy heapPolicy();
+
+    /**
+     * @brief Returns the bytes of heap cells holding objects.
+     *
+     * Includes dead objects not yet swept. Updated in batches per thread, so
+     * it may lag each thread's latest allocations by a few kilobytes.
+     *
+     * @return Bytes in use.
+     */
+    static std::size_t heapBytes();
+
+    /**
+     * @brief Returns the heap size at which the next cycle starts.
+     * @return Goal in bytes; SIZE_MAX if no byte trigger applies.
+     */
+    static std::size_t heapGoal();
+
+    /**
+     * @brief Reads the memory limit of the process's cgroup.
+     *
+     * Tries cgroup v2 memory.max, then cgroup v1 memory.limit_in_bytes.
+     *
+     * @return Limit in bytes, or 0 if there is none or it cannot be read.
+     */
+    static std::size_t cgroupMemoryLimit();
+
+    /**
+     * @brief Takes a snapshot of the collector's counters.
+     *
+     * Stops the world briefly so the counters are consistent.
+     *
+     * @return Statistics since the program started.
+     */
+    static GCStats stats();
+
+    /**
+     * @brief Writes every object, its type, size, generation and outgoing
+     *        references, and the objects held by roots to a binary file.
+     *
+     * Runs with the world stopped. Any incremental cycle and pending sweep
+     * is finished first, and if the nursery holds objects a minor
+     * collection moves the survivors onto heap pages. Old objects that
+     * died since the last major collection are still included; a reader
+     * tells them apart because no root reaches them. The format is described in
+     * GCHeapSnapshot.h, and the gc_analyze tool reports retained sizes and
+     * root paths from it.
+     *
+     * @param path File to create or overwrite.
+     * @return True if the file was written completely.
+     */
+    static bool dumpHeap(const std::string& path);
+
+    /**
+     * @brief Registers a function called when each collection starts and ends.
+     *
+     * Hooks run on the collecting thread while the world is stopped. They
+     * must not allocate collected objects, start or step collections, or
+     * add or remove hooks.
+     *
+     * @param hook Function to call.
+     * @return Id to pass to removeCycleHook().
+     */
+    static int addCycleHook(std::function<void(const GCCycleEvent&)> hook);
+
+    /**
+     * @brief Unregisters a cycle hook.
+     * @param id Id returned by addCycleHook().
+     */
+    static void removeCycleHook(int id);
+
     /**
      * @brief Sets the marking budget.
+     *
+     * With a pause target set, the pacer overrides this after each step.
+     *
      * @param b New mark budget.
      */
     static void setMarkBudget(int b);
 
+    /**
+     * @brief Sets the number of threads that mark during a blocking major
+     * collection, counting the calling thread.
+     *
+     * The default of 1 marks on the calling thread only. With more workers,
+     * trace() and traceChildren() overrides run concurrently and must only
+     * read the object. Incremental steps always mark on the calling thread.
+     *
+     * @param count Worker count; 0 uses one per hardware thread.
+     */
+    static void setMarkWorkers(unsigned count);
+
     /**
      * @brief Sets the sweeping budget.
+     *
+     * With a pause target set, the pacer overrides this after each step.
+     *
      * @param b New sweep budget.
      */
     static void setSweepBudget(int b);
@@ -104,6 +617,93 @@ public:
      * @brief Enables or disables debug output.
      */
     static bool debug;
+
+private:
+    friend class GCThreads;
+
+    /**
+     * @brief Slow path of safepoint().
+     */
+    static void parkAtSafepoint();
+
+    /**
+     * @brief Runs the root scan of a paced cycle from safepoint().
+     */
+    static void scanRootsAtSafepoint();
+
+    /**
+     * @brief Runs the full collection requested by the hard heap limit
+     * from safepoint().
+     */
+    static void collectAtHardLimit();
+
+    /**
+     * @brief Slow path of beforeAllocate().
+     * @param bytes Size of the object.
+     */
+    static void beforeAllocateSlow(std::size_t bytes);
+
+    /**
+     * @brief Recomputes allocationHookActive after the pacer or policy changed.
+     */
+    static void refreshAllocationHook();
+
+    /**
+     * @brief Set once an allocation passed the hard heap limit, until the
+     * next safepoint() collects.
+     */
+    static inline std::atomic<bool> hardLimitPending{false};
+
+    /**
+     * @brief Set while a paced cycle waits for its root scan.
+     */
+    static inline std::atomic<bool> rootScanPending{false};
+
+    /**
+     * @brief Set while a paced cycle is marking or sweeping, or while a
+     * hard heap limit is configured.
+     */
+    static inline std::atomic<bool> allocationHookActive{false};
+
+    /**
+     * @brief Set while a thread is stopping the world.
+     */
+    static inline std::atomic<bool> safepointRequested{false};
+
+    /**
+     * @brief Logs an overwritten reference for the background marker.
+     * @param obj Overwritten object.
+     */
+    static void recordOverwritten(GCObject* obj);
+
+    /**
+     * @brief Shared part of the write barriers, given the owner's cell.
+     * @param ownerPage Page holding the owner.
+     * @param ownerIndex Cell index of the owner.
+     * @param child Referenced child object.
+     */
+    static void cellBarrier(GCPage* ownerPage, std::uint32_t ownerIndex, GCObject* child);
+
+    /**
+     * @brief True while a concurrent cycle is marking from its snapshot.
+     */
+    static inline bool snapshotActive = false;
+};
+
+/**
+ * @class GCSafeRegion
+ * @brief Keeps the current thread in a safe region for its lifetime.
+ */
+class GCSafeRegion {
+public:
+    /** @brief Enters the safe region. */
+    GCSafeRegion() { GC::enterSafeRegion(); }
+
+    /** @brief Leaves the safe region. */
+    ~GCSafeRegion() { GC::leaveSafeRegion(); }
+
+    GCSafeRegion(const GCSafeRegion&) = delete;
+    GCSafeRegion& operator=(const GCSafeRegion&) = delete;
 };
 
 #endif
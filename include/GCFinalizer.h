@@ -0,0 +1,73 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: include/GCFinalizer.h
+// ----------------------------------
+
+#ifndef TERMPROJECT_GCFINALIZER_H
+#define TERMPROJECT_GCFINALIZER_H
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+class GCObject;
+
+/**
+ * @file GCFinalizer.h
+ * @brief Defines the queue of dead objects awaiting their destructors.
+ */
+
+/**
+ * @class GCFinalizer
+ * @brief Runs the destructors of swept objects outside the collector's pauses.
+ *
+ * With deferred finalization the sweep only detaches a dead object from
+ * its cell's bitmaps and queues it; the cell stays reserved until the
+ * object's destructor has run and freed it. The queue is drained in
+ * batches by GC::runFinalizers(), or by a finalizer thread that takes part
+ * in the stop-the-world handshake like any other mutator.
+ */
+class GCFinalizer {
+public:
+    /**
+     * @brief Queues dead objects and empties the given list.
+     *
+     * Called by the collector while it sweeps.
+     *
+     * @param objects Objects whose cells were detached.
+     */
+    static void enqueue(std::vector<GCObject*>& objects);
+
+    /**
+     * @brief Destroys queued objects on the calling thread.
+     * @param budget Time after which no further object is started.
+     * @return Objects destroyed.
+     */
+    static std::size_t run(std::chrono::nanoseconds budget);
+
+    /**
+     * @brief Destroys every queued object and waits for the finalizer
+     * thread to finish the batch it holds.
+     */
+    static void drain();
+
+    /**
+     * @brief Returns the objects queued or being destroyed.
+     * @return Pending object count.
+     */
+    static std::size_t pending();
+
+    /**
+     * @brief Starts or stops feeding the finalizer thread.
+     *
+     * The thread is started the first time this is enabled and then waits
+     * for work for the rest of the program.
+     *
+     * @param enabled True to drain the queue on the finalizer thread.
+     */
+    static void setBackground(bool enabled);
+};
+
+#endif
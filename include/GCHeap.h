@@ -0,0 +1,705 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: include/GCHeap.h
+// ----------------------------------
+
+#ifndef TERMPROJECT_GCHEAP_H
+#define TERMPROJECT_GCHEAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @file GCHeap.h
+ * @brief Defines the segregated size-class allocator backing GCObjects.
+ */
+
+/**
+ * @struct GCFreeCell
+ * @brief Link stored in the first word of every free cell.
+ */
+struct GCFreeCell {
+    GCFreeCell* next;
+};
+
+struct GCAllocCursor;
+
+/**
+ * @struct GCBitmap
+ * @brief One bit per cell of a page.
+ *
+ * Plain accessors are relaxed atomic loads and stores, so mutator threads
+ * can read bits while the one thread allowed to change a word (the page's
+ * allocating thread, the sweeping thread, or the collector with the world
+ * stopped) writes it. Bits that several threads set at once go through
+ * trySetAtomic() and clearAtomic().
+ */
+struct GCBitmap {
+    /** @brief Number of 64-bit words; enough for the smallest size class. */
+    static constexpr std::uint32_t kWords = 60;
+
+    /** @brief Bit storage. */
+    std::uint64_t words[kWords];
+
+    /**
+     * @brief Reads a word.
+     * @param w Word index.
+     * @return Word value.
+     */
+    std::uint64_t load(std::uint32_t w) const {
+        return std::atomic_ref<std::uint64_t>(const_cast<std::uint64_t&>(words[w])).load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Overwrites a word.
+     * @param w Word index.
+     * @param value New word value.
+     */
+    void store(std::uint32_t w, std::uint64_t value) {
+        std::atomic_ref<std::uint64_t>(words[w]).store(value, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Tests a bit.
+     * @param i Cell index.
+     * @return True if set.
+     */
+    bool test(std::uint32_t i) const { return (load(i >> 6) >> (i & 63)) & 1u; }
+
+    /**
+     * @brief Sets a bit.
+     * @param i Cell index.
+     */
+    void set(std::uint32_t i) { store(i >> 6, load(i >> 6) | std::uint64_t{1} << (i & 63)); }
+
+    /**
+     * @brief Clears a bit.
+     * @param i Cell index.
+     */
+    void clear(std::uint32_t i) { store(i >> 6, load(i >> 6) & ~(std::uint64_t{1} << (i & 63))); }
+
+    /**
+     * @brief Clears a bit atomically, safe against other threads setting bits.
+     * @param i Cell index.
+     */
+    void clearAtomic(std::uint32_t i) {
+        std::atomic_ref<std::uint64_t>(words[i >> 6]).fetch_and(~(std::uint64_t{1} << (i & 63)), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Sets a bit atomically, safe against other threads doing the same.
+     * @param i Cell index.
+     * @return True if this call changed the bit from clear to set.
+     */
+    bool trySetAtomic(std::uint32_t i) {
+        std::atomic_ref<std::uint64_t> word(words[i >> 6]);
+        const std::uint64_t bit = std::uint64_t{1} << (i & 63);
+        if (word.load(std::memory_order_relaxed) & bit) return false;
+        return !(word.fetch_or(bit, std::memory_order_relaxed) & bit);
+    }
+
+    /**
+     * @brief Sets a bit atomically, publishing earlier writes to a thread
+     * that reads the word with loadAcquire().
+     * @param i Cell index.
+     */
+    void setRelease(std::uint32_t i) {
+        std::atomic_ref<std::uint64_t>(words[i >> 6]).fetch_or(std::uint64_t{1} << (i & 63), std::memory_order_release);
+    }
+
+    /**
+     * @brief Reads a word atomically.
+     * @param w Word index.
+     * @return Word value.
+     */
+    std::uint64_t loadAcquire(std::uint32_t w) {
+        return std::atomic_ref<std::uint64_t>(words[w]).load(std::memory_order_acquire);
+    }
+};
+
+/**
+ * @struct GCPage
+ * @brief Header at the start of every aligned heap page.
+ *
+ * A small page holds cellCount cells of a single size class. A large page
+ * holds exactly one cell sized for a single oversized object. Any object
+ * pointer can be mapped back to its page with GCHeap::pageOf(), and to its
+ * cell with indexOf(), so the page doubles as the collector's object table.
+ */
+struct GCPage {
+    /** @brief Size class index, or GCHeap::kLargeClass. */
+    std::uint32_t sizeClass;
+
+    /** @brief Bytes per cell. */
+    std::uint32_t cellSize;
+
+    /** @brief Number of cells in the page. */
+    std::uint32_t cellCount;
+
+    /** @brief Cells below this index have been handed out at least once. */
+    std::uint32_t bumpIndex;
+
+    /** @brief Multiplier that turns a cell offset into a cell index. */
+    std::uint32_t cellReciprocal;
+
+    /** @brief Position of this page in GCHeap::pages(). */
+    std::uint32_t pageIndex;
+
+    /** @brief Slot of this page in the table behind GCHeap::isPage(); fixed for the page's lifetime. */
+    std::uint32_t pageId;
+
+    /** @brief Position in the collector's young-page list, or -1. */
+    std::int32_t youngIndex;
+
+    /** @brief True while the page sits in its class's available list. */
+    bool available;
+
+    /** @brief True while the page waits for a lazy sweep; its marks are still live. */
+    bool sweepPending;
+
+    /** @brief True while compaction moves the page's objects to other pages. */
+    bool evacuating;
+
+    /** @brief Bytes mapped for this page. */
+    std::size_t mappedBytes;
+
+    /** @brief Free cells returned by the sweep, or by other threads while a cursor owns the page. */
+    GCFreeCell* freeList;
+
+    /** @brief Cursor currently allocating from the page, or null. */
+    GCAllocCursor* cursor;
+
+    /** @brief Cells holding an object registered with the collector. */
+    GCBitmap allocBits;
+
+    /** @brief Cells holding a young-generation object. */
+    GCBitmap youngBits;
+
+    /** @brief Young cells that have already survived one collection. */
+    GCBitmap agedBits;
+
+    /** @brief Mark color: set once the object is known to be reachable. */
+    GCBitmap markBits;
+
+    /** @brief Old cells recorded in the remembered set. */
+    GCBitmap rememberedBits;
+
+    /**
+     * @brief Returns the number of bitmap words covering this page's cells.
+     * @return Word count.
+     */
+    std::uint32_t bitmapWords() const { return (cellCount + 63) / 64; }
+
+    /**
+     * @brief Returns the address of the first cell.
+     * @return Pointer to cell 0.
+     */
+    char* cells();
+
+    /**
+     * @brief Returns the address of a cell.
+     * @param index Cell index.
+     * @return Pointer to the cell.
+     */
+    char* cellAt(std::uint32_t index) { return cells() + static_cast<std::size_t>(index) * cellSize; }
+
+    /**
+     * @brief Returns the index of the cell containing a pointer.
+     * @param p Pointer into one of this page's cells.
+     * @return Cell index.
+     */
+    std::uint32_t indexOf(const void* p);
+};
+
+/**
+ * @struct GCAllocCursor
+ * @brief Allocation state for the page a size class is currently filling.
+ */
+struct GCAllocCursor {
+    /** @brief Free cells taken over from the current page. */
+    GCFreeCell* freeList = nullptr;
+
+    /** @brief Next never-used cell in the current page. */
+    char* bump = nullptr;
+
+    /** @brief End of the current page's cells. */
+    char* bumpEnd = nullptr;
+
+    /** @brief Page the cursor is allocating from. */
+    GCPage* page = nullptr;
+};
+
+/**
+ * @class GCHeap
+ * @brief Static segregated size-class allocator.
+ *
+ * Small objects are carved out of 64 KiB aligned pages, one size class per
+ * page. Allocation pops the current page's free list or bumps a pointer, and
+ * falls back to allocateSlow() only when the page is exhausted. Objects larger
+ * than kMaxSmallSize form the large-object space: each gets a mapping of its
+ * own, which is unmapped as soon as the object is freed. The collector
+ * treats these objects as old from birth and never moves them.
+ *
+ * Types that opt into moving are bump-allocated in a contiguous nursery
+ * instead. The nursery records object starts in a side bitmap so the
+ * collector can size and forward objects it evacuates, then resets it in
+ * one step.
+ *
+ * Every thread allocates through its own cursors and its own nursery chunk,
+ * so the inline fast paths take no lock. Getting a new page or chunk, and
+ * freeing into a page another thread owns, go through the heap lock.
+ * Functions that walk or reset shared state (clearMarks(), resetNursery(),
+ * retireAllCursors() and friends) require the other threads to be stopped.
+ */
+class GCHeap {
+public:
+    /** @brief Size and alignment of a heap page. */
+    static constexpr std::size_t kPageSize = 64 * 1024;
+
+    /** @brief Bytes reserved at the start of each page for its header. */
+    static constexpr std::size_t kPageHeaderSize = 4096;
+
+    /** @brief Alignment guaranteed for every cell. */
+    static constexpr std::size_t kCellAlign = 16;
+
+    /** @brief Number of small size classes. */
+    static constexpr unsigned kSizeClassCount = 32;
+
+    /** @brief Largest size served from a small size class. */
+    static constexpr std::size_t kMaxSmallSize = 8192;
+
+    /** @brief Size class recorded on pages that hold one large object. */
+    static constexpr unsigned kLargeClass = kSizeClassCount;
+
+    /**
+     * @brief Largest object size. A large object's page, and so its cell,
+     *        must stay below 4 GiB, since cell sizes are stored in 32 bits.
+     */
+    static constexpr std::size_t kMaxLargeSize = (std::uint64_t{1} << 32) - kPageSize - kPageHeaderSize;
+
+    /** @brief Nursery capacity used until setNurserySize() is called. */
+    static constexpr std::size_t kDefaultNurserySize = 1024 * 1024;
+
+    /** @brief Bytes of nursery a thread claims at a time. */
+    static constexpr std::size_t kNurseryChunk = 16 * 1024;
+
+    /**
+     * @struct ThreadHeap
+     * @brief Allocation buffers private to one thread.
+     */
+    struct ThreadHeap {
+        /** @brief Per-class cursors used by the inline fast path. */
+        GCAllocCursor cursors[kSizeClassCount];
+
+        /** @brief Next free byte of the thread's nursery chunk. */
+        char* nurseryTop = nullptr;
+
+        /** @brief End of the thread's nursery chunk. */
+        char* nurseryLimit = nullptr;
+
+        /** @brief True once the heap can reach this buffer to retire it. */
+        bool registered = false;
+    };
+
+    /**
+     * @class Lock
+     * @brief Holds the heap lock; nested locking on one thread is allowed.
+     */
+    class Lock {
+    public:
+        /**
+         * @brief Takes the heap lock unless this thread already holds it.
+         * @param engage If false, does nothing.
+         */
+        explicit Lock(bool engage = true);
+
+        /** @brief Releases the lock if this guard took it. */
+        ~Lock();
+
+        Lock(const Lock&) = delete;
+        Lock& operator=(const Lock&) = delete;
+
+    private:
+        bool held;
+    };
+
+    /**
+     * @brief Returns the cell size of a size class.
+     * @param cls Size class index.
+     * @return Bytes per cell.
+     */
+    static constexpr std::size_t classSize(unsigned cls) {
+        // 16-byte steps up to 128, then four classes per power of two.
+        if (cls < 8) return (cls + 1) * 16;
+        unsigned group = (cls - 8) / 4;
+        unsigned step = (cls - 8) % 4;
+        std::size_t base = std::size_t{128} << group;
+        return base + (step + 1) * (base / 4);
+    }
+
+    /**
+     * @brief Returns the smallest size class that fits a request.
+     * @param size Requested bytes.
+     * @return Size class index, or kLargeClass if the request is too big.
+     */
+    static constexpr unsigned sizeClassFor(std::size_t size) {
+        if (size <= 128) return size == 0 ? 0 : static_cast<unsigned>((size - 1) / 16);
+        for (unsigned cls = 8; cls < kSizeClassCount; ++cls) {
+            if (size <= classSize(cls)) return cls;
+        }
+        return kLargeClass;
+    }
+
+    /**
+     * @brief Allocates raw memory for an object of any size.
+     * @param size Requested bytes.
+     * @return Pointer to uninitialized, kCellAlign-aligned memory.
+     */
+    static void* allocate(std::size_t size) {
+        unsigned cls = sizeClassFor(size);
+        return cls == kLargeClass ? allocateLarge(size) : allocateSmall(cls);
+    }
+
+    /**
+     * @brief Allocates one cell from a small size class.
+     * @param cls Size class index.
+     * @return Pointer to uninitialized memory.
+     */
+    static void* allocateSmall(unsigned cls) {
+        GCAllocCursor& c = local.cursors[cls];
+        if (GCFreeCell* cell = c.freeList) {
+            c.freeList = cell->next;
+            return cell;
+        }
+        if (c.bump < c.bumpEnd) {
+            char* cell = c.bump;
+            c.bump += classSize(cls);
+            return cell;
+        }
+        return allocateSlow(cls);
+    }
+
+    /**
+     * @brief Bump-allocates memory in the nursery.
+     * @param size Requested bytes.
+     * @return Pointer to uninitialized memory, or nullptr if the nursery is
+     *         full, closed or disabled.
+     */
+    static void* allocateNursery(std::size_t size) {
+        size = (size + kCellAlign - 1) & ~(kCellAlign - 1);
+        ThreadHeap& t = local;
+        if (static_cast<std::size_t>(t.nurseryLimit - t.nurseryTop) >= size) {
+            char* p = t.nurseryTop;
+            t.nurseryTop += size;
+            return p;
+        }
+        return allocateNurserySlow(size);
+    }
+
+    /**
+     * @brief Records the start of a nursery object once its GCObject base
+     *        is constructed.
+     *
+     * Until then isNurseryObject() is false, so a constructor that throws
+     * earlier leaves nothing to undo.
+     *
+     * @param p Object start, allocated by this thread.
+     */
+    static void recordNurseryObject(const void* p) {
+        // Chunks are aligned to whole bitmap words and p's chunk belongs to
+        // this thread, so no other thread writes this word.
+        auto granule = static_cast<std::size_t>(static_cast<const char*>(p) - nurseryStart.load(std::memory_order_relaxed))
+                       / kCellAlign;
+        nurseryStarts[granule >> 6] |= std::uint64_t{1} << (granule & 63);
+    }
+
+    /**
+     * @brief Tests whether a pointer lies in the nursery.
+     * @param p Any pointer.
+     * @return True if p is inside the nursery mapping.
+     */
+    static bool inNursery(const void* p) {
+        auto addr = reinterpret_cast<std::uintptr_t>(p);
+        auto start = reinterpret_cast<std::uintptr_t>(nurseryStart.load(std::memory_order_relaxed));
+        return addr - start < nurseryCapacity.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Tests whether any thread has claimed nursery space since the
+     *        nursery was last reset.
+     * @return True if the nursery is non-empty.
+     */
+    static bool nurseryUsed();
+
+    /**
+     * @brief Returns the nursery bytes claimed since it was last reset.
+     *
+     * Includes the unused tails of sealed chunks.
+     *
+     * @return Claimed bytes.
+     */
+    static std::size_t nurseryBytes();
+
+    /**
+     * @brief Tests whether a nursery address is the start of a live allocation.
+     * @param p Nursery pointer.
+     * @return True if an object was recorded at p and not released.
+     */
+    static bool isNurseryObject(const void* p);
+
+    /**
+     * @brief Returns the bytes occupied by a nursery object.
+     * @param p Start of a nursery object.
+     * @return Allocation size, rounded to kCellAlign.
+     */
+    static std::size_t nurseryObjectSize(const void* p);
+
+    /**
+     * @brief Tests whether a nursery object has been evacuated.
+     * @param p Start of a nursery object.
+     * @return True if a forwarding address is installed.
+     */
+    static bool isForwarded(const void* p);
+
+    /**
+     * @brief Returns the new address of an evacuated nursery object.
+     * @param p Start of a forwarded nursery object.
+     * @return Forwarding address.
+     */
+    static void* forwardee(const void* p) { return *static_cast<void* const*>(p); }
+
+    /**
+     * @brief Installs a forwarding address over an evacuated nursery object.
+     * @param p Start of a nursery object.
+     * @param to Address of its copy.
+     */
+    static void setForwarded(void* p, void* to);
+
+    /**
+     * @brief Ends every thread's nursery chunk so that object sizes can be
+     *        read from the start bitmap. Other threads must be stopped.
+     */
+    static void sealNursery();
+
+    /**
+     * @brief Empties the nursery after its survivors have been evacuated.
+     */
+    static void resetNursery();
+
+    /**
+     * @brief Stops nursery allocation until openNursery() is called.
+     *
+     * Seals the nursery first. Other threads must be stopped.
+     */
+    static void closeNursery();
+
+    /**
+     * @brief Resumes nursery allocation.
+     */
+    static void openNursery();
+
+    /**
+     * @brief Sets the nursery capacity; 0 disables the nursery.
+     *
+     * Takes effect only while the nursery is empty.
+     *
+     * @param bytes Capacity in bytes.
+     */
+    static void setNurserySize(std::size_t bytes);
+
+    /**
+     * @brief Allocates a dedicated page for one large object.
+     * @param size Requested bytes.
+     * @return Pointer to uninitialized memory.
+     * @throws std::bad_alloc If size exceeds kMaxLargeSize.
+     */
+    static void* allocateLarge(std::size_t size);
+
+    /**
+     * @brief Returns a cell to its page.
+     *
+     * Small cells go back on their page's free list; large pages are unmapped.
+     * Takes the heap lock unless worldStopped is set.
+     *
+     * @param p Pointer previously returned by allocate().
+     */
+    static void deallocate(void* p);
+
+    /**
+     * @brief Unmaps a page that holds no objects.
+     *
+     * Call with the heap lock held or the world stopped. The page must be
+     * withdrawn, have no cursor, and have no cell still reserved by a
+     * queued finalizer.
+     *
+     * @param page Page to unmap.
+     */
+    static void freePage(GCPage* page);
+
+    /**
+     * @brief Maps an object pointer back to its page header.
+     * @param p Pointer into the first kPageSize bytes of a page.
+     * @return Page header.
+     */
+    static GCPage* pageOf(const void* p) {
+        return reinterpret_cast<GCPage*>(reinterpret_cast<std::uintptr_t>(p) & ~(kPageSize - 1));
+    }
+
+    /**
+     * @brief Tests whether an address is the header of a mapped page.
+     *
+     * pageOf() of an address past the first kPageSize bytes of a large
+     * object lands inside the object's own data. Page ids never move while
+     * their page is mapped, so this is safe without the heap lock.
+     *
+     * @param page Candidate header, usually from pageOf().
+     * @return True if page is a live page header.
+     */
+    static bool isPage(const GCPage* page);
+
+    /**
+     * @brief Tests an object's mark bit.
+     * @param p Object pointer.
+     * @return True if the object is marked.
+     */
+    static bool isMarked(const void* p) {
+        GCPage* page = pageOf(p);
+        return page->markBits.test(page->indexOf(p));
+    }
+
+    /**
+     * @brief Tests whether an object is in the young generation.
+     * @param p Object pointer.
+     * @return True if young.
+     */
+    static bool isYoung(const void* p) {
+        if (inNursery(p)) return true;
+        GCPage* page = pageOf(p);
+        return page->youngBits.test(page->indexOf(p));
+    }
+
+    /**
+     * @brief Sets an object's mark bit.
+     * @param p Object pointer.
+     * @return True if the bit was previously clear.
+     */
+    static bool tryMark(const void* p) {
+        GCPage* page = pageOf(p);
+        std::uint32_t index = page->indexOf(p);
+        if (page->markBits.test(index)) return false;
+        page->markBits.set(index);
+        return true;
+    }
+
+    /**
+     * @brief Sets an object's mark bit; safe to race with other markers.
+     * @param p Object pointer.
+     * @return True if this call marked the object.
+     */
+    static bool tryMarkAtomic(const void* p) {
+        GCPage* page = pageOf(p);
+        return page->markBits.trySetAtomic(page->indexOf(p));
+    }
+
+    /**
+     * @brief Clears the mark bitmap of every page.
+     */
+    static void clearMarks();
+
+    /**
+     * @brief Returns every mapped page, small and large.
+     *
+     * Pages are appended as they are mapped. Releasing a large page moves the
+     * last page into its slot.
+     *
+     * @return Page table.
+     */
+    static const std::vector<GCPage*>& pages();
+
+    /**
+     * @brief Returns the total number of bytes mapped for pages.
+     * @return Mapped bytes.
+     */
+    static std::size_t mappedBytes();
+
+    /**
+     * @brief Hands the calling thread's cursors and nursery chunk back to the
+     *        heap. Called when a thread stops allocating for good.
+     */
+    static void releaseThread();
+
+    /**
+     * @brief Retires the cursors of every thread. Other threads must be stopped.
+     */
+    static void retireAllCursors();
+
+    /**
+     * @brief Takes every page out of the available lists so the allocator
+     *        leaves them alone until releasePage() is called.
+     */
+    static void withdrawPages();
+
+    /**
+     * @brief Puts a withdrawn page back in its class's available list if it
+     *        has free cells. Call with the heap lock held or the world stopped.
+     * @param page Small page that no cursor owns.
+     */
+    static void releasePage(GCPage* page);
+
+    /** @brief Allocation buffers of the calling thread. */
+    static thread_local ThreadHeap local;
+
+    /** @brief First byte of the nursery. */
+    static inline std::atomic<char*> nurseryStart{nullptr};
+
+    /** @brief Bytes mapped for the nursery. */
+    static inline std::atomic<std::size_t> nurseryCapacity{0};
+
+    /** @brief One bit per kCellAlign granule marking object starts. */
+    static inline std::uint64_t* nurseryStarts = nullptr;
+
+    /**
+     * @brief Called by the slow allocation path before it takes another
+     * page for a size class (kLargeClass for large objects).
+     *
+     * The collector installs this to sweep or reclaim pages on demand, so
+     * the cells it frees are reused before new memory is mapped.
+     */
+    static inline void (*refillHook)(unsigned cls) = nullptr;
+
+    /**
+     * @brief Called, without the heap lock, before a thread first takes a
+     * page or a nursery chunk. The collector installs this to learn about
+     * the thread before its buffers become visible to retireAllCursors().
+     */
+    static inline void (*threadHook)() = nullptr;
+
+    /**
+     * @brief Set by the collector while every other thread is parked, so
+     * frees can skip the heap lock and go straight to the owning cursor.
+     */
+    static inline bool worldStopped = false;
+
+private:
+    static void* allocateSlow(unsigned cls);
+    static void* allocateNurserySlow(std::size_t size);
+};
+
+inline thread_local GCHeap::ThreadHeap GCHeap::local;
+
+inline char* GCPage::cells() {
+    return reinterpret_cast<char*>(this) + GCHeap::kPageHeaderSize;
+}
+
+inline std::uint32_t GCPage::indexOf(const void* p) {
+    // Offsets are below 2^16 and cell sizes below 2^14, so a 32-bit
+    // reciprocal multiply is an exact division.
+    auto offset = static_cast<std::uint64_t>(static_cast<const char*>(p) - cells());
+    return static_cast<std::uint32_t>((offset * cellReciprocal) >> 32);
+}
+
+#endif
@@ -0,0 +1,226 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: include/GCHeapSnapshot.h
+// ----------------------------------
+
+#ifndef TERMPROJECT_GCHEAPSNAPSHOT_H
+#define TERMPROJECT_GCHEAPSNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class GCObject;
+
+/**
+ * @file GCHeapSnapshot.h
+ * @brief Defines the binary heap snapshot written by GC::dumpHeap().
+ *
+ * A snapshot is a header followed by fixed-size sections, so a reader can
+ * map the file and index it in place:
+ *
+ * | Section  | Contents                                                  |
+ * |----------|-----------------------------------------------------------|
+ * | header   | GCSnapshotHeader                                          |
+ * | edges    | `uint32_t` object indices, grouped by source object       |
+ * | objects  | GCSnapshotObject, sorted by address                       |
+ * | roots    | `uint32_t` object indices referenced by roots, no repeats |
+ * | types    | GCSnapshotType                                            |
+ * | strings  | type names, not terminated                                |
+ *
+ * Numbers use the byte order of the machine that wrote the file.
+ */
+
+/**
+ * @struct GCSnapshotHeader
+ * @brief First bytes of a snapshot file.
+ */
+struct GCSnapshotHeader {
+    /** @brief Identifies the format. */
+    static constexpr char kMagic[8] = {'G', 'C', 'H', 'E', 'A', 'P', '\0', '\0'};
+
+    /** @brief Format version written by this library. */
+    static constexpr std::uint32_t kVersion = 1;
+
+    /** @brief kMagic. */
+    char magic[8];
+    /** @brief kVersion. */
+    std::uint32_t version;
+    /** @brief sizeof(GCSnapshotObject), so readers can check the layout. */
+    std::uint32_t objectRecordSize;
+    /** @brief Objects in the snapshot. */
+    std::uint64_t objectCount;
+    /** @brief Entries in the edge section. */
+    std::uint64_t edgeCount;
+    /** @brief Entries in the root section. */
+    std::uint64_t rootCount;
+    /** @brief Entries in the type section. */
+    std::uint64_t typeCount;
+    /** @brief Bytes in the string section. */
+    std::uint64_t stringBytes;
+    /** @brief File offset of the edge section. */
+    std::uint64_t edgesOffset;
+    /** @brief File offset of the object section. */
+    std::uint64_t objectsOffset;
+    /** @brief File offset of the root section. */
+    std::uint64_t rootsOffset;
+    /** @brief File offset of the type section. */
+    std::uint64_t typesOffset;
+    /** @brief File offset of the string section. */
+    std::uint64_t stringsOffset;
+};
+
+/**
+ * @struct GCSnapshotObject
+ * @brief One object of a snapshot.
+ */
+struct GCSnapshotObject {
+    /** @brief Flag: the object is in the large-object space. */
+    static constexpr std::uint8_t kLarge = 1;
+    /** @brief Flag: the object's type satisfies GCMovableType. */
+    static constexpr std::uint8_t kMovable = 2;
+    /** @brief Flag: the object was pinned with GC::pin(). */
+    static constexpr std::uint8_t kPinned = 4;
+
+    /** @brief Address of the object when it was dumped. */
+    std::uint64_t address;
+    /** @brief Index of the object's first edge. */
+    std::uint64_t firstEdge;
+    /** @brief Bytes the object occupies: its cell, or its large page. */
+    std::uint32_t size;
+    /** @brief Index into the type section. */
+    std::uint32_t type;
+    /** @brief Number of edges. */
+    std::uint32_t edgeCount;
+    /** @brief 0 for young, 1 for old. */
+    std::uint8_t generation;
+    /** @brief kLarge, kMovable and kPinned bits. */
+    std::uint8_t flags;
+    /** @brief Zero. */
+    std::uint16_t reserved;
+};
+
+/**
+ * @struct GCSnapshotType
+ * @brief One type name of a snapshot.
+ */
+struct GCSnapshotType {
+    /** @brief Offset of the name in the string section. */
+    std::uint64_t nameOffset;
+    /** @brief Length of the name. */
+    std::uint64_t nameLength;
+};
+
+/**
+ * @class GCHeapSnapshot
+ * @brief Writes snapshots, and reads them through a read-only mapping.
+ *
+ * Reading does not copy the file: the accessors return views into the
+ * mapping, which stays valid until the snapshot is closed or destroyed.
+ */
+class GCHeapSnapshot {
+public:
+    /**
+     * @brief Writes a snapshot of every object on the heap's pages.
+     *
+     * The world must be stopped, the sweep finished and the nursery empty.
+     * Each object's edges are found with GCObject::trace().
+     *
+     * @param path File to create or overwrite.
+     * @param roots Objects referenced by roots, in any order, with repeats.
+     * @return True if the file was written completely.
+     */
+    static bool write(const std::string& path, const std::vector<GCObject*>& roots);
+
+    GCHeapSnapshot() = default;
+    ~GCHeapSnapshot() { close(); }
+
+    GCHeapSnapshot(const GCHeapSnapshot&) = delete;
+    GCHeapSnapshot& operator=(const GCHeapSnapshot&) = delete;
+
+    /**
+     * @brief Maps a snapshot file and checks its header and section bounds.
+     * @param path Snapshot file.
+     * @return True on success; otherwise error() says why.
+     */
+    bool open(const std::string& path);
+
+    /** @brief Unmaps the file, if one is open. */
+    void close();
+
+    /**
+     * @brief Describes why the last open() failed.
+     * @return Message, or an empty string.
+     */
+    const std::string& error() const { return message; }
+
+    /**
+     * @brief Returns the objects, sorted by address.
+     * @return Object records.
+     */
+    std::span<const GCSnapshotObject> objects() const { return objectList; }
+
+    /**
+     * @brief Returns the objects one object references.
+     * @param index Object index.
+     * @return Indices of the referenced objects.
+     */
+    std::span<const std::uint32_t> edges(std::size_t index) const {
+        const GCSnapshotObject& o = objectList[index];
+        return edgeList.subspan(o.firstEdge, o.edgeCount);
+    }
+
+    /**
+     * @brief Returns every edge, grouped by source object.
+     * @return Object indices.
+     */
+    std::span<const std::uint32_t> allEdges() const { return edgeList; }
+
+    /**
+     * @brief Returns the objects referenced by roots.
+     * @return Object indices.
+     */
+    std::span<const std::uint32_t> roots() const { return rootList; }
+
+    /**
+     * @brief Returns the name of a type.
+     * @param type Index into the type section, as in GCSnapshotObject::type.
+     * @return Demangled name where the compiler supports it.
+     */
+    std::string_view typeName(std::uint32_t type) const {
+        const GCSnapshotType& t = typeList[type];
+        return {strings + t.nameOffset, t.nameLength};
+    }
+
+    /**
+     * @brief Returns the number of distinct types.
+     * @return Type count.
+     */
+    std::size_t typeCount() const { return typeList.size(); }
+
+    /**
+     * @brief Finds an object by the address it had when it was dumped.
+     * @param address Object address.
+     * @return Object index, or -1 if no object starts there.
+     */
+    std::int64_t find(std::uint64_t address) const;
+
+private:
+    bool fail(const std::string& why);
+
+    void* mapping = nullptr;
+    std::size_t mappedBytes = 0;
+    std::span<const GCSnapshotObject> objectList;
+    std::span<const std::uint32_t> edgeList;
+    std::span<const std::uint32_t> rootList;
+    std::span<const GCSnapshotType> typeList;
+    const char* strings = nullptr;
+    std::string message;
+};
+
+#endif
@@ -0,0 +1,111 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: include/GCMarker.h
+// ----------------------------------
+
+#ifndef TERMPROJECT_GCMARKER_H
+#define TERMPROJECT_GCMARKER_H
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+class GCObject;
+
+/**
+ * @file GCMarker.h
+ * @brief Defines the parallel and background mark phases.
+ */
+
+/**
+ * @class GCMarker
+ * @brief Transitive marking spread across a pool of worker threads.
+ *
+ * Every worker drains a private mark stack and publishes surplus entries to
+ * its own shared deque, which idle workers steal from. Objects are claimed
+ * with an atomic set-if-unmarked on their mark bit, so each object is
+ * scanned by exactly one worker. The calling thread acts as worker 0; with
+ * a single worker no threads are started and marking runs inline.
+ *
+ * trace() and traceChildren() may run on several threads at once and
+ * must only read the object.
+ *
+ * The same class also runs the background marker used by concurrent
+ * cycles: a single collector thread that marks while the mutator runs and
+ * is fed the references the mutator overwrites.
+ */
+class GCMarker {
+public:
+    /**
+     * @brief Sets the number of marking workers, including the caller.
+     * @param count Worker count; 0 uses one per hardware thread.
+     */
+    static void setWorkerCount(unsigned count);
+
+    /**
+     * @brief Returns the number of marking workers.
+     * @return Worker count.
+     */
+    static unsigned workerCount();
+
+    /**
+     * @brief Marks everything reachable from a set of gray objects.
+     *
+     * The gray objects must already be marked. Old objects found pointing
+     * at young ones are appended to pointsYoung so the caller can rebuild
+     * the remembered set; each object appears at most once.
+     *
+     * @param gray Marked objects whose children are not yet scanned; emptied.
+     * @param pointsYoung Receives old objects with young children.
+     * @return Number of objects scanned.
+     */
+    static std::size_t markFrom(std::vector<GCObject*>& gray, std::vector<GCObject*>& pointsYoung);
+
+    /**
+     * @brief Starts marking from a set of gray objects on the collector thread.
+     * @param gray Marked objects whose children are not yet scanned; emptied.
+     */
+    static void startBackground(std::vector<GCObject*>& gray);
+
+    /**
+     * @brief Hands references overwritten by the mutator to the collector thread.
+     *
+     * Each object is marked and traced unless it is already marked.
+     *
+     * @param overwritten Snapshot entries; emptied.
+     */
+    static void shade(std::vector<GCObject*>& overwritten);
+
+    /**
+     * @brief Tests whether the collector thread has run out of work.
+     * @param wait If true, blocks until it has.
+     * @return True if idle.
+     */
+    static bool backgroundIdle(bool wait);
+
+    /**
+     * @brief Ends background marking. The collector thread must be idle.
+     * @return Number of objects the collector thread scanned this cycle.
+     */
+    static std::size_t stopBackground();
+
+    /**
+     * @brief Returns the slots marked through GCTracer::visitRange() by the
+     *        workers and the collector thread since the last call.
+     * @return Slot count.
+     */
+    static std::size_t takeRangeSlots();
+
+    /**
+     * @brief Locks object member lists against the collector thread.
+     *
+     * Returns an unlocked guard when no background marking is running.
+     *
+     * @return Guard to hold while changing an object's member references.
+     */
+    static std::unique_lock<std::mutex> lockGraph();
+};
+
+#endif
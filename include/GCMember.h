@@ -0,0 +1,179 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: include/GCMember.h
+// ----------------------------------
+
+#ifndef TERMPROJECT_GCMEMBER_H
+#define TERMPROJECT_GCMEMBER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "GC.h"
+#include "GCHeap.h"
+#include "GCObject.h"
+
+/**
+ * @file GCMember.h
+ * @brief Defines compact member references found through per-class field maps.
+ */
+
+template <typename T>
+class GCMember;
+
+/**
+ * @struct GCFieldMap
+ * @brief Offsets of the GCMember fields of one class.
+ *
+ * Built once per class by GC_FIELDS() and shared by all its objects.
+ * Offsets are measured from the object's GCObject base.
+ */
+struct GCFieldMap {
+    /** @brief Fields must start below this offset; see GC::writeBarrierAt(). */
+    static constexpr std::size_t kMaxOffset = GCHeap::kPageSize - GCHeap::kPageHeaderSize;
+
+    /** @brief Byte offset of each GCMember field. */
+    std::vector<std::uint32_t> offsets;
+
+    /**
+     * @brief Builds the map for a class from its member pointers.
+     * @param object Any object of the class, used only to take field addresses.
+     * @param base Map of the base class whose fields are included, or nullptr.
+     * @param fields Pointers to the class's GCMember fields.
+     * @return The field map.
+     */
+    template <typename Self, typename... Owners, typename... Targets>
+    static GCFieldMap of(const Self* object, const GCFieldMap* base, GCMember<Targets> Owners::*... fields) {
+        GCFieldMap map;
+        if (base) map.offsets = base->offsets;
+        const char* start = reinterpret_cast<const char*>(static_cast<const GCObject*>(object));
+        (map.add(reinterpret_cast<const char*>(&(object->*fields)) - start), ...);
+        return map;
+    }
+
+private:
+    void add(std::ptrdiff_t offset) {
+        offsets.push_back(static_cast<std::uint32_t>(offset));
+    }
+};
+
+/**
+ * @brief Declares the GCMember fields of a class.
+ *
+ * Place it in the class body with a member pointer per field, e.g.
+ * `GC_FIELDS(&Node::left, &Node::right)`. It overrides
+ * GCObject::fieldMap() and leaves the access level public.
+ */
+#define GC_FIELDS(...)                                                              \
+public:                                                                             \
+    const GCFieldMap* fieldMap() const override {                                   \
+        static const GCFieldMap map = GCFieldMap::of(this, nullptr, __VA_ARGS__);   \
+        return &map;                                                                \
+    }
+
+/**
+ * @brief Declares the GCMember fields a class adds to those of its base.
+ *
+ * Use instead of GC_FIELDS() when a base class already declares fields,
+ * e.g. `GC_DERIVED_FIELDS(Node, &Leaf::extra)`.
+ */
+#define GC_DERIVED_FIELDS(Base, ...)                                                     \
+public:                                                                                  \
+    const GCFieldMap* fieldMap() const override {                                        \
+        static const GCFieldMap map = GCFieldMap::of(this, Base::fieldMap(), __VA_ARGS__); \
+        return &map;                                                                     \
+    }
+
+/**
+ * @class GCMember
+ * @brief Pointer-sized member reference of a GCObject.
+ *
+ * A GCMember holds nothing but the pointer. The collector finds it through
+ * the class's GC_FIELDS() map, and the write barrier finds the owning
+ * object from the field's own address, so creating or destroying one costs
+ * nothing beyond the store. A GCMember may only be a field of a GCObject
+ * created by the collector; use GCRef or GCLocal anywhere else. It must
+ * lie within GCFieldMap::kMaxOffset bytes of the object's start; storing an
+ * object into one further in throws std::length_error.
+ *
+ * @tparam T Type of object referenced; must inherit from GCObject.
+ */
+template <typename T>
+class GCMember {
+    static_assert(std::is_convertible<T*, GCObject*>::value,
+                  "T must inherit GCObject");
+
+public:
+    /**
+     * @brief Constructs a member reference.
+     * @param p Referenced object, or nullptr.
+     */
+    GCMember(T* p = nullptr) {
+        store(static_cast<GCObject*>(p));
+        if (p) GC::writeBarrierAt(&obj, obj);
+    }
+
+    /**
+     * @brief Constructs a member reference to another member's object.
+     * @param other Member to copy.
+     */
+    GCMember(const GCMember& other) : GCMember(other.get()) {}
+
+    /**
+     * @brief Points this member at another object.
+     * @param p New referenced object, or nullptr.
+     * @return *this
+     */
+    GCMember& operator=(T* p) {
+        GC::deletionBarrier(load());
+        store(static_cast<GCObject*>(p));
+        if (p) GC::writeBarrierAt(&obj, obj);
+        return *this;
+    }
+
+    /**
+     * @brief Points this member at another member's object.
+     * @param other Member to copy.
+     * @return *this
+     */
+    GCMember& operator=(const GCMember& other) { return *this = other.get(); }
+
+    /**
+     * @brief Returns the referenced object.
+     * @return Pointer to the object, or nullptr.
+     */
+    T* get() const { return static_cast<T*>(load()); }
+
+    /** @brief Member access. */
+    T* operator->() const { return get(); }
+
+    /** @brief Dereference. */
+    T& operator*() const { return *get(); }
+
+    /**
+     * @brief Checks whether the reference is non-null.
+     * @return True if non-null.
+     */
+    explicit operator bool() const { return load() != nullptr; }
+
+private:
+    // The background marker reads fields while the mutator writes them.
+    GCObject* load() const {
+        return std::atomic_ref<GCObject*>(const_cast<GCObject*&>(obj)).load(std::memory_order_relaxed);
+    }
+
+    void store(GCObject* p) {
+        std::atomic_ref<GCObject*>(obj).store(p, std::memory_order_relaxed);
+    }
+
+    GCObject* obj;
+};
+
+static_assert(sizeof(GCMember<GCObject>) == sizeof(void*), "GCMember must stay pointer-sized");
+
+#endif
@@ -8,9 +8,15 @@
 #ifndef TERMPROJECT_GCOBJECT_H
 #define TERMPROJECT_GCOBJECT_H
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
 #include <vector>
 
 class GCRefBase;
+class GCTracer;
+struct GCFieldMap;
 
 /**
  * @file GCObject.h
@@ -24,35 +30,134 @@ class GCRefBase;
 enum class Generation { Young, Old };
 
 /**
- * @class GCObject
- * @brief Base class for all garbage-collector-managed objects.
+ * @brief Satisfied by GCObject types that opt into the copying nursery.
  *
- * Derived classes may either override traceChildren() to explicitly
- * expose child objects, or declare GCRef<T> member fields, which are
- * automatically discovered by the garbage collector.
+ * A type opts in by declaring `static constexpr bool gcMovable = true;`.
+ * Movable objects created with GC::make<T>() are bump-allocated in the
+ * nursery and copied with memcpy when they survive a collection, so they
+ * must:
+ * - not hold pointers into themselves (other than member GCRefs),
+ * - not hold root GCRefs (every GCRef member needs an owner),
+ * - tolerate their destructor being skipped if they die in the nursery,
+ * - be referenced only through GCRef slots across collections, because
+ *   raw pointers are not updated when the object moves.
  */
-class GCObject {
+template <typename T>
+concept GCMovableType = requires { requires T::gcMovable; };
+
+/**
+ * @struct GCMemberRefList
+ * @brief Out-of-line list of the member GCRefs registered with one object.
+ *
+ * Allocated on the first addMemberRef(), so objects without member GCRefs
+ * carry no list at all.
+ */
+struct GCMemberRefList {
+    /** @brief Entries in use. */
+    std::uint32_t size;
+
+    /** @brief Entries allocated. */
+    std::uint32_t capacity;
+
+    /**
+     * @brief Returns the entries, which follow the list header in memory.
+     * @return Pointer to the first entry.
+     */
+    GCRefBase** refs() { return reinterpret_cast<GCRefBase**>(this + 1); }
+};
+
+/**
+ * @class GCHeader
+ * @brief The single word every GCObject carries after its vtable pointer.
+ *
+ * Color, age and generation live in side bitmaps on the object's heap page
+ * and the size class in the page header, so the collector reads and resets
+ * them a word of cells at a time without touching the object. The header
+ * packs what is left: the member GCRef list in the low 48 bits and flag
+ * bits in the high 16. Flag updates are atomic so the collector and the
+ * owning thread may change different bits at once.
+ */
+class GCHeader {
 public:
+    /** @brief Position of the first flag bit. */
+    static constexpr unsigned kFlagShift = 48;
+
+    /** @brief Bits holding the member GCRef list pointer. */
+    static constexpr std::uint64_t kPointerMask = (std::uint64_t{1} << kFlagShift) - 1;
+
+    /** @brief Flag: the object's type satisfies GCMovableType. */
+    static constexpr std::uint16_t kMovable = 1;
+
+    /** @brief Flag: the object was pinned with GC::pin(). */
+    static constexpr std::uint16_t kPinned = 2;
+
+    /**
+     * @brief Returns the member GCRef list.
+     * @return List, or nullptr if none was allocated.
+     */
+    GCMemberRefList* memberRefs() const {
+        return reinterpret_cast<GCMemberRefList*>(load() & kPointerMask);
+    }
+
     /**
-     * @brief Indicates whether the object has been marked during GC.
+     * @brief Replaces the member GCRef list, keeping the flags.
+     * @param list New list, or nullptr.
      */
-    bool marked = false;
+    void setMemberRefs(GCMemberRefList* list) {
+        auto bits = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(list));
+        std::atomic_ref<std::uint64_t> ref(word);
+        std::uint64_t old = ref.load(std::memory_order_relaxed);
+        while (!ref.compare_exchange_weak(old, (old & ~kPointerMask) | bits, std::memory_order_relaxed)) {}
+    }
 
     /**
-     * @brief Indicates whether the object has been fully scanned.
+     * @brief Returns the flag bits.
+     * @return Flags.
      */
-    bool black = false;
+    std::uint16_t flags() const { return static_cast<std::uint16_t>(load() >> kFlagShift); }
 
     /**
-     * @brief Number of GC cycles the object has survived.
+     * @brief Sets flag bits.
+     * @param mask Bits to set.
      */
-    int survivalCount = 0;
+    void setFlags(std::uint16_t mask) {
+        std::atomic_ref<std::uint64_t>(word).fetch_or(std::uint64_t{mask} << kFlagShift, std::memory_order_relaxed);
+    }
 
     /**
-     * @brief Current generational state of the object.
+     * @brief Sets flag bits of an object no other thread can see yet.
+     * @param mask Bits to set.
      */
-    Generation generation = Generation::Young;
+    void initFlags(std::uint16_t mask) { word |= std::uint64_t{mask} << kFlagShift; }
 
+    /**
+     * @brief Clears flag bits.
+     * @param mask Bits to clear.
+     */
+    void clearFlags(std::uint16_t mask) {
+        std::atomic_ref<std::uint64_t>(word).fetch_and(~(std::uint64_t{mask} << kFlagShift), std::memory_order_relaxed);
+    }
+
+private:
+    std::uint64_t load() const {
+        return std::atomic_ref<std::uint64_t>(const_cast<std::uint64_t&>(word)).load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t word = 0;
+};
+
+/**
+ * @class GCObject
+ * @brief Base class for all garbage-collector-managed objects.
+ *
+ * Derived classes may declare GCMember<T> fields listed with GC_FIELDS(),
+ * or GCRef<T> member fields, which register themselves with the object.
+ * Both are discovered by the garbage collector. A class may also override
+ * trace() to expose further children. Overriding traceChildren() still
+ * works but goes through a list per object.
+ */
+class GCObject {
+public:
     /**
      * @brief Constructs a GC-managed object.
      */
@@ -63,16 +168,98 @@ public:
      */
     virtual ~GCObject();
 
+    /**
+     * @brief Returns the generation the object currently belongs to.
+     *
+     * Color and age are kept in side bitmaps on the object's heap page so
+     * the collector never has to touch live objects to read or reset them.
+     *
+     * @return Young or Old.
+     */
+    Generation generation() const;
+
+    /**
+     * @brief Allocates storage for a GC-managed object from the size-class heap.
+     * @param size Size of the most-derived object.
+     * @return Pointer to uninitialized storage.
+     */
+    static void* operator new(std::size_t size);
+
+    /**
+     * @brief Returns the storage of an object whose constructor threw.
+     *
+     * Dead objects are destroyed and freed by the collector, never with
+     * delete.
+     *
+     * @param p Pointer previously returned by operator new.
+     */
+    static void operator delete(void* p) noexcept;
+
+    /**
+     * @brief Arrays of GC-managed objects are not supported.
+     */
+    static void* operator new[](std::size_t) = delete;
+
+    /**
+     * @brief Arrays of GC-managed objects are not supported.
+     */
+    static void operator delete[](void*) = delete;
+
+    /**
+     * @brief Reports every child object to a tracer.
+     *
+     * This is what the collector calls. The default implementation reports
+     * the GC_FIELDS() fields, then forwards to traceChildren(), so types
+     * that override only that keep working. An override should call
+     * traceMembers() for the GCMember and GCRef members and tracer.visit()
+     * for anything else, and must only read the object.
+     *
+     * @param tracer Visitor receiving the children.
+     */
+    virtual void trace(GCTracer& tracer) const;
+
     /**
      * @brief Traces child objects for garbage collection.
      *
-     * The default implementation discovers children through
-     * member GCRef instances.
+     * Kept for compatibility; prefer overriding trace(). The default
+     * implementation discovers children through member GCRef instances.
+     * GCMember fields are reported by trace() and never appear here.
      *
      * @param out Vector to receive child objects.
      */
     virtual void traceChildren(std::vector<GCObject*>& out) const;
 
+    /**
+     * @brief Returns the offsets of the object's GCMember fields.
+     *
+     * Overridden by GC_FIELDS(); the map is built once per class.
+     *
+     * @return Field map, or nullptr if the class declares no fields.
+     */
+    virtual const GCFieldMap* fieldMap() const { return nullptr; }
+
+    /**
+     * @brief Calls a function on the slot of every member reference.
+     *
+     * Covers GCMember fields, member GCRefs and the slots reported by
+     * visitExtraSlots(), so the collector can redirect them when it moves
+     * the objects they point at.
+     *
+     * @param visit Function receiving each slot.
+     */
+    void visitMemberSlots(void (*visit)(GCObject**));
+
+    /**
+     * @brief Calls a function on reference slots outside GCMember fields
+     *        and member GCRefs.
+     *
+     * Overridden by containers such as GCVector whose trace() reports
+     * children from their own storage. The default reports nothing.
+     *
+     * @param visit Function receiving each slot.
+     */
+    virtual void visitExtraSlots([[maybe_unused]] void (*visit)(GCObject**)) {}
+
     /**
      * @brief Registers a GCRef as a member reference.
      * @param r Pointer to the member reference.
@@ -87,12 +274,43 @@ public:
 
     /**
      * @brief Returns all registered member references.
-     * @return Vector of GCRefBase pointers.
+     * @return Member GCRefs, in no particular order.
+     */
+    std::span<GCRefBase* const> getMemberRefs() const;
+
+    /**
+     * @brief Returns the object's header word.
+     * @return Header.
+     */
+    GCHeader& gcHeader() { return header; }
+
+    /**
+     * @brief Repairs member references after the collector moved this object.
+     *
+     * Member GCRefs were copied along with the object, so their addresses
+     * and owner pointers still refer to the old location.
+     *
+     * @param from Address the object was copied from.
      */
-    const std::vector<GCRefBase*>& getMemberRefs() const;
+    void relocateMemberRefs(const GCObject* from);
+
+    /**
+     * @brief Frees member-reference storage of an object that died in the
+     *        nursery without running its destructor.
+     */
+    void releaseMemberRefs();
+
+protected:
+    /**
+     * @brief Reports the objects referenced by GCMember fields and member GCRefs.
+     * @param tracer Visitor receiving the children.
+     */
+    void traceMembers(GCTracer& tracer) const;
 
 private:
-    std::vector<GCRefBase*> memberRefs;
+    void traceFields(GCTracer& tracer) const;
+
+    GCHeader header;
 };
 
 #endif
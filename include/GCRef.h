@@ -8,7 +8,7 @@
 #ifndef TERMPROJECT_GCREF_H
 #define TERMPROJECT_GCREF_H
 
-#include <utility>
+#include <cstddef>
 #include <type_traits>
 
 #include "GCObject.h"
@@ -36,12 +36,12 @@ class GCRef : public GCRefBase {
     static_assert(std::is_convertible<T*, GCObject*>::value,
                   "T must inherit GCObject");
 
-    T* ptr = nullptr;
-    GCObject* owner = nullptr;
     bool registeredRoot = false;
 
+    static GCObject* toObject(T* p) { return static_cast<GCObject*>(p); }
+
     void registerRootIfNeeded() {
-        if (!owner && ptr && !registeredRoot) {
+        if (!owner && obj && !registeredRoot) {
             GC::registerRoot(this);
             registeredRoot = true;
         }
@@ -68,7 +68,8 @@ public:
      * @brief Constructs a root GCRef.
      * @param p Pointer to the managed object.
      */
-    explicit GCRef(T* p = nullptr) : ptr(p), owner(nullptr), registeredRoot(false) {
+    explicit GCRef(T* p = nullptr) : registeredRoot(false) {
+        store(toObject(p));
         registerRootIfNeeded();
     }
 
@@ -77,11 +78,12 @@ public:
      * @param owner_ Owning GCObject.
      * @param p Pointer to the managed object.
      */
-    GCRef(GCObject* owner_, T* p = nullptr)
-        : ptr(p), owner(owner_), registeredRoot(false) {
+    GCRef(GCObject* owner_, T* p = nullptr) : registeredRoot(false) {
+        store(toObject(p));
+        owner = owner_;
         if (owner) {
             owner->addMemberRef(this);
-            GC::writeBarrier(owner, static_cast<GCObject*>(ptr));
+            GC::writeBarrier(owner, obj);
         } else {
             registerRootIfNeeded();
         }
@@ -91,12 +93,13 @@ public:
      * @brief Copy constructor.
      * @param other Reference to copy.
      */
-    GCRef(const GCRef& other)
-        : ptr(other.ptr), owner(other.owner), registeredRoot(false) {
+    GCRef(const GCRef& other) : registeredRoot(false) {
+        store(other.obj);
+        owner = other.owner;
         if (owner) {
             owner->addMemberRef(this);
-            if (ptr) {
-                GC::writeBarrier(owner, static_cast<GCObject*>(ptr));
+            if (obj) {
+                GC::writeBarrier(owner, obj);
             }
         } else {
             registerRootIfNeeded();
@@ -107,15 +110,16 @@ public:
      * @brief Move constructor.
      * @param other Reference to move from.
      */
-    GCRef(GCRef&& other) noexcept
-        : ptr(std::exchange(other.ptr, nullptr)),
-          owner(std::exchange(other.owner, nullptr)),
-          registeredRoot(false) {
+    GCRef(GCRef&& other) noexcept : registeredRoot(false) {
         other.unregisterRootIfNeeded();
+        store(other.obj);
+        other.store(nullptr);
+        if (other.owner) other.owner->removeMemberRef(&other);
+        owner = std::exchange(other.owner, nullptr);
         if (owner) {
             owner->addMemberRef(this);
-            if (ptr) {
-                GC::writeBarrier(owner, static_cast<GCObject*>(ptr));
+            if (obj) {
+                GC::writeBarrier(owner, obj);
             }
         } else {
             registerRootIfNeeded();
@@ -138,14 +142,15 @@ public:
      * @brief Nulls the reference if it points to the specified object.
      * @param obj Object being checked or collected.
      */
-    void nullIfPointsTo(GCObject* obj) override {
-        if (ptr == obj) {
+    void nullIfPointsTo(GCObject* target) override {
+        if (obj == target) {
             if (owner) {
-                ptr = nullptr;
+                GC::deletionBarrier(obj);
+                store(nullptr);
                 GC::writeBarrier(owner, nullptr);
             } else {
                 unregisterRootIfNeeded();
-                ptr = nullptr;
+                store(nullptr);
             }
         }
     }
@@ -157,14 +162,15 @@ public:
      */
     GCRef& operator=(const GCRef& other) {
         if (this == &other) return *this;
+        if (owner) GC::deletionBarrier(obj);
         detachOwnerOrRoot();
-        ptr = other.ptr;
+        store(other.obj);
         owner = other.owner;
         registeredRoot = false;
         if (owner) {
             owner->addMemberRef(this);
-            if (ptr) {
-                GC::writeBarrier(owner, static_cast<GCObject*>(ptr));
+            if (obj) {
+                GC::writeBarrier(owner, obj);
             }
         } else {
             registerRootIfNeeded();
@@ -179,15 +185,18 @@ public:
      */
     GCRef& operator=(GCRef&& other) noexcept {
         if (this == &other) return *this;
+        if (owner) GC::deletionBarrier(obj);
         detachOwnerOrRoot();
-        ptr = std::exchange(other.ptr, nullptr);
-        owner = std::exchange(other.owner, nullptr);
         other.unregisterRootIfNeeded();
+        store(other.obj);
+        other.store(nullptr);
+        if (other.owner) other.owner->removeMemberRef(&other);
+        owner = std::exchange(other.owner, nullptr);
         registeredRoot = false;
         if (owner) {
             owner->addMemberRef(this);
-            if (ptr) {
-                GC::writeBarrier(owner, static_cast<GCObject*>(ptr));
+            if (obj) {
+                GC::writeBarrier(owner, obj);
             }
         } else {
             registerRootIfNeeded();
@@ -202,11 +211,12 @@ public:
      */
     GCRef& operator=(T* o) {
         if (owner) {
-            ptr = o;
-            GC::writeBarrier(owner, static_cast<GCObject*>(ptr));
+            GC::deletionBarrier(obj);
+            store(toObject(o));
+            GC::writeBarrier(owner, obj);
         } else {
             unregisterRootIfNeeded();
-            ptr = o;
+            store(toObject(o));
             registerRootIfNeeded();
         }
         return *this;
@@ -218,11 +228,12 @@ public:
      */
     GCRef& operator=(std::nullptr_t) {
         if (owner) {
-            ptr = nullptr;
+            GC::deletionBarrier(obj);
+            store(nullptr);
             GC::writeBarrier(owner, nullptr);
         } else {
             unregisterRootIfNeeded();
-            ptr = nullptr;
+            store(nullptr);
         }
         return *this;
     }
@@ -231,32 +242,32 @@ public:
      * @brief Dereferences the managed object.
      * @return Reference to the managed object.
      */
-    T& operator*() const { return *ptr; }
+    T& operator*() const { return *get(); }
 
     /**
      * @brief Accesses the managed object.
      * @return Pointer to the managed object.
      */
-    T* operator->() const { return ptr; }
+    T* operator->() const { return get(); }
 
     /**
      * @brief Checks whether the reference is non-null.
      * @return True if non-null, false otherwise.
      */
-    explicit operator bool() const { return ptr != nullptr; }
+    explicit operator bool() const { return obj != nullptr; }
 
     /**
      * @brief Returns the raw pointer.
      * @return Pointer to the managed object.
      */
-    T* get() const { return ptr; }
+    T* get() const { return static_cast<T*>(obj); }
 
     /**
      * @brief Returns the referenced object as a GCObject.
      * @return Pointer to the GCObject.
      */
     GCObject* getObject() const override {
-        return static_cast<GCObject*>(ptr);
+        return load();
     }
 };
 
@@ -8,7 +8,10 @@
 #ifndef TERMPROJECT_GCREFBASE_H
 #define TERMPROJECT_GCREFBASE_H
 
+#include <atomic>
+
 class GCObject;
+struct GCThreadState;
 
 /**
  * @file GCRefBase.h
@@ -41,6 +44,62 @@ public:
      * @brief Virtual destructor for safe polymorphic deletion.
      */
     virtual ~GCRefBase() = default;
+
+    /**
+     * @brief Returns the address of the stored object pointer.
+     *
+     * Used by the collector to redirect the reference when the object it
+     * points to is moved.
+     *
+     * @return Slot holding the referenced GCObject.
+     */
+    GCObject** slot() { return &obj; }
+
+protected:
+    /**
+     * @brief Referenced object, stored as its GCObject base.
+     */
+    GCObject* obj = nullptr;
+
+    /**
+     * @brief Reads the referenced object.
+     *
+     * The background marker reads references while the mutator writes them,
+     * so both sides go through a relaxed atomic access.
+     *
+     * @return Referenced object.
+     */
+    GCObject* load() const {
+        return std::atomic_ref<GCObject*>(const_cast<GCObject*&>(obj)).load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Writes the referenced object.
+     * @param p New referenced object.
+     */
+    void store(GCObject* p) {
+        std::atomic_ref<GCObject*>(obj).store(p, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Owning object for member references; nullptr for roots.
+     */
+    GCObject* owner = nullptr;
+
+private:
+    friend class GC;
+    friend class GCObject;
+    friend class GCTracer;
+
+    /**
+     * @brief Thread whose root table holds this reference, or nullptr.
+     */
+    GCThreadState* rootThread = nullptr;
+
+    /**
+     * @brief Slot in that thread's root table, or -1 when not a root.
+     */
+    int rootIndex = -1;
 };
 
 #endif
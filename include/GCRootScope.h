@@ -0,0 +1,187 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: include/GCRootScope.h
+// ----------------------------------
+
+#ifndef TERMPROJECT_GCROOTSCOPE_H
+#define TERMPROJECT_GCROOTSCOPE_H
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+class GCObject;
+
+/**
+ * @file GCRootScope.h
+ * @brief Defines scoped stack roots backed by a per-thread shadow stack.
+ */
+
+/**
+ * @struct GCShadowStack
+ * @brief Per-thread stack of root slots, grown in fixed-size segments.
+ *
+ * Segments are never moved, so a slot address stays valid until the scope
+ * that pushed it ends. The collector scans every thread's segments while
+ * the world is stopped.
+ */
+struct GCShadowStack {
+    /** @brief Slots per segment. */
+    static constexpr std::size_t kSegmentSlots = 1024;
+
+    /**
+     * @struct Segment
+     * @brief One contiguous block of slots.
+     */
+    struct Segment {
+        /** @brief Root slots; must stay the first member. */
+        GCObject* slots[kSegmentSlots];
+
+        /** @brief Next segment, kept for reuse after its scopes end. */
+        Segment* next;
+    };
+
+    /** @brief Next free slot in the current segment. */
+    GCObject** top = nullptr;
+
+    /** @brief End of the current segment. */
+    GCObject** limit = nullptr;
+
+    /** @brief First segment, or nullptr before the first push. */
+    Segment* first = nullptr;
+
+    /** @brief Number of open GCRootScopes on this thread. */
+    int scopes = 0;
+
+    /**
+     * @brief Returns the segment top points into.
+     * @return Current segment, or nullptr before the first push.
+     */
+    Segment* current() const {
+        return limit ? reinterpret_cast<Segment*>(limit - kSegmentSlots) : nullptr;
+    }
+};
+
+/**
+ * @class GCRootScope
+ * @brief Releases every GCLocal created on this thread during its lifetime.
+ *
+ * Entering and leaving a scope saves and restores the top of the shadow
+ * stack; creating a GCLocal stores a pointer and bumps the top. Nothing is
+ * registered with the collector, which scans the shadow stacks as roots.
+ * Use GCRef roots for references that outlive a scope.
+ */
+class GCRootScope {
+public:
+    /** @brief Opens a scope on the calling thread. */
+    GCRootScope() : savedTop(stack.top), savedLimit(stack.limit) { ++stack.scopes; }
+
+    /** @brief Pops every local pushed since the scope opened. */
+    ~GCRootScope() {
+        stack.top = savedTop;
+        stack.limit = savedLimit;
+        --stack.scopes;
+    }
+
+    GCRootScope(const GCRootScope&) = delete;
+    GCRootScope& operator=(const GCRootScope&) = delete;
+
+    /**
+     * @brief Pushes a root slot onto the calling thread's shadow stack.
+     * @param obj Initial slot value.
+     * @return Address of the slot.
+     */
+    static GCObject** push(GCObject* obj) {
+        assert(stack.scopes > 0 && "GCLocal created outside a GCRootScope");
+        if (stack.top == stack.limit) grow();
+        GCObject** slot = stack.top++;
+        *slot = obj;
+        return slot;
+    }
+
+    /** @brief Shadow stack of the calling thread. */
+    static thread_local GCShadowStack stack;
+
+private:
+    /**
+     * @brief Moves the top into the next segment, allocating it if needed.
+     */
+    static void grow();
+
+    GCObject** savedTop;
+    GCObject** savedLimit;
+};
+
+inline thread_local GCShadowStack GCRootScope::stack;
+
+/**
+ * @class GCLocal
+ * @brief Stack root that lives until the enclosing GCRootScope ends.
+ *
+ * A GCLocal is a pointer to a shadow-stack slot. Copies take a slot of
+ * their own. The collector may redirect the slot when it moves the object,
+ * so read the object through the GCLocal rather than caching a raw pointer
+ * across a collection.
+ *
+ * @tparam T Type of object referenced; must inherit from GCObject.
+ */
+template <typename T>
+class GCLocal {
+    static_assert(std::is_convertible<T*, GCObject*>::value,
+                  "T must inherit GCObject");
+
+public:
+    /**
+     * @brief Pushes a new root slot.
+     * @param p Referenced object, or nullptr.
+     */
+    GCLocal(T* p = nullptr) : slot(GCRootScope::push(static_cast<GCObject*>(p))) {}
+
+    /**
+     * @brief Pushes a new root slot referencing the same object.
+     * @param other Local to copy.
+     */
+    GCLocal(const GCLocal& other) : slot(GCRootScope::push(*other.slot)) {}
+
+    /**
+     * @brief Points this local at another object.
+     * @param p New referenced object.
+     * @return *this
+     */
+    GCLocal& operator=(T* p) {
+        *slot = static_cast<GCObject*>(p);
+        return *this;
+    }
+
+    /**
+     * @brief Points this local at another local's object.
+     * @param other Local to copy.
+     * @return *this
+     */
+    GCLocal& operator=(const GCLocal& other) {
+        *slot = *other.slot;
+        return *this;
+    }
+
+    /**
+     * @brief Returns the referenced object.
+     * @return Pointer to the object, or nullptr.
+     */
+    T* get() const { return static_cast<T*>(*slot); }
+
+    /** @brief Converts to a raw pointer, e.g. to assign a GCRef member. */
+    operator T*() const { return get(); }
+
+    /** @brief Member access. */
+    T* operator->() const { return get(); }
+
+    /** @brief Dereference. */
+    T& operator*() const { return *get(); }
+
+private:
+    GCObject** slot;
+};
+
+#endif
@@ -0,0 +1,258 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: include/GCStats.h
+// ----------------------------------
+
+#ifndef TERMPROJECT_GCSTATS_H
+#define TERMPROJECT_GCSTATS_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file GCStats.h
+ * @brief Defines the collector's statistics snapshot and cycle events.
+ */
+
+/**
+ * @struct GCPauseHistogram
+ * @brief Log-linear histogram of pause lengths.
+ *
+ * Each power of two of nanoseconds is split into four buckets, so a
+ * percentile is accurate to within 25% while the whole histogram stays a
+ * fixed 2 KiB.
+ */
+struct GCPauseHistogram {
+    /** @brief Buckets per power of two. */
+    static constexpr unsigned kSubBuckets = 4;
+
+    /** @brief Number of buckets; covers every 64-bit nanosecond count. */
+    static constexpr unsigned kBuckets = 63 * kSubBuckets;
+
+    /** @brief Pauses per bucket. */
+    std::array<std::uint64_t, kBuckets> counts{};
+
+    /** @brief Number of pauses recorded. */
+    std::uint64_t count = 0;
+
+    /** @brief Sum of all pauses. */
+    std::chrono::nanoseconds total{0};
+
+    /** @brief Longest pause. */
+    std::chrono::nanoseconds max{0};
+
+    /**
+     * @brief Adds one pause.
+     * @param pause Length of the pause.
+     */
+    void record(std::chrono::nanoseconds pause) {
+        auto ns = static_cast<std::uint64_t>(std::max<std::int64_t>(pause.count(), 0));
+        ++counts[bucketOf(ns)];
+        ++count;
+        total += pause;
+        max = std::max(max, pause);
+    }
+
+    /**
+     * @brief Returns the pause length below which a fraction of pauses fall.
+     * @param fraction Fraction between 0 and 1, e.g. 0.99 for p99.
+     * @return Upper bound of the bucket holding that pause, capped at max;
+     *         zero if nothing was recorded.
+     */
+    std::chrono::nanoseconds percentile(double fraction) const {
+        if (count == 0) return std::chrono::nanoseconds{0};
+        auto rank = static_cast<std::uint64_t>(fraction * static_cast<double>(count));
+        rank = std::clamp<std::uint64_t>(rank, 1, count);
+        std::uint64_t seen = 0;
+        for (unsigned b = 0; b < kBuckets; ++b) {
+            seen += counts[b];
+            if (seen >= rank) {
+                auto limit = static_cast<std::int64_t>(bucketLimit(b) - 1);
+                return std::min(std::chrono::nanoseconds{limit}, max);
+            }
+        }
+        return max;
+    }
+
+    /**
+     * @brief Returns the bucket a pause falls into.
+     * @param ns Pause in nanoseconds.
+     * @return Bucket index.
+     */
+    static unsigned bucketOf(std::uint64_t ns) {
+        if (ns < kSubBuckets) return static_cast<unsigned>(ns);
+        unsigned exponent = static_cast<unsigned>(std::bit_width(ns)) - 1;
+        unsigned sub = static_cast<unsigned>(ns >> (exponent - 2)) & (kSubBuckets - 1);
+        return kSubBuckets * (exponent - 1) + sub;
+    }
+
+    /**
+     * @brief Returns the first pause length past a bucket.
+     * @param bucket Bucket index.
+     * @return Exclusive upper bound in nanoseconds.
+     */
+    static std::uint64_t bucketLimit(unsigned bucket) {
+        if (bucket < kSubBuckets) return bucket + 1;
+        unsigned exponent = bucket / kSubBuckets + 1;
+        std::uint64_t sub = bucket % kSubBuckets;
+        if (exponent == 63 && sub == kSubBuckets - 1) return UINT64_MAX;
+        return (kSubBuckets + sub + 1) << (exponent - 2);
+    }
+};
+
+/**
+ * @struct GCStats
+ * @brief Snapshot of the collector's counters, returned by GC::stats().
+ *
+ * Counters are cumulative since the program started. Times are wall time
+ * spent on mutator threads; work done on the marker and sweeper threads is
+ * not included.
+ */
+struct GCStats {
+    /** @brief Blocking minor collections, from GC::collectNow(false). */
+    std::uint64_t minorCollections = 0;
+
+    /** @brief Blocking major collections, from GC::collectNow(true). */
+    std::uint64_t majorCollections = 0;
+
+    /** @brief Incremental cycles started. */
+    std::uint64_t incrementalCycles = 0;
+
+    /** @brief Incremental steps taken while a cycle was running. */
+    std::uint64_t incrementalSteps = 0;
+
+    /** @brief Time in blocking minor collections. */
+    std::chrono::nanoseconds minorTime{0};
+
+    /** @brief Time marking for major and incremental cycles, root scans included. */
+    std::chrono::nanoseconds markTime{0};
+
+    /** @brief Time sweeping for major and incremental cycles. */
+    std::chrono::nanoseconds sweepTime{0};
+
+    /** @brief Time compacting, as part of major collections. */
+    std::chrono::nanoseconds compactTime{0};
+
+    /** @brief Length of every collection and incremental step, world stop included. */
+    GCPauseHistogram pauses;
+
+    /** @brief Objects registered with the collector. */
+    std::uint64_t objectsAllocated = 0;
+
+    /** @brief Bytes of cells and nursery space those objects took. */
+    std::uint64_t bytesAllocated = 0;
+
+    /** @brief Objects reclaimed, in the nursery or on heap pages. */
+    std::uint64_t objectsFreed = 0;
+
+    /** @brief Bytes those objects occupied. */
+    std::uint64_t bytesFreed = 0;
+
+    /** @brief Objects on heap pages examined by sweeps, live or dead. */
+    std::uint64_t objectsSwept = 0;
+
+    /** @brief Objects moved into the old generation, by evacuation or in place. */
+    std::uint64_t objectsPromoted = 0;
+
+    /** @brief Bytes those objects occupy in the old generation. */
+    std::uint64_t bytesPromoted = 0;
+
+    /** @brief Objects moved by compaction. */
+    std::uint64_t objectsCompacted = 0;
+
+    /** @brief Bytes of cells those objects occupy. */
+    std::uint64_t bytesCompacted = 0;
+
+    /** @brief Pages unmapped by compaction. */
+    std::uint64_t pagesCompacted = 0;
+
+    /** @brief Container slots, such as GCVector elements, marked in one loop by GCTracer::visitRange(). */
+    std::uint64_t rangeSlotsMarked = 0;
+
+    /** @brief Young objects on small-object pages. */
+    std::size_t youngObjects = 0;
+
+    /** @brief Bytes of young cells on small-object pages. */
+    std::size_t youngBytes = 0;
+
+    /** @brief Old objects on small-object pages. */
+    std::size_t oldObjects = 0;
+
+    /** @brief Bytes of old cells on small-object pages. */
+    std::size_t oldBytes = 0;
+
+    /** @brief Objects in the large-object space, each on its own mapping. */
+    std::size_t largeObjects = 0;
+
+    /** @brief Bytes mapped for those objects. */
+    std::size_t largeBytes = 0;
+
+    /** @brief Objects in the nursery. */
+    std::size_t nurseryObjects = 0;
+
+    /** @brief Nursery bytes claimed since it was last emptied. */
+    std::size_t nurseryBytes = 0;
+
+    /** @brief Bytes of objects on heap pages; see GC::heapBytes(). */
+    std::size_t heapBytes = 0;
+
+    /** @brief Heap size at which the next cycle starts; see GC::heapGoal(). */
+    std::size_t heapGoal = 0;
+
+    /** @brief Bytes mapped for heap pages. */
+    std::size_t mappedBytes = 0;
+
+    /** @brief GCRef roots and GCLocal slots on every thread. */
+    std::size_t roots = 0;
+};
+
+/**
+ * @enum GCCycleKind
+ * @brief Kind of collection a GCCycleEvent reports.
+ */
+enum class GCCycleKind {
+    /** @brief Blocking young-generation collection. */
+    Minor,
+    /** @brief Blocking full collection. */
+    Major,
+    /** @brief Incremental or concurrent cycle. */
+    Incremental
+};
+
+/**
+ * @struct GCCycleEvent
+ * @brief Passed to cycle hooks when a collection starts and ends.
+ */
+struct GCCycleEvent {
+    /** @brief Kind of collection. */
+    GCCycleKind kind;
+
+    /** @brief False when the collection starts, true when it ends. */
+    bool end;
+
+    /** @brief Sequence number of the collection among those of its kind. */
+    std::uint64_t cycle;
+
+    /** @brief Wall time from start to end; zero at the start. */
+    std::chrono::nanoseconds duration{0};
+
+    /**
+     * @brief Objects freed between start and end. Lazy and background
+     * sweeps may free more after the end.
+     */
+    std::uint64_t objectsFreed = 0;
+
+    /** @brief Bytes freed between start and end. */
+    std::uint64_t bytesFreed = 0;
+
+    /** @brief Bytes of objects on heap pages when the event fired. */
+    std::size_t heapBytes = 0;
+};
+
+#endif
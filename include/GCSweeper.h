@@ -0,0 +1,57 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: include/GCSweeper.h
+// ----------------------------------
+
+#ifndef TERMPROJECT_GCSWEEPER_H
+#define TERMPROJECT_GCSWEEPER_H
+
+#include <cstddef>
+#include <vector>
+
+struct GCPage;
+
+/**
+ * @file GCSweeper.h
+ * @brief Defines the background sweeper thread.
+ */
+
+/**
+ * @class GCSweeper
+ * @brief Runs the destructors of dead objects on a dedicated thread.
+ *
+ * The sweeper walks a snapshot of the page table in order and destroys
+ * every allocated, unmarked object without freeing its cell. The mutator
+ * then reclaims each finished page with bitmap operations only, so the
+ * allocator and the collector's bookkeeping stay on the mutator thread.
+ *
+ * Objects the mutator allocates meanwhile must publish their mark bit
+ * before their alloc bit (GCBitmap::setRelease()), so the sweeper never
+ * mistakes them for garbage.
+ */
+class GCSweeper {
+public:
+    /**
+     * @brief Starts destroying dead objects on the given pages.
+     *
+     * The previous sweep must have finished.
+     *
+     * @param pages Pages to sweep, in order; must outlive the sweep.
+     */
+    static void start(const std::vector<GCPage*>& pages);
+
+    /**
+     * @brief Returns how many pages from the front of the list are done.
+     * @return Finished page count.
+     */
+    static std::size_t finished();
+
+    /**
+     * @brief Blocks until every page has been swept.
+     */
+    static void wait();
+};
+
+#endif
@@ -0,0 +1,231 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: include/GCTrace.h
+// ----------------------------------
+
+#ifndef TERMPROJECT_GCTRACE_H
+#define TERMPROJECT_GCTRACE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @file GCTrace.h
+ * @brief Defines the collector's binary event trace.
+ *
+ * Tracing is compiled in only when GC_TRACE is defined to 1, which the
+ * GC_ENABLE_TRACE CMake option does. Otherwise every trace point is an
+ * empty inline function or macro and no code is generated for it.
+ */
+
+#ifndef GC_TRACE
+#define GC_TRACE 0
+#endif
+
+/**
+ * @enum GCTracePoint
+ * @brief What a trace record describes.
+ */
+enum class GCTracePoint : std::uint8_t {
+    /** @brief GC::collectNow(); the end value is 1 for a major collection. */
+    Collection,
+    /** @brief GC::incrementalCollectStep(); the end value is the phase stepped. */
+    IncrementalStep,
+    /** @brief Root scan; the end value is the number of objects grayed. */
+    RootScan,
+    /** @brief Incremental mark step; the end value is the objects scanned. */
+    MarkStep,
+    /** @brief Incremental sweep step; the end value is the objects visited. */
+    SweepStep,
+    /** @brief Young-generation trace; the end value is the nursery objects that died. */
+    MinorMark,
+    /** @brief Blocking full mark; the end value is the objects marked. */
+    BlockingMark,
+    /** @brief Blocking sweep; the end value is the objects freed. */
+    BlockingSweep,
+    /** @brief Lazy sweep of one size class; the end value is the objects freed. */
+    LazySweep,
+    /** @brief Reclaim of background-swept pages; the end value is the objects freed. */
+    BackgroundReclaim,
+    /** @brief Write barrier hit; 1 if the owner was remembered, 2 if the child was shaded. */
+    WriteBarrier,
+    /** @brief Objects promoted in place; the value is how many. */
+    Promotion,
+    /** @brief Nursery object copied out; the value is its size in bytes. */
+    Evacuation,
+    /** @brief Compaction after a major collection; the end value is the pages unmapped. */
+    Compaction,
+    /** @brief Batch of queued finalizers; the end value is the objects finalized. */
+    Finalization,
+    /** @brief GC::dumpHeap(); the end value is the objects written. */
+    HeapDump
+};
+
+/**
+ * @enum GCTraceKind
+ * @brief Whether a record opens a span, closes it, or stands alone.
+ */
+enum class GCTraceKind : std::uint8_t { Begin, End, Instant };
+
+/**
+ * @struct GCTraceRecord
+ * @brief One 16-byte trace record.
+ */
+struct GCTraceRecord {
+    /** @brief Timestamp from GCTrace::ticks(). */
+    std::uint64_t ticks;
+    /** @brief Point-specific value, e.g. a step's work units. */
+    std::uint32_t value;
+    /** @brief What happened. */
+    GCTracePoint point;
+    /** @brief Begin, end or instant. */
+    GCTraceKind kind;
+    /** @brief Id of the ring, and so of the thread, that recorded it. */
+    std::uint16_t thread;
+};
+
+/**
+ * @struct GCTraceRing
+ * @brief Ring buffer of one thread's most recent records.
+ *
+ * Only the owning thread writes. It publishes each record by advancing
+ * head with a release store, so a reader needs no lock; it drops records
+ * that were overwritten while it copied them, and the oldest one, whose
+ * slot the next record is written into. A dump therefore holds at most
+ * kRecords - 1 records per ring.
+ */
+struct GCTraceRing {
+    /** @brief Records kept per thread; a power of two. */
+    static constexpr std::size_t kRecords = 1 << 14;
+
+    /** @brief Total records written. */
+    std::atomic<std::uint64_t> head{0};
+
+    /** @brief Cleared when the owning thread exits, so the ring can be reused. */
+    std::atomic<bool> inUse{true};
+
+    /** @brief Id written into each record. */
+    std::uint16_t id = 0;
+
+    /** @brief Record storage, indexed by position modulo kRecords. */
+    std::array<GCTraceRecord, kRecords> records{};
+};
+
+/**
+ * @class GCTrace
+ * @brief Lock-free per-thread event recorder with Chrome trace export.
+ *
+ * Each thread records into its own ring, so recording is a timestamp read
+ * and a 16-byte store. Timestamps are TSC ticks where available and are
+ * converted to microseconds when the trace is written.
+ */
+class GCTrace {
+public:
+    /** @brief True when trace points are compiled in. */
+    static constexpr bool enabled = GC_TRACE != 0;
+
+    /**
+     * @brief Appends a record to the calling thread's ring.
+     * @param point What happened.
+     * @param kind Begin, end or instant.
+     * @param value Point-specific value.
+     */
+    static void record(GCTracePoint point, GCTraceKind kind, std::uint32_t value = 0) {
+        GCTraceRing* r = ring ? ring : attachRing();
+        std::uint64_t n = r->head.load(std::memory_order_relaxed);
+        r->records[n & (GCTraceRing::kRecords - 1)] = GCTraceRecord{ticks(), value, point, kind, r->id};
+        r->head.store(n + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Reads the trace clock.
+     * @return TSC ticks on x86, steady-clock nanoseconds elsewhere.
+     */
+    static std::uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    /**
+     * @brief Writes every thread's buffered records as Chrome trace JSON.
+     *
+     * The file loads in chrome://tracing and Perfetto. Threads may keep
+     * recording meanwhile. Without GC_TRACE the trace is empty.
+     *
+     * @param path File to write.
+     * @return False if the file could not be written.
+     */
+    static bool dump(const std::string& path);
+
+    /**
+     * @brief Discards every buffered record.
+     *
+     * No thread may be recording.
+     */
+    static void clear();
+
+private:
+    /**
+     * @brief Gives the calling thread a ring on its first record.
+     * @return The thread's ring.
+     */
+    static GCTraceRing* attachRing();
+
+    /** @brief The calling thread's ring, once it has one. */
+    static inline thread_local GCTraceRing* ring = nullptr;
+};
+
+/**
+ * @class GCTraceScope
+ * @brief Records a begin record on construction and an end record carrying
+ * value on destruction. Does nothing without GC_TRACE.
+ */
+class GCTraceScope {
+public:
+    /**
+     * @brief Opens the span.
+     * @param point What the span covers.
+     */
+    explicit GCTraceScope(GCTracePoint point) : point(point) {
+        if constexpr (GCTrace::enabled) GCTrace::record(point, GCTraceKind::Begin);
+    }
+
+    /** @brief Closes the span. */
+    ~GCTraceScope() {
+        if constexpr (GCTrace::enabled) GCTrace::record(point, GCTraceKind::End, value);
+    }
+
+    GCTraceScope(const GCTraceScope&) = delete;
+    GCTraceScope& operator=(const GCTraceScope&) = delete;
+
+    /** @brief Value for the end record. */
+    std::uint32_t value = 0;
+
+private:
+    GCTracePoint point;
+};
+
+/**
+ * @brief Records an instant event. The value is not evaluated without GC_TRACE.
+ */
+#if GC_TRACE
+#define GC_TRACE_INSTANT(point, value) \
+    GCTrace::record(GCTracePoint::point, GCTraceKind::Instant, static_cast<std::uint32_t>(value))
+#else
+#define GC_TRACE_INSTANT(point, value) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,175 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: include/GCTracer.h
+// ----------------------------------
+
+#ifndef TERMPROJECT_GCTRACER_H
+#define TERMPROJECT_GCTRACER_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "GCHeap.h"
+#include "GCRefBase.h"
+
+class GCObject;
+
+/**
+ * @file GCTracer.h
+ * @brief Defines the visitor GCObject::trace() reports children to.
+ */
+
+/**
+ * @class GCTracer
+ * @brief Receives the children of a traced object.
+ *
+ * A tracer marks or records each child the moment it is visited, so
+ * tracing an object builds no temporary list. The collector keeps one
+ * tracer per marking thread and reuses it for every object. visit() is
+ * not virtual; what it does is fixed by the tracer's mode.
+ */
+class GCTracer {
+public:
+    /**
+     * @enum Mode
+     * @brief What visit() does with each child.
+     */
+    enum class Mode {
+        /** @brief Appends every child to the output list. */
+        Collect,
+        /** @brief Marks the child and appends it if it was unmarked. */
+        Mark,
+        /** @brief As Mark, safe against other marking threads. */
+        MarkAtomic,
+        /** @brief Only tracks whether a child is young. */
+        Scan
+    };
+
+    /**
+     * @brief Creates a tracer.
+     * @param mode What visit() does.
+     * @param out List children are appended to; unused in Scan mode.
+     * @param trackYoung If true, pointsYoung() reports young children.
+     */
+    explicit GCTracer(Mode mode, std::vector<GCObject*>* out = nullptr, bool trackYoung = false)
+        : mode(mode), out(out), trackYoung(trackYoung) {}
+
+    /**
+     * @brief Reports one child.
+     * @param child Child object, or nullptr.
+     */
+    void visit(GCObject* child) {
+        if (!child) return;
+        noteYoung(child);
+        switch (mode) {
+            case Mode::Collect:
+                out->push_back(child);
+                break;
+            case Mode::Mark:
+                if (GCHeap::tryMark(child)) out->push_back(child);
+                break;
+            case Mode::MarkAtomic:
+                if (GCHeap::tryMarkAtomic(child)) out->push_back(child);
+                break;
+            case Mode::Scan:
+                break;
+        }
+    }
+
+    /**
+     * @brief Reports a contiguous run of children, e.g. a GCVector's elements.
+     *
+     * Picks the mode once for the whole run; young tracking is checked in
+     * the same loop. Elements are read one at a time, since the mutator may
+     * store into them while the background marker traces.
+     *
+     * @param children First child slot.
+     * @param count Number of slots.
+     */
+    void visitRange(GCObject* const* children, std::size_t count) {
+        auto read = [children](std::size_t i) {
+            return std::atomic_ref<GCObject*>(const_cast<GCObject*&>(children[i])).load(std::memory_order_relaxed);
+        };
+        switch (mode) {
+            case Mode::Collect:
+                for (std::size_t i = 0; i < count; ++i) {
+                    GCObject* child = read(i);
+                    if (!child) continue;
+                    noteYoung(child);
+                    out->push_back(child);
+                }
+                break;
+            case Mode::Mark:
+                for (std::size_t i = 0; i < count; ++i) {
+                    GCObject* child = read(i);
+                    if (!child) continue;
+                    noteYoung(child);
+                    if (GCHeap::tryMark(child)) out->push_back(child);
+                }
+                rangeSlots += count;
+                break;
+            case Mode::MarkAtomic:
+                for (std::size_t i = 0; i < count; ++i) {
+                    GCObject* child = read(i);
+                    if (!child) continue;
+                    noteYoung(child);
+                    if (GCHeap::tryMarkAtomic(child)) out->push_back(child);
+                }
+                rangeSlots += count;
+                break;
+            case Mode::Scan:
+                for (std::size_t i = 0; i < count && !young; ++i) {
+                    GCObject* child = read(i);
+                    if (child) noteYoung(child);
+                }
+                break;
+        }
+    }
+
+    /**
+     * @brief Reports the object a reference points at.
+     * @param ref Reference; read directly rather than through getObject().
+     */
+    void visit(const GCRefBase& ref) { visit(ref.load()); }
+
+    /**
+     * @brief Tests whether a young child was visited since the last reset().
+     * @return True if one was and young tracking is on.
+     */
+    bool pointsYoung() const { return young; }
+
+    /**
+     * @brief Starts tracking young children afresh for the next object.
+     */
+    void reset() { young = false; }
+
+    /**
+     * @brief Reusable buffer for GCObject::trace()'s traceChildren() path.
+     * @return Scratch list; its contents are not preserved between objects.
+     */
+    std::vector<GCObject*>& scratch() { return legacy; }
+
+    /**
+     * @brief Returns the slots marked through visitRange() since the last call.
+     * @return Slot count; the counter restarts at zero.
+     */
+    std::size_t takeRangeSlots() { return std::exchange(rangeSlots, 0); }
+
+private:
+    void noteYoung(GCObject* child) {
+        if (trackYoung && !young && GCHeap::isYoung(child)) young = true;
+    }
+
+    Mode mode;
+    std::vector<GCObject*>* out;
+    bool trackYoung;
+    bool young = false;
+    std::size_t rangeSlots = 0;
+    std::vector<GCObject*> legacy;
+};
+
+#endif
@@ -0,0 +1,465 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: include/GCVector.h
+// ----------------------------------
+
+#ifndef TERMPROJECT_GCVECTOR_H
+#define TERMPROJECT_GCVECTOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <type_traits>
+
+#include "GC.h"
+#include "GCObject.h"
+
+/**
+ * @file GCVector.h
+ * @brief Defines GC-managed arrays of object references.
+ */
+
+/**
+ * @class GCVectorBase
+ * @brief Untyped part of GCVector and GCArray.
+ *
+ * Elements are raw object pointers in one out-of-line buffer, so a
+ * container of any length is a single small object with no per-element
+ * registration. The collector reports the elements in one loop and
+ * redirects them when it moves the objects they point at. Stores of many
+ * elements at once take one write barrier for the whole range. Like other
+ * objects, a container is not synchronized between mutator threads.
+ */
+class GCVectorBase : public GCObject {
+public:
+    GCVectorBase(const GCVectorBase&) = delete;
+    GCVectorBase& operator=(const GCVectorBase&) = delete;
+
+    /** @brief Frees the element buffer. */
+    ~GCVectorBase() override;
+
+    /**
+     * @brief Returns the number of elements.
+     * @return Element count.
+     */
+    std::size_t size() const {
+        return std::atomic_ref<std::size_t>(const_cast<std::size_t&>(count)).load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Tests whether the container has no elements.
+     * @return True if size() is zero.
+     */
+    bool empty() const { return size() == 0; }
+
+    /**
+     * @brief Returns the number of elements the buffer holds without growing.
+     * @return Capacity.
+     */
+    std::size_t capacity() const { return slotCapacity; }
+
+    /**
+     * @brief Reports the elements after the GCMember and GCRef members.
+     * @param tracer Visitor receiving the children.
+     */
+    void trace(GCTracer& tracer) const override;
+
+    /**
+     * @brief Calls a function on the slot of every element.
+     * @param visit Function receiving each slot.
+     */
+    void visitExtraSlots(void (*visit)(GCObject**)) override;
+
+protected:
+    /**
+     * @brief Creates a container of null elements.
+     * @param n Initial size.
+     */
+    explicit GCVectorBase(std::size_t n = 0);
+
+    /**
+     * @brief Returns an element.
+     * @param i Index; must be below size().
+     * @return Element, or nullptr.
+     */
+    GCObject* at(std::size_t i) const { return load(slots[i]); }
+
+    /**
+     * @brief Replaces an element.
+     * @param i Index; must be below size().
+     * @param p New element, or nullptr.
+     */
+    void setAt(std::size_t i, GCObject* p) {
+        GC::deletionBarrier(load(slots[i]));
+        store(slots[i], p);
+        if (p) GC::writeBarrier(this, p);
+    }
+
+    /**
+     * @brief Appends an element, growing the buffer if it is full.
+     * @param p New element, or nullptr.
+     */
+    void pushBack(GCObject* p) {
+        std::size_t n = count;
+        if (n == slotCapacity) grow(n + 1);
+        store(slots[n], p);
+        setCount(n + 1);
+        if (p) GC::writeBarrier(this, p);
+    }
+
+    /**
+     * @brief Removes the last element.
+     */
+    void popBack();
+
+    /**
+     * @brief Grows the buffer to hold at least `n` elements.
+     * @param n Requested capacity.
+     */
+    void reserveSlots(std::size_t n) {
+        if (n > slotCapacity) grow(n);
+    }
+
+    /**
+     * @brief Changes the size, appending null elements or dropping the tail.
+     * @param n New size.
+     */
+    void resizeTo(std::size_t n);
+
+    /**
+     * @brief Stores one object in a range of elements.
+     * @param from First index.
+     * @param to One past the last index; must not exceed size().
+     * @param p Object to store, or nullptr.
+     */
+    void fillRange(std::size_t from, std::size_t to, GCObject* p);
+
+    /**
+     * @brief Overwrites consecutive elements with a list of objects.
+     * @tparam U Element type of the list.
+     * @param at First index; the range must lie within size().
+     * @param values Objects to store.
+     */
+    template <typename U>
+    void assignRange(std::size_t at, std::span<U* const> values) {
+        overwriteRange(at, at + values.size());
+        for (std::size_t i = 0; i < values.size(); ++i) store(slots[at + i], static_cast<GCObject*>(values[i]));
+        GC::writeBarrierRange(this, slots + at, values.size());
+    }
+
+    /**
+     * @brief Appends a list of objects.
+     * @tparam U Element type of the list.
+     * @param values Objects to append.
+     */
+    template <typename U>
+    void appendRange(std::span<U* const> values) {
+        std::size_t n = count;
+        reserveSlots(n + values.size());
+        for (std::size_t i = 0; i < values.size(); ++i) store(slots[n + i], static_cast<GCObject*>(values[i]));
+        setCount(n + values.size());
+        GC::writeBarrierRange(this, slots + n, values.size());
+    }
+
+    /**
+     * @brief Copies elements of another container into this one.
+     * @param at First index written; the range must lie within size().
+     * @param src Container to copy from; may be this one.
+     * @param from First index read.
+     * @param n Elements copied.
+     */
+    void copyRange(std::size_t at, const GCVectorBase& src, std::size_t from, std::size_t n);
+
+private:
+    static GCObject* load(GCObject* const& slot) {
+        return std::atomic_ref<GCObject*>(const_cast<GCObject*&>(slot)).load(std::memory_order_relaxed);
+    }
+
+    static void store(GCObject*& slot, GCObject* p) {
+        std::atomic_ref<GCObject*>(slot).store(p, std::memory_order_relaxed);
+    }
+
+    void setCount(std::size_t n) { std::atomic_ref<std::size_t>(count).store(n, std::memory_order_relaxed); }
+
+    // Reallocates the buffer for at least `n` elements.
+    void grow(std::size_t n);
+
+    // Logs the elements in [from, to) for a running concurrent mark.
+    void overwriteRange(std::size_t from, std::size_t to) const;
+
+    GCObject** slots = nullptr;
+    std::size_t count = 0;
+    std::size_t slotCapacity = 0;
+};
+
+/**
+ * @class GCVectorIterator
+ * @brief Read-only iterator over the elements of a GCVector or GCArray.
+ * @tparam C Container type.
+ * @tparam T Element type.
+ */
+template <typename C, typename T>
+class GCVectorIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T*;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = T*;
+
+    GCVectorIterator() = default;
+
+    /**
+     * @brief Creates an iterator at an index.
+     * @param c Container.
+     * @param i Index.
+     */
+    GCVectorIterator(const C* c, std::size_t i) : c(c), i(i) {}
+
+    /** @brief Returns the current element. */
+    T* operator*() const { return (*c)[i]; }
+
+    /** @brief Advances to the next element. */
+    GCVectorIterator& operator++() {
+        ++i;
+        return *this;
+    }
+
+    /** @brief Advances to the next element. */
+    GCVectorIterator operator++(int) {
+        GCVectorIterator old = *this;
+        ++i;
+        return old;
+    }
+
+    /** @brief Compares positions. */
+    bool operator==(const GCVectorIterator& other) const { return i == other.i; }
+
+private:
+    const C* c = nullptr;
+    std::size_t i = 0;
+};
+
+/**
+ * @class GCVector
+ * @brief Growable GC-managed array of references, e.g. for adjacency lists.
+ *
+ * Create it with GC::make<GCVector<T>>() and hold it like any other object.
+ * Elements are read and written by index; there is no element reference,
+ * so every store goes through the barriers. Elements may be movable
+ * objects.
+ *
+ * @tparam T Element type; must inherit from GCObject.
+ */
+template <typename T>
+class GCVector : public GCVectorBase {
+    static_assert(std::is_convertible<T*, GCObject*>::value,
+                  "T must inherit GCObject");
+
+public:
+    /** @brief Iterator type returned by begin() and end(). */
+    using const_iterator = GCVectorIterator<GCVector, T>;
+
+    /**
+     * @brief Creates a vector of null elements.
+     * @param n Initial size.
+     */
+    explicit GCVector(std::size_t n = 0) : GCVectorBase(n) {}
+
+    /**
+     * @brief Returns an element.
+     * @param i Index; must be below size().
+     * @return Element, or nullptr.
+     */
+    T* operator[](std::size_t i) const { return static_cast<T*>(at(i)); }
+
+    /**
+     * @brief Returns an element.
+     * @param i Index; must be below size().
+     * @return Element, or nullptr.
+     */
+    T* get(std::size_t i) const { return (*this)[i]; }
+
+    /**
+     * @brief Replaces an element.
+     * @param i Index; must be below size().
+     * @param p New element, or nullptr.
+     */
+    void set(std::size_t i, T* p) { setAt(i, static_cast<GCObject*>(p)); }
+
+    /**
+     * @brief Returns the last element.
+     * @return Element, or nullptr; the vector must not be empty.
+     */
+    T* back() const { return (*this)[size() - 1]; }
+
+    /**
+     * @brief Appends an element.
+     * @param p New element, or nullptr.
+     */
+    void push_back(T* p) { pushBack(static_cast<GCObject*>(p)); }
+
+    /**
+     * @brief Removes the last element; the vector must not be empty.
+     */
+    void pop_back() { popBack(); }
+
+    /**
+     * @brief Grows the buffer to hold at least `n` elements.
+     * @param n Requested capacity.
+     */
+    void reserve(std::size_t n) { reserveSlots(n); }
+
+    /**
+     * @brief Changes the size, appending null elements or dropping the tail.
+     * @param n New size.
+     */
+    void resize(std::size_t n) { resizeTo(n); }
+
+    /**
+     * @brief Removes every element; the buffer is kept.
+     */
+    void clear() { resizeTo(0); }
+
+    /**
+     * @brief Stores one object in every element.
+     * @param p Object to store, or nullptr.
+     */
+    void fill(T* p) { fillRange(0, size(), static_cast<GCObject*>(p)); }
+
+    /**
+     * @brief Stores one object in a range of elements.
+     * @param from First index.
+     * @param to One past the last index; must not exceed size().
+     * @param p Object to store, or nullptr.
+     */
+    void fill(std::size_t from, std::size_t to, T* p) { fillRange(from, to, static_cast<GCObject*>(p)); }
+
+    /**
+     * @brief Appends a list of objects with one barrier.
+     * @param values Objects to append.
+     */
+    void append(std::span<T* const> values) { appendRange(values); }
+
+    /**
+     * @brief Appends the elements of another vector with one barrier.
+     * @param other Vector to copy; may be this one.
+     */
+    void append(const GCVector& other) {
+        std::size_t n = other.size();
+        std::size_t at = size();
+        resizeTo(at + n);
+        copyRange(at, other, 0, n);
+    }
+
+    /**
+     * @brief Overwrites consecutive elements with a list of objects, with
+     *        one barrier.
+     * @param at First index; the range must lie within size().
+     * @param values Objects to store.
+     */
+    void assign(std::size_t at, std::span<T* const> values) { assignRange(at, values); }
+
+    /**
+     * @brief Copies elements of another vector into this one.
+     * @param at First index written; the range must lie within size().
+     * @param src Vector to copy from; may be this one.
+     * @param from First index read.
+     * @param n Elements copied.
+     */
+    void copy(std::size_t at, const GCVector& src, std::size_t from, std::size_t n) { copyRange(at, src, from, n); }
+
+    /** @brief Returns an iterator to the first element. */
+    const_iterator begin() const { return {this, 0}; }
+
+    /** @brief Returns an iterator past the last element. */
+    const_iterator end() const { return {this, size()}; }
+};
+
+/**
+ * @class GCArray
+ * @brief Fixed-length GC-managed array of references.
+ *
+ * The length is set when the array is created and its elements start out
+ * null. It is a GCVector without the operations that change the size.
+ *
+ * @tparam T Element type; must inherit from GCObject.
+ */
+template <typename T>
+class GCArray : public GCVectorBase {
+    static_assert(std::is_convertible<T*, GCObject*>::value,
+                  "T must inherit GCObject");
+
+public:
+    /** @brief Iterator type returned by begin() and end(). */
+    using const_iterator = GCVectorIterator<GCArray, T>;
+
+    /**
+     * @brief Creates an array of null elements.
+     * @param n Length.
+     */
+    explicit GCArray(std::size_t n) : GCVectorBase(n) {}
+
+    /**
+     * @brief Returns an element.
+     * @param i Index; must be below size().
+     * @return Element, or nullptr.
+     */
+    T* operator[](std::size_t i) const { return static_cast<T*>(at(i)); }
+
+    /**
+     * @brief Returns an element.
+     * @param i Index; must be below size().
+     * @return Element, or nullptr.
+     */
+    T* get(std::size_t i) const { return (*this)[i]; }
+
+    /**
+     * @brief Replaces an element.
+     * @param i Index; must be below size().
+     * @param p New element, or nullptr.
+     */
+    void set(std::size_t i, T* p) { setAt(i, static_cast<GCObject*>(p)); }
+
+    /**
+     * @brief Stores one object in every element.
+     * @param p Object to store, or nullptr.
+     */
+    void fill(T* p) { fillRange(0, size(), static_cast<GCObject*>(p)); }
+
+    /**
+     * @brief Stores one object in a range of elements.
+     * @param from First index.
+     * @param to One past the last index; must not exceed size().
+     * @param p Object to store, or nullptr.
+     */
+    void fill(std::size_t from, std::size_t to, T* p) { fillRange(from, to, static_cast<GCObject*>(p)); }
+
+    /**
+     * @brief Overwrites consecutive elements with a list of objects, with
+     *        one barrier.
+     * @param at First index; the range must lie within size().
+     * @param values Objects to store.
+     */
+    void assign(std::size_t at, std::span<T* const> values) { assignRange(at, values); }
+
+    /**
+     * @brief Copies elements of another array into this one.
+     * @param at First index written; the range must lie within size().
+     * @param src Array to copy from; may be this one.
+     * @param from First index read.
+     * @param n Elements copied.
+     */
+    void copy(std::size_t at, const GCArray& src, std::size_t from, std::size_t n) { copyRange(at, src, from, n); }
+
+    /** @brief Returns an iterator to the first element. */
+    const_iterator begin() const { return {this, 0}; }
+
+    /** @brief Returns an iterator past the last element. */
+    const_iterator end() const { return {this, size()}; }
+};
+
+#endif
@@ -0,0 +1,276 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: include/GCWeak.h
+// ----------------------------------
+
+#ifndef TERMPROJECT_GCWEAK_H
+#define TERMPROJECT_GCWEAK_H
+
+#include <cstddef>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "GC.h"
+#include "GCObject.h"
+#include "GCRef.h"
+
+struct GCThreadState;
+
+/**
+ * @file GCWeak.h
+ * @brief Defines weak references and weak-keyed ephemeron maps.
+ */
+
+/**
+ * @class GCWeakRefBase
+ * @brief Untyped part of GCWeakRef.
+ *
+ * A weak reference does not keep its object alive. Every weak reference
+ * that was ever non-null is listed in its thread's weak table, and once a
+ * collection has finished marking, the collector nulls those whose object
+ * was not reached. The cost is one check per weak reference per collection.
+ * A weak reference must not be a member of a movable object.
+ */
+class GCWeakRefBase {
+public:
+    GCWeakRefBase(const GCWeakRefBase&) = delete;
+    GCWeakRefBase& operator=(const GCWeakRefBase&) = delete;
+
+    /**
+     * @brief Returns the referenced object.
+     *
+     * While a concurrent mark is running the object is shaded, so a
+     * reference read now keeps it alive through the current cycle.
+     *
+     * @return Object, or nullptr once it has been collected.
+     */
+    GCObject* getObject() const {
+        GC::readBarrier(obj);
+        return obj;
+    }
+
+    /**
+     * @brief Tests whether the object has been collected or was never set.
+     * @return True if the reference is null.
+     */
+    bool expired() const { return obj == nullptr; }
+
+    /**
+     * @brief Returns the address of the stored object pointer.
+     *
+     * Used by the collector to null or redirect the reference.
+     *
+     * @return Slot holding the referenced object.
+     */
+    GCObject** slot() { return &obj; }
+
+protected:
+    GCWeakRefBase() = default;
+
+    /** @brief Unregisters the reference. */
+    ~GCWeakRefBase() { GC::unregisterWeakRef(this); }
+
+    /**
+     * @brief Points the reference at another object.
+     * @param p New object, or nullptr.
+     */
+    void assign(GCObject* p) {
+        obj = p;
+        if (p && !weakThread) GC::registerWeakRef(this);
+    }
+
+private:
+    friend class GC;
+
+    /** @brief Referenced object. */
+    GCObject* obj = nullptr;
+
+    /** @brief Thread whose weak table holds this reference, or nullptr. */
+    GCThreadState* weakThread = nullptr;
+
+    /** @brief Slot in that thread's weak table, or -1. */
+    int weakIndex = -1;
+};
+
+/**
+ * @class GCWeakRef
+ * @brief Typed weak reference.
+ *
+ * Read it with get() or lock() and keep the result in a GCRef or GCLocal
+ * for as long as it is used.
+ *
+ * @tparam T Type of object referenced; must inherit from GCObject.
+ */
+template <typename T>
+class GCWeakRef : public GCWeakRefBase {
+    static_assert(std::is_convertible<T*, GCObject*>::value,
+                  "T must inherit GCObject");
+
+public:
+    /**
+     * @brief Constructs a weak reference.
+     * @param p Referenced object, or nullptr.
+     */
+    explicit GCWeakRef(T* p = nullptr) { assign(static_cast<GCObject*>(p)); }
+
+    /**
+     * @brief Copy constructor.
+     * @param other Reference to copy.
+     */
+    GCWeakRef(const GCWeakRef& other) : GCWeakRefBase() { assign(other.getObject()); }
+
+    /**
+     * @brief Copy assignment operator.
+     * @param other Reference to copy.
+     * @return *this
+     */
+    GCWeakRef& operator=(const GCWeakRef& other) {
+        if (this != &other) assign(other.getObject());
+        return *this;
+    }
+
+    /**
+     * @brief Points the reference at another object.
+     * @param p New object, or nullptr.
+     * @return *this
+     */
+    GCWeakRef& operator=(T* p) {
+        assign(static_cast<GCObject*>(p));
+        return *this;
+    }
+
+    /**
+     * @brief Returns the referenced object.
+     * @return Object, or nullptr once it has been collected.
+     */
+    T* get() const { return static_cast<T*>(getObject()); }
+
+    /**
+     * @brief Returns a root reference to the object, keeping it alive.
+     * @return Root GCRef; null once the object has been collected.
+     */
+    GCRef<T> lock() const { return GCRef<T>(get()); }
+};
+
+/**
+ * @class GCEphemeronTable
+ * @brief Untyped weak-keyed table of object pairs.
+ *
+ * An entry keeps its value alive only while its key is alive through some
+ * other path. Once marking is done the collector removes every entry whose
+ * key was not reached, in one pass over the table's entries. A table is
+ * an ordinary C++ object; the collector finds it through a registry. Like
+ * other containers it is not synchronized, and it must not be changed
+ * from inside a safe region.
+ */
+class GCEphemeronTable {
+public:
+    /**
+     * @struct Entry
+     * @brief One key and its value.
+     */
+    struct Entry {
+        /** @brief Weakly held key. */
+        GCObject* key;
+        /** @brief Value, held as long as the key is alive. */
+        GCObject* value;
+    };
+
+    /** @brief Registers the table with the collector. */
+    GCEphemeronTable() { GC::registerEphemeronTable(this); }
+
+    /** @brief Unregisters the table. */
+    ~GCEphemeronTable() { GC::unregisterEphemeronTable(this); }
+
+    GCEphemeronTable(const GCEphemeronTable&) = delete;
+    GCEphemeronTable& operator=(const GCEphemeronTable&) = delete;
+
+    /**
+     * @brief Looks up the value stored for a key.
+     * @param key Key object.
+     * @return Value, or nullptr if the key has no entry.
+     */
+    GCObject* find(GCObject* key) const;
+
+    /**
+     * @brief Adds an entry or replaces the value of an existing one.
+     * @param key Key object; must not be nullptr.
+     * @param value Value object.
+     */
+    void insert(GCObject* key, GCObject* value);
+
+    /**
+     * @brief Removes the entry for a key.
+     * @param key Key object.
+     * @return True if there was one.
+     */
+    bool erase(GCObject* key);
+
+    /** @brief Removes every entry. */
+    void clear();
+
+    /**
+     * @brief Returns the number of entries.
+     * @return Entry count.
+     */
+    std::size_t size() const { return entries.size(); }
+
+    /**
+     * @brief Returns the entries, for the collector.
+     *
+     * The collector may rewrite keys and values in place and remove
+     * entries, and calls reindex() afterwards.
+     *
+     * @return Entries, in no particular order.
+     */
+    std::vector<Entry>& collectorEntries() { return entries; }
+
+    /**
+     * @brief Rebuilds the key index after the collector changed the entries.
+     */
+    void reindex();
+
+private:
+    std::vector<Entry> entries;
+    std::unordered_map<GCObject*, std::size_t> index; // key -> position in entries
+};
+
+/**
+ * @class GCEphemeronMap
+ * @brief Typed weak-keyed map, e.g. for memoization caches keyed by object.
+ *
+ * @tparam K Key type; must inherit from GCObject.
+ * @tparam V Value type; must inherit from GCObject.
+ */
+template <typename K, typename V>
+class GCEphemeronMap : public GCEphemeronTable {
+    static_assert(std::is_convertible<K*, GCObject*>::value, "K must inherit GCObject");
+    static_assert(std::is_convertible<V*, GCObject*>::value, "V must inherit GCObject");
+
+public:
+    /**
+     * @brief Looks up the value stored for a key.
+     * @param key Key object.
+     * @return Value, or nullptr if the key has no entry.
+     */
+    V* get(K* key) const { return static_cast<V*>(find(static_cast<GCObject*>(key))); }
+
+    /**
+     * @brief Adds an entry or replaces the value of an existing one.
+     * @param key Key object; must not be nullptr.
+     * @param value Value object.
+     */
+    void set(K* key, V* value) { insert(static_cast<GCObject*>(key), static_cast<GCObject*>(value)); }
+
+    /**
+     * @brief Removes the entry for a key.
+     * @param key Key object.
+     * @return True if there was one.
+     */
+    bool remove(K* key) { return erase(static_cast<GCObject*>(key)); }
+};
+
+#endif
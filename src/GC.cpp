@@ -8,12 +8,34 @@
 #include "../include/GC.h"
 #include "../include/GCObject.h"
 #include "../include/GCRefBase.h"
+#include "../include/GCHeap.h"
+#include "../include/GCMarker.h"
+#include "../include/GCSweeper.h"
+#include "../include/GCFinalizer.h"
+#include "../include/GCHeapSnapshot.h"
+#include "../include/GCRootScope.h"
+#include "../include/GCTracer.h"
+#include "../include/GCTrace.h"
+#include "../include/GCWeak.h"
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <climits>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
 #include <iostream>
 #include <chrono>
 #include <ctime>
 #include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
 
 using namespace std;
 
@@ -22,170 +44,791 @@ bool GC::debug = false;
 #define LOG(x) \
     do { if (GC::debug) { auto now = chrono::system_clock::now(); auto t = chrono::system_clock::to_time_t(now); cout << "[" << put_time(localtime(&t), "%H:%M:%S") << "] " << x << endl; } } while(0)
 
+/**
+ * @struct GCThreadState
+ * @brief Collector state private to one mutator thread.
+ *
+ * A thread records roots, barrier hits and allocation counts here without
+ * taking a shared lock; the collector folds the buffers into its own state
+ * while the world is stopped. A state outlives its thread, since GCRefs
+ * rooted there may still be alive, and is reused by the next thread that
+ * attaches.
+ */
+struct GCThreadState {
+    enum class Mode { Running, Parked, Safe, Detached };
+
+    /** @brief Guarded by the thread registry lock. */
+    Mode mode = Mode::Running;
+
+    /** @brief Guards roots against unregisterRoot() from other threads. */
+    atomic_flag rootLock;
+
+    /** @brief Dense root table; GCRefBase::rootIndex is each root's slot. */
+    vector<GCRefBase*> roots;
+
+    /** @brief Weak references; GCWeakRefBase::weakIndex is each one's slot. Also guarded by rootLock. */
+    vector<GCWeakRefBase*> weakRefs;
+
+    /** @brief The thread's GCLocal slots, once it has pushed one. */
+    GCShadowStack* shadow = nullptr;
+
+    /** @brief Old objects that gained a young child. */
+    vector<GCObject*> remembered;
+
+    /** @brief Objects shaded by the incremental write barrier. */
+    vector<GCObject*> gray;
+
+    /** @brief References overwritten during a concurrent mark. */
+    vector<GCObject*> overwritten;
+
+    /** @brief Nursery objects that own member-reference storage. */
+    vector<GCObject*> nurseryStorage;
+
+    size_t youngAllocated = 0;
+    size_t nurseryAllocated = 0;
+    size_t largeAllocated = 0;
+    int allocationCounter = 0;
+
+    /** @brief Bytes of heap cells allocated since the last fold. */
+    size_t bytesAllocated = 0;
+
+    /** @brief Heap bytes allocated but not yet added to the shared total. */
+    size_t heapBytesPending = 0;
+
+    /** @brief Work units the thread owes a paced cycle. */
+    double workDebt = 0;
+};
+
+/**
+ * @class GCThreads
+ * @brief Registry of mutator threads and the stop-the-world handshake.
+ */
+class GCThreads {
+public:
+    static GCThreadState& attach();
+    static void detach();
+    static void stop();
+    static void resume();
+    static void park(GCThreadState::Mode mode);
+    static void unpark();
+};
+
 namespace {
     // Internal state
     enum class Phase { Idle, MarkRoots, Marking, Sweep };
 
-    Phase phase = Phase::Idle;
+    // Written with the world stopped, except Idle -> MarkRoots, which any
+    // allocating thread may trigger.
+    atomic<Phase> phase{Phase::Idle};
+
+    // Every thread that has used the collector, guarded by threadsLock.
+    // threadsChanged is signalled whenever a thread parks, resumes or a
+    // stop ends.
+    mutex threadsLock;
+    condition_variable threadsChanged;
+    vector<unique_ptr<GCThreadState>> threadStates;
+    thread_local GCThreadState* currentThread = nullptr;
+
+    // Nesting depth of stops made by this thread.
+    thread_local int stopDepth = 0;
+
+    // Detaches the thread when it exits.
+    struct ThreadExit {
+        ~ThreadExit() { GCThreads::detach(); }
+    };
+    thread_local ThreadExit threadExit;
+
+    // Threads attach before they first take memory from the heap, since the
+    // collector retires the allocation buffers of every registered thread.
+    const bool threadHookInstalled = [] {
+        GCHeap::threadHook = [] { if (!currentThread) GCThreads::attach(); };
+        return true;
+    }();
+
+    GCThreadState& self() {
+        return currentThread ? *currentThread : GCThreads::attach();
+    }
+
+    // Stops every other mutator for the lifetime of the guard.
+    struct WorldStop {
+        WorldStop() { GCThreads::stop(); }
+        ~WorldStop() { GCThreads::resume(); }
+        WorldStop(const WorldStop&) = delete;
+        WorldStop& operator=(const WorldStop&) = delete;
+    };
+
+    class RootGuard {
+    public:
+        explicit RootGuard(GCThreadState& t) : t(t) {
+            while (t.rootLock.test_and_set(memory_order_acquire)) this_thread::yield();
+        }
+        ~RootGuard() { t.rootLock.clear(memory_order_release); }
+        RootGuard(const RootGuard&) = delete;
+        RootGuard& operator=(const RootGuard&) = delete;
+
+    private:
+        GCThreadState& t;
+    };
 
-    unordered_set<GCObject*> youngObjects;
-    unordered_set<GCObject*> oldObjects;
-    unordered_set<GCRefBase*> roots;
+    // Objects are tracked by the heap pages themselves: allocBits marks the
+    // cells holding registered objects, youngBits/agedBits their generation
+    // and age, and markBits their color. Gray objects are the ones on the
+    // mark stack.
+    size_t youngCount = 0;
+    size_t oldCount = 0;
+
+    // Objects in the large-object space: one per large page, born old, never
+    // moved, and only freed by major collections, which unmap the page.
+    size_t largeCount = 0;
+
+    // Objects bump-allocated in the copying nursery since it was last reset.
+    size_t nurseryCount = 0;
+
+    // Nursery objects that own member-reference storage, released if they
+    // die without being evacuated.
+    vector<GCObject*> nurseryStorage;
+
+    // Pages holding at least one young object; GCPage::youngIndex is the
+    // slot. Minor collections only visit these. Guarded by the heap lock
+    // while the world runs.
+    vector<GCPage*> youngPages;
+
+    // Old objects that may point at young ones. Membership is deduplicated
+    // by GCPage::rememberedBits. A minor collection traces these in place of
+    // the whole old generation.
+    vector<GCObject*> rememberedSet;
+
+    // Scratch buffer for the minor collector's children.
+    vector<GCObject*> scratchChildren;
 
     // incremental state
     vector<GCObject*> markStack; // gray stack
-    unordered_set<GCObject*>::iterator sweepIt;
-    unordered_set<GCObject*>* sweepPool = nullptr; // pointer to current pool being swept
-    bool sweepingOld = false;
+
+    // Tracers reused for every object the collector thread scans: marking
+    // onto the mark stack, listing children for the minor collector, and
+    // checking remembered objects for young children.
+    GCTracer markTracer(GCTracer::Mode::Mark, &markStack, true);
+    GCTracer childTracer(GCTracer::Mode::Collect, &scratchChildren);
+    GCTracer youngTracer(GCTracer::Mode::Scan, nullptr, true);
+    size_t sweepPageIndex = 0;   // page the incremental sweep resumes from
+    uint32_t sweepCell = 0;      // cell within that page
 
     // Budgets / thresholds
     int markBudget = 20;
     int sweepBudget = 10;
-    int allocationCounter = 0;
-    int allocationThreshold = 100;
-    int youngThreshold = 50;
-    int promotedSurvivals = 2;
+    int allocationThreshold = 0;
+
+    // Pacing: with a pause target, a triggered cycle scans roots at the next
+    // safepoint and is then advanced by allocations, each of which owes
+    // allocationTax units of mark or sweep work. The cost of a unit is
+    // averaged over past steps so the budgets fit the target.
+    chrono::nanoseconds pauseTarget{0};
+    double allocationTax = 0;
+    double markNsPerUnit = 0;
+    double sweepNsPerUnit = 0;
+    int stepUnits = 0;                  // units done by the current step
+    thread_local bool inAllocationHook = false; // a step's destructors may allocate
+    constexpr int kMinPacedBudget = 16;
+    constexpr int kMaxPacedBudget = 1 << 20;
+
+    // Heap policy: bytes in page cells, kept in per-thread batches of
+    // kHeapBytesBatch. A cycle starts once they pass heapGoalBytes, which is
+    // recomputed from liveBytes, the survivors of the last major mark.
+    GCHeapPolicy policy;
+    size_t softTarget = 0;              // policy's soft limit, or the cgroup's if lower
+    atomic<size_t> hardLimit{0};
+    atomic<bool> hardLimitExhausted{false};   // the last hard-limit collection left no room
+    atomic<size_t> heapUsed{0};
+    atomic<size_t> heapGoalBytes{GCHeapPolicy{}.minHeapBytes};
+    size_t liveBytes = 0;
+    constexpr size_t kHeapBytesBatch = 32 * 1024;
+
+    // Concurrent marking: incremental cycles mark on the collector thread.
+    // References the mutator overwrites meanwhile are buffered per thread,
+    // handed over in batches, and the remainder folded in here.
+    bool concurrentMarking = false;
+    vector<GCObject*> overwrittenBuffer;
+    constexpr size_t kOverwrittenBatch = 256;
+
+    // How a major collection reclaims dead objects once marking is done.
+    GCSweepMode sweepMode = GCSweepMode::Incremental;
+
+    // Lazy mode: pages still holding the last cycle's marks, per size class.
+    // A class's pages are swept when it needs cells. The slot after the
+    // small classes stays empty, since large pages are swept right away.
+    vector<GCPage*> lazyPages[GCHeap::kSizeClassCount + 1];
+    bool lazyRefilling = false;
 
-    int lastMinorCollected = 0;
-    int lastMajorCollected = 0;
+    // Background mode: the page snapshot the sweeper thread walks, and how
+    // many of those pages the mutator has reclaimed.
+    vector<GCPage*> backgroundPages;
+    size_t backgroundReclaimed = 0;
+
+    // Where dead objects are destroyed. Outside Inline mode the sweep
+    // collects detached objects here and hands each page's worth to the
+    // finalization queue; like the sweep itself, this is only touched with
+    // the world stopped or the heap lock held.
+    GCFinalization finalization = GCFinalization::Inline;
+    vector<GCObject*> finalizable;
+
+    // Whether major collections compact the heap after sweeping.
+    bool compaction = false;
+
+    // Ephemeron tables, registered from any thread.
+    mutex ephemeronLock;
+    vector<GCEphemeronTable*> ephemeronTables;
+
+    // Statistics: the cumulative counters of GCStats, updated by the
+    // collector as it goes; GC::stats() fills in the rest. Nursery bytes are
+    // counted when the nursery is reset, less those of evacuated objects.
+    GCStats totals;
+    size_t nurseryEvacuatedBytes = 0;
+    thread_local int pauseDepth = 0;   // nesting of CollectorPauses on this thread
+
+    // Cycle hooks by id, changed only with the world stopped.
+    vector<pair<int, function<void(const GCCycleEvent&)>>> cycleHooks;
+    int nextCycleHookId = 0;
+
+    // One collection as seen by its start event, so the end event can
+    // report what it took and freed.
+    struct CycleRecord {
+        GCCycleKind kind = GCCycleKind::Minor;
+        uint64_t cycle = 0;
+        chrono::steady_clock::time_point start;
+        uint64_t objectsFreed = 0;
+        uint64_t bytesFreed = 0;
+    };
+
+    // The incremental cycle in progress, if any.
+    CycleRecord incrementalCycle;
+    bool incrementalCycleActive = false;
 }
 
 // Forward helpers
+static void foldThreadStates();
+template <typename Visit> static void forEachRootSlot(Visit visit);
 static void seedRoots();
+static bool rescanRoots();
 static bool doMarkStep();
 static bool doSweepStep();
 static int blockingMark();
-static int blockingSweep(unordered_set<GCObject*>& pool);
-static void promoteObject(GCObject* obj);
-static void adaptThresholds();
+static int blockingMinorMark();
+static GCObject* evacuate(GCObject* obj);
+static void minorVisitSlot(GCObject** slot);
+static void minorVisitValue(GCObject* obj);
+static int releaseNursery();
+static int blockingSweep(bool youngOnly);
+static uint32_t sweepPageCells(GCPage* page, uint32_t from, bool youngOnly, bool destroyed,
+                               int& budget, int& freed, bool& released);
+static void beginSweep();
+static void finishCycle();
+static void queueLazySweep();
+static int lazySweepClass(unsigned cls, bool all);
+static void finishLazySweep();
+static bool reclaimBackground();
+static void refillFromSweep(unsigned cls);
+static void rememberObject(GCObject* obj);
+static bool traceEphemerons();
+static void clearWeakRefs();
+static bool survivesMinor(GCObject* obj);
+static bool minorTraceEphemerons();
+static void updateWeakRefsMinor();
+static void rememberIfPointsYoung(GCObject* obj, const vector<GCObject*>& children);
+static void clearRememberedSet();
+static void pruneRememberedSet();
+static void dropYoungPage(GCPage* page);
+static void addHeapBytes(GCThreadState& t, size_t bytes);
+static void completeSweep();
+static void compactHeap();
+static void updateHeapGoal();
+static void computeHeapGoal();
+static void startPacing();
+static void adaptBudgets(Phase stepPhase, chrono::nanoseconds elapsed);
+static CycleRecord beginCycle(GCCycleKind kind, uint64_t cycle);
+static chrono::nanoseconds endCycle(const CycleRecord& record);
+static void fireCycleEvent(const GCCycleEvent& event);
+
+namespace {
+    // Stops the world for one collection or incremental step and records
+    // its length, stop included, in the pause histogram. Nested pauses are
+    // part of the outermost one.
+    struct CollectorPause {
+        CollectorPause() = default;
+        ~CollectorPause() {
+            --pauseDepth;
+            if (outermost) totals.pauses.record(chrono::steady_clock::now() - start);
+        }
+        CollectorPause(const CollectorPause&) = delete;
+        CollectorPause& operator=(const CollectorPause&) = delete;
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        bool outermost = pauseDepth++ == 0;
+        WorldStop stop; // destroyed after the body above, so it records while stopped
+    };
+
+    // Times one incremental step for the pacer. Declared after the step's
+    // WorldStop, so it finishes while the world is still stopped.
+    struct StepTimer {
+        explicit StepTimer(Phase stepPhase) : stepPhase(stepPhase) { stepUnits = 0; }
+        ~StepTimer() {
+            chrono::nanoseconds elapsed = chrono::steady_clock::now() - start;
+            if (stepPhase == Phase::Sweep) {
+                totals.sweepTime += elapsed;
+            } else if (stepPhase != Phase::Idle) {
+                totals.markTime += elapsed;
+            }
+            if (pauseTarget.count() > 0) adaptBudgets(stepPhase, elapsed);
+        }
+        StepTimer(const StepTimer&) = delete;
+        StepTimer& operator=(const StepTimer&) = delete;
+
+        Phase stepPhase;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    };
+}
 
-void GC::init(int markB, int sweepB, int allocThreshold, int youngThresh) {
+void GC::init(int markB, int sweepB, int allocThreshold, int /*youngThresh*/) {
     markBudget = markB;
     sweepBudget = sweepB;
     allocationThreshold = allocThreshold;
-    youngThreshold = youngThresh;
     LOG("GC initialized: markBudget=" << markBudget << " sweepBudget=" << sweepBudget
-        << " allocThreshold=" << allocationThreshold << " youngThreshold=" << youngThreshold);
+        << " allocThreshold=" << allocationThreshold);
 }
 
 void GC::registerObject(GCObject* obj) {
     if (!obj) return;
-    youngObjects.insert(obj);
+    GCThreadState& t = self();
+    if (GCHeap::inNursery(obj)) {
+        // Nursery objects are found by tracing; only their start is recorded.
+        GCHeap::recordNurseryObject(obj);
+        ++t.nurseryAllocated;
+        if (allocationThreshold > 0 && ++t.allocationCounter >= allocationThreshold) {
+            t.allocationCounter = 0;
+            startIncrementalCollect();
+        }
+        return;
+    }
+    GCPage* page = GCHeap::pageOf(obj);
+    uint32_t index = page->indexOf(obj);
+
+    // Allocate black while a cycle is running: the new object is reachable
+    // from whoever is constructing it, and the sweep must not free it.
+    // Marks are only cleared when the next cycle starts. The page belongs to
+    // this thread's cursor, so only this thread writes its alloc and young
+    // words.
+    if (phase == Phase::Marking || phase == Phase::Sweep) {
+        page->markBits.trySetAtomic(index);
+        page->allocBits.setRelease(index);
+    } else {
+        page->allocBits.set(index);
+    }
+    t.bytesAllocated += page->cellSize;
+    addHeapBytes(t, page->cellSize);
+
+    // Large objects skip the young generation: minor collections never
+    // visit them and they are never copied or promoted. They are paced by
+    // their bytes alone, not by the object-count trigger.
+    if (page->sizeClass == GCHeap::kLargeClass) {
+        ++t.largeAllocated;
+        return;
+    }
+
+    page->youngBits.set(index);
+    ++t.youngAllocated;
+    if (page->youngIndex < 0) {
+        GCHeap::Lock lock;
+        if (page->youngIndex < 0) {
+            page->youngIndex = static_cast<int32_t>(youngPages.size());
+            youngPages.push_back(page);
+        }
+    }
 
     // **drive collections from allocations**
-    allocationCounter++;
-    if (allocationCounter >= allocationThreshold) {
-        allocationCounter = 0;
+    if (allocationThreshold > 0 && ++t.allocationCounter >= allocationThreshold) {
+        t.allocationCounter = 0;
         startIncrementalCollect();
     }
 }
 
+void GC::unregisterObject(GCObject* obj) {
+    if (!obj) return;
+    // Throwing constructors are rare, so the counts are fixed up with the
+    // world stopped, after every thread's pending counts have been folded.
+    WorldStop stop;
+    if (GCHeap::inNursery(obj)) {
+        // Nothing was recorded if the throw came before GCObject's constructor.
+        if (!GCHeap::isNurseryObject(obj)) return;
+        --nurseryCount;
+        --totals.objectsAllocated;
+        return;
+    }
+    GCPage* page = GCHeap::pageOf(obj);
+    uint32_t index = page->indexOf(obj);
+    // Nothing was recorded if the throw came before GCObject's constructor.
+    if (!page->allocBits.test(index)) return;
+
+    if (page->sizeClass == GCHeap::kLargeClass) {
+        --largeCount;
+    } else if (page->youngBits.test(index)) {
+        --youngCount;
+    } else {
+        --oldCount;
+    }
+    --totals.objectsAllocated;
+    totals.bytesAllocated -= page->cellSize;
+    heapUsed.fetch_sub(page->cellSize, memory_order_relaxed);
+}
+
+void GC::registerNurseryStorage(GCObject* obj) {
+    self().nurseryStorage.push_back(obj);
+}
+
+void GC::setNurserySize(size_t bytes) {
+    WorldStop stop;
+    GCHeap::setNurserySize(bytes);
+}
+
 void GC::registerRoot(GCRefBase* r) {
-    if (!r) return;
-    roots.insert(r);
+    if (!r || r->rootThread) return;
+    assert(!GCHeap::inNursery(r) && "movable objects must not hold root GCRefs");
+    GCThreadState& t = self();
+    {
+        RootGuard guard(t);
+        r->rootThread = &t;
+        r->rootIndex = static_cast<int>(t.roots.size());
+        t.roots.push_back(r);
+    }
+
+    // A root created after seedRoots() must still be traced, otherwise the
+    // sweep would free an object the mutator can reach. Concurrent cycles
+    // do not need this: such an object was either reachable from the
+    // snapshot or allocated black.
+    if (phase == Phase::Marking && !snapshotActive) {
+        GCObject* obj = r->getObject();
+        if (obj && GCHeap::tryMarkAtomic(obj)) {
+            t.gray.push_back(obj);
+        }
+    }
 }
 
 void GC::unregisterRoot(GCRefBase* r) {
-    roots.erase(r);
+    if (!r || !r->rootThread) return;
+    // The root may live in another thread's table.
+    GCThreadState& t = *r->rootThread;
+    RootGuard guard(t);
+    GCRefBase* last = t.roots.back();
+    t.roots[r->rootIndex] = last;
+    last->rootIndex = r->rootIndex;
+    t.roots.pop_back();
+    r->rootIndex = -1;
+    r->rootThread = nullptr;
+}
+
+void GC::registerWeakRef(GCWeakRefBase* r) {
+    if (!r || r->weakThread) return;
+    assert(!GCHeap::inNursery(r) && "movable objects must not hold GCWeakRefs");
+    GCThreadState& t = self();
+    RootGuard guard(t);
+    r->weakThread = &t;
+    r->weakIndex = static_cast<int>(t.weakRefs.size());
+    t.weakRefs.push_back(r);
+}
+
+void GC::unregisterWeakRef(GCWeakRefBase* r) {
+    if (!r || !r->weakThread) return;
+    GCThreadState& t = *r->weakThread;
+    RootGuard guard(t);
+    GCWeakRefBase* last = t.weakRefs.back();
+    t.weakRefs[r->weakIndex] = last;
+    last->weakIndex = r->weakIndex;
+    t.weakRefs.pop_back();
+    r->weakIndex = -1;
+    r->weakThread = nullptr;
+}
+
+void GC::registerEphemeronTable(GCEphemeronTable* table) {
+    lock_guard<mutex> guard(ephemeronLock);
+    ephemeronTables.push_back(table);
+}
+
+void GC::unregisterEphemeronTable(GCEphemeronTable* table) {
+    lock_guard<mutex> guard(ephemeronLock);
+    erase(ephemeronTables, table);
+}
+
+void GC::parkAtSafepoint() {
+    GCThreads::park(GCThreadState::Mode::Parked);
+    GCThreads::unpark();
+}
+
+void GC::enterSafeRegion() {
+    GCThreads::park(GCThreadState::Mode::Safe);
+}
+
+void GC::leaveSafeRegion() {
+    GCThreads::unpark();
+}
+
+GCThreadState& GCThreads::attach() {
+    unique_lock<mutex> guard(threadsLock);
+    threadsChanged.wait(guard, [] { return !GC::safepointRequested.load(memory_order_relaxed); });
+    GCThreadState* state = nullptr;
+    for (auto& t : threadStates) {
+        if (t->mode == GCThreadState::Mode::Detached) {
+            state = t.get();
+            break;
+        }
+    }
+    if (!state) {
+        threadStates.push_back(make_unique<GCThreadState>());
+        state = threadStates.back().get();
+    }
+    state->mode = GCThreadState::Mode::Running;
+    currentThread = state;
+    (void)&threadExit;
+    return *state;
+}
+
+void GCThreads::detach() {
+    if (!currentThread) return;
+    park(GCThreadState::Mode::Parked);
+    {
+        // Nothing can stop the world until the thread is marked detached, so
+        // its allocation buffers are released while it still counts as
+        // parked.
+        unique_lock<mutex> guard(threadsLock);
+        threadsChanged.wait(guard, [] { return !GC::safepointRequested.load(memory_order_relaxed); });
+        GCHeap::releaseThread();
+        currentThread->mode = GCThreadState::Mode::Detached;
+        currentThread->shadow = nullptr;
+    }
+    GCShadowStack& stack = GCRootScope::stack;
+    while (GCShadowStack::Segment* seg = stack.first) {
+        stack.first = seg->next;
+        delete seg;
+    }
+    stack = GCShadowStack{};
+    threadsChanged.notify_all();
+    currentThread = nullptr;
+}
+
+void GCThreads::park(GCThreadState::Mode mode) {
+    GCThreadState& me = self();
+    {
+        lock_guard<mutex> guard(threadsLock);
+        me.mode = mode;
+    }
+    threadsChanged.notify_all();
+}
+
+void GCThreads::unpark() {
+    unique_lock<mutex> guard(threadsLock);
+    threadsChanged.wait(guard, [] { return !GC::safepointRequested.load(memory_order_relaxed); });
+    currentThread->mode = GCThreadState::Mode::Running;
+}
+
+void GCThreads::stop() {
+    if (stopDepth++ > 0) return;
+    GCThreadState& me = self();
+    unique_lock<mutex> guard(threadsLock);
+    // Another thread may be stopping the world already; park until it is done.
+    while (GC::safepointRequested.load(memory_order_relaxed)) {
+        me.mode = GCThreadState::Mode::Parked;
+        threadsChanged.notify_all();
+        threadsChanged.wait(guard, [] { return !GC::safepointRequested.load(memory_order_relaxed); });
+        me.mode = GCThreadState::Mode::Running;
+    }
+    GC::safepointRequested.store(true, memory_order_relaxed);
+    threadsChanged.wait(guard, [&] {
+        return all_of(threadStates.begin(), threadStates.end(), [&](const unique_ptr<GCThreadState>& t) {
+            return t.get() == &me || t->mode != GCThreadState::Mode::Running;
+        });
+    });
+    GCHeap::worldStopped = true;
+    guard.unlock();
+    foldThreadStates();
+}
+
+void GCThreads::resume() {
+    if (--stopDepth > 0) return;
+    {
+        lock_guard<mutex> guard(threadsLock);
+        GCHeap::worldStopped = false;
+        GC::safepointRequested.store(false, memory_order_relaxed);
+    }
+    threadsChanged.notify_all();
+}
+
+void GCRootScope::grow() {
+    GCShadowStack::Segment* cur = stack.current();
+    GCShadowStack::Segment* next = cur ? cur->next : stack.first;
+    if (!next) {
+        next = new GCShadowStack::Segment();
+        if (cur) {
+            cur->next = next;
+        } else {
+            stack.first = next;
+            self().shadow = &stack;
+        }
+    }
+    stack.top = next->slots;
+    stack.limit = next->slots + GCShadowStack::kSegmentSlots;
+}
+
+// Moves what the mutators recorded since the last stop into the
+// collector's own state.
+static void foldThreadStates() {
+    for (auto& t : threadStates) {
+        size_t young = exchange(t->youngAllocated, 0);
+        size_t nursery = exchange(t->nurseryAllocated, 0);
+        size_t large = exchange(t->largeAllocated, 0);
+        youngCount += young;
+        nurseryCount += nursery;
+        largeCount += large;
+        totals.objectsAllocated += young + nursery + large;
+        totals.bytesAllocated += exchange(t->bytesAllocated, 0);
+        heapUsed.fetch_add(exchange(t->heapBytesPending, 0), memory_order_relaxed);
+        rememberedSet.insert(rememberedSet.end(), t->remembered.begin(), t->remembered.end());
+        t->remembered.clear();
+        markStack.insert(markStack.end(), t->gray.begin(), t->gray.end());
+        t->gray.clear();
+        overwrittenBuffer.insert(overwrittenBuffer.end(), t->overwritten.begin(), t->overwritten.end());
+        t->overwritten.clear();
+        nurseryStorage.insert(nurseryStorage.end(), t->nurseryStorage.begin(), t->nurseryStorage.end());
+        t->nurseryStorage.clear();
+    }
 }
 
 void GC::collectNow(bool major) {
+    CollectorPause pause;
+    GCTraceScope trace(GCTracePoint::Collection);
+    trace.value = major;
     LOG("collectNow called (major=" << major << ")");
+    // Finish any incremental cycle first so its marks and sweep position
+    // cannot be mixed up with the blocking collection.
+    if (phase != Phase::Idle) {
+        if (snapshotActive) GCMarker::backgroundIdle(true);
+        if (phase == Phase::Sweep && sweepMode == GCSweepMode::Background) GCSweeper::wait();
+        while (!incrementalCollectStep()) {}
+    }
+    // Pending lazy sweeps need the previous marks, which both kinds of
+    // collection are about to overwrite.
+    finishLazySweep();
     if (major) {
+        CycleRecord cycle = beginCycle(GCCycleKind::Major, ++totals.majorCollections);
+        // Empty the nursery first so the full trace only sees page objects.
+        if (GCHeap::nurseryUsed()) blockingMinorMark();
         // Mark from roots (blocking)
         blockingMark();
-        lastMajorCollected = blockingSweep(youngObjects) + blockingSweep(oldObjects);
-        adaptThresholds();
-    } else {
-        blockingMark();
-        lastMinorCollected = blockingSweep(youngObjects);
-        // Handle promotions and clear old marks
-        vector<GCObject*> survivors;
-        survivors.reserve(youngObjects.size());
-        for (auto* o : youngObjects) {
-            if (o->marked) {
-                o->survivalCount++;
-                if (o->survivalCount >= promotedSurvivals) {
-                    survivors.push_back(o);
-                } else {
-                    // clear mark/black for next cycle
-                    o->marked = false;
-                    o->black = false;
-                }
-            } else {
-                // not marked => already freed by blockingSweep
-            }
+        updateHeapGoal();
+        auto marked = chrono::steady_clock::now();
+        totals.markTime += marked - cycle.start;
+        if (sweepMode != GCSweepMode::Incremental) {
+            // Lazy and background sweeps return to the mutator right away.
+            beginSweep();
+        } else {
+            clearWeakRefs();
+            blockingSweep(false);
+            pruneRememberedSet();
         }
-        // Promote survivors
-        for (GCObject* p : survivors) {
-            if (youngObjects.erase(p) > 0) {
-                oldObjects.insert(p);
-                p->generation = Generation::Old;
-                p->survivalCount = 0;
-                p->marked = false;
-                p->black = false;
-            }
+        totals.sweepTime += chrono::steady_clock::now() - marked;
+        if (compaction) {
+            // Objects are only moved once every dead one is gone.
+            completeSweep();
+            auto compactStart = chrono::steady_clock::now();
+            compactHeap();
+            totals.compactTime += chrono::steady_clock::now() - compactStart;
         }
-
-        for (auto* o : oldObjects) { o->marked = false; o->black = false; }
-        adaptThresholds();
+        endCycle(cycle);
+    } else {
+        CycleRecord cycle = beginCycle(GCCycleKind::Minor, ++totals.minorCollections);
+        // Trace only from roots and the remembered set into the young
+        // generation; old objects are treated as live.
+        blockingMinorMark();
+        // Sweeping the young generation also ages and promotes survivors.
+        blockingSweep(true);
+        pruneRememberedSet();
+        totals.minorTime += endCycle(cycle);
     }
 }
 
 void GC::startIncrementalCollect() {
-    if (phase != Phase::Idle) return;
+    Phase idle = Phase::Idle;
+    if (!phase.compare_exchange_strong(idle, Phase::MarkRoots)) return;
+    if (pauseTarget.count() > 0) rootScanPending.store(true, memory_order_relaxed);
     LOG("Starting incremental collect");
-    phase = Phase::MarkRoots;
-    markStack.clear();
-    sweepingOld = false;
-    sweepPool = &youngObjects;
-    sweepIt = sweepPool->begin();
 }
 
 bool GC::incrementalCollectStep() {
+    if (phase == Phase::Idle) return true;
+    CollectorPause pause;
+    StepTimer timer(phase);
+    GCTraceScope trace(GCTracePoint::IncrementalStep);
+    trace.value = static_cast<uint32_t>(phase.load());
+    if (phase != Phase::Idle) ++totals.incrementalSteps;
     switch (phase) {
         case Phase::Idle:
             return true;
         case Phase::MarkRoots: {
+            rootScanPending.store(false, memory_order_relaxed);
+            incrementalCycle = beginCycle(GCCycleKind::Incremental, ++totals.incrementalCycles);
+            incrementalCycleActive = true;
+            markStack.clear();
+            finishLazySweep();
+            // Evacuate the nursery and keep it closed for the rest of the
+            // cycle, so marking only ever sees non-moving page objects.
+            if (GCHeap::nurseryUsed()) blockingMinorMark();
+            GCHeap::closeNursery();
+            GCHeap::clearMarks();
             seedRoots();
             phase = Phase::Marking;
+            if (pauseTarget.count() > 0) {
+                startPacing();
+                allocationHookActive.store(true, memory_order_relaxed);
+            }
 
-            {
-                bool more = doMarkStep();
-                if (!more) {
-                    sweepPool = &youngObjects;
-                    sweepIt = sweepPool->begin();
-                    sweepingOld = false;
-                    phase = Phase::Sweep;
-                }
+            if (concurrentMarking) {
+                // The root scan is the only marking done in this pause. The
+                // remembered set is kept up to date by the write barrier
+                // instead of being rebuilt by the trace.
+                snapshotActive = true;
+                GCMarker::startBackground(markStack);
+                return false;
             }
+
+            clearRememberedSet();
+
+            if (!doMarkStep() && !rescanRoots() && !traceEphemerons()) beginSweep();
             return false;
         }
         case Phase::Marking: {
-            bool more = doMarkStep();
-            if (!more) {
-                sweepPool = &youngObjects;
-                sweepIt = sweepPool->begin();
-                sweepingOld = false;
-                phase = Phase::Sweep;
+            if (snapshotActive) {
+                if (!overwrittenBuffer.empty()) GCMarker::shade(overwrittenBuffer);
+                if (!GCMarker::backgroundIdle(false)) return false;
+
+                // Final remark: the collector thread has drained everything
+                // it was given, so only the unflushed buffer is left.
+                snapshotActive = false;
+                size_t scanned = GCMarker::stopBackground();
+                for (GCObject* o : overwrittenBuffer) {
+                    if (GCHeap::tryMark(o)) markStack.push_back(o);
+                }
+                overwrittenBuffer.clear();
+                do {
+                    while (doMarkStep()) {}
+                } while (traceEphemerons());
+                LOG("Concurrent mark scanned " << scanned << " objects before the final remark");
+                beginSweep();
+                return false;
             }
+            if (!doMarkStep() && !rescanRoots() && !traceEphemerons()) beginSweep();
             return false;
         }
         case Phase::Sweep: {
-            bool more = doSweepStep();
+            bool more = sweepMode == GCSweepMode::Background ? reclaimBackground() : doSweepStep();
             if (!more) {
-                if (!sweepingOld) {
-                    sweepingOld = true;
-                    sweepPool = &oldObjects;
-                    sweepIt = sweepPool->begin();
-                    more = doSweepStep();
-                }
-                if (!more) {
-                    phase = Phase::Idle;
-                    LOG("Incremental collection finished");
-                    adaptThresholds();
-                    return true;
-                }
+                finishCycle();
+                return true;
             }
             return false;
         }
@@ -195,192 +838,1179 @@ bool GC::incrementalCollectStep() {
 
 
 void GC::writeBarrier(GCObject* owner, GCObject* child) {
-    if (!owner || !child) return;
+    if (!owner || !child || GCHeap::inNursery(owner)) return;
+    GCPage* ownerPage = GCHeap::pageOf(owner);
+    cellBarrier(ownerPage, ownerPage->indexOf(owner), child);
+}
+
+void GC::writeBarrierAt(const void* slot, GCObject* child) {
+    if (!child || GCHeap::inNursery(slot)) return;
+    GCPage* ownerPage = GCHeap::pageOf(slot);
+    // A field past the first page of a large object masks to an address
+    // inside the object itself, where there is no header to update.
+    if (!GCHeap::isPage(ownerPage)) {
+        throw length_error("GCMember fields must lie in the first 60 KiB of an object");
+    }
+    cellBarrier(ownerPage, ownerPage->indexOf(slot), child);
+}
+
+void GC::writeBarrierRange(GCObject* owner, GCObject* const* children, size_t count) {
+    if (!owner || count == 0 || GCHeap::inNursery(owner)) return;
+    GCPage* ownerPage = GCHeap::pageOf(owner);
+    uint32_t ownerIndex = ownerPage->indexOf(owner);
+
+    // One young child is enough to remember the owner.
+    if (!ownerPage->youngBits.test(ownerIndex) && !ownerPage->rememberedBits.test(ownerIndex)) {
+        for (size_t i = 0; i < count; ++i) {
+            if (!children[i] || !GCHeap::isYoung(children[i])) continue;
+            if (ownerPage->rememberedBits.trySetAtomic(ownerIndex)) {
+                self().remembered.push_back(owner);
+                GC_TRACE_INSTANT(WriteBarrier, 1);
+            }
+            break;
+        }
+    }
+
+    if (phase != Phase::Marking || snapshotActive || !ownerPage->markBits.test(ownerIndex)) return;
+    vector<GCObject*>& gray = self().gray;
+    size_t shaded = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (children[i] && GCHeap::tryMarkAtomic(children[i])) {
+            gray.push_back(children[i]);
+            ++shaded;
+        }
+    }
+    if (shaded) GC_TRACE_INSTANT(WriteBarrier, 2);
+}
+
+void GC::cellBarrier(GCPage* ownerPage, uint32_t ownerIndex, GCObject* child) {
+    // Generational barrier: remember old objects that gain a young child.
+    if (!ownerPage->youngBits.test(ownerIndex) && !ownerPage->rememberedBits.test(ownerIndex)
+        && GCHeap::isYoung(child) && ownerPage->rememberedBits.trySetAtomic(ownerIndex)) {
+        self().remembered.push_back(reinterpret_cast<GCObject*>(ownerPage->cellAt(ownerIndex)));
+        GC_TRACE_INSTANT(WriteBarrier, 1);
+    }
+
+    // Incremental barrier: never let a marked object point at an unmarked
+    // one. Concurrent cycles rely on the deletion barrier instead.
+    if (phase != Phase::Marking || snapshotActive) return;
+    if (ownerPage->markBits.test(ownerIndex) && GCHeap::tryMarkAtomic(child)) {
+        self().gray.push_back(child);
+        GC_TRACE_INSTANT(WriteBarrier, 2);
+    }
+}
+
+
+void GC::recordOverwritten(GCObject* obj) {
+    vector<GCObject*>& buffer = self().overwritten;
+    buffer.push_back(obj);
+    if (buffer.size() >= kOverwrittenBatch) GCMarker::shade(buffer);
+}
+
+void GC::setConcurrentMarking(bool enabled) { concurrentMarking = enabled; }
+
+void GC::setSweepMode(GCSweepMode mode) {
+    WorldStop stop;
+    // Finish work queued under the old mode before switching.
+    completeSweep();
+    sweepMode = mode;
+    GCHeap::refillHook = mode == GCSweepMode::Incremental ? nullptr : &refillFromSweep;
+}
+void GC::setFinalization(GCFinalization mode) {
+    {
+        WorldStop stop;
+        finalization = mode;
+    }
+    GCFinalizer::setBackground(mode == GCFinalization::Background);
+    // Objects queued under the old mode must not wait for a drain that may
+    // never come.
+    if (mode == GCFinalization::Inline) GCFinalizer::drain();
+}
+
+size_t GC::runFinalizers(chrono::nanoseconds budget) {
+    return GCFinalizer::run(budget);
+}
+
+size_t GC::pendingFinalizers() {
+    return GCFinalizer::pending();
+}
+
+void GC::setCompaction(bool enabled) {
+    WorldStop stop;
+    compaction = enabled;
+}
+
+void GC::setPauseTarget(chrono::microseconds maxPause) {
+    WorldStop stop;
+    pauseTarget = maxPause;
+    markNsPerUnit = 0;
+    sweepNsPerUnit = 0;
+    bool pacing = maxPause.count() > 0;
+    rootScanPending.store(pacing && phase == Phase::MarkRoots, memory_order_relaxed);
+    refreshAllocationHook();
+}
+
+void GC::setHeapPolicy(const GCHeapPolicy& newPolicy) {
+    WorldStop stop;
+    policy = newPolicy;
+    softTarget = policy.softLimitBytes;
+    if (policy.useCgroupLimit) {
+        size_t cgroup = cgroupMemoryLimit() / 4 * 3;
+        if (cgroup && (!softTarget || cgroup < softTarget)) softTarget = cgroup;
+    }
+    hardLimit.store(policy.hardLimitBytes, memory_order_relaxed);
+    hardLimitPending.store(false, memory_order_relaxed);
+    hardLimitExhausted.store(false, memory_order_relaxed);
+    computeHeapGoal();
+    refreshAllocationHook();
+}
+
+GCHeapPolicy GC::heapPolicy() {
+    WorldStop stop;
+    return policy;
+}
+
+size_t GC::heapBytes() { return heapUsed.load(memory_order_relaxed); }
+
+size_t GC::heapGoal() { return heapGoalBytes.load(memory_order_relaxed); }
+
+size_t GC::cgroupMemoryLimit() {
+    // cgroup v2 writes "max" when unlimited; v1 writes a huge page-rounded
+    // number instead.
+    for (const char* path : {"/sys/fs/cgroup/memory.max", "/sys/fs/cgroup/memory/memory.limit_in_bytes"}) {
+        ifstream in(path);
+        string value;
+        if (!(in >> value)) continue;
+        if (value == "max") return 0;
+        char* end = nullptr;
+        unsigned long long bytes = strtoull(value.c_str(), &end, 10);
+        if (*end != '\0') return 0;
+        return bytes >= (1ULL << 60) ? 0 : static_cast<size_t>(bytes);
+    }
+    return 0;
+}
+
+void GC::refreshAllocationHook() {
+    bool pacing = pauseTarget.count() > 0 && (phase == Phase::Marking || phase == Phase::Sweep);
+    allocationHookActive.store(pacing || hardLimit.load(memory_order_relaxed) > 0, memory_order_relaxed);
+}
+
+void GC::scanRootsAtSafepoint() {
+    if (phase == Phase::MarkRoots) {
+        incrementalCollectStep();
+    } else {
+        rootScanPending.store(false, memory_order_relaxed);
+    }
+}
+
+void GC::collectAtHardLimit() {
+    hardLimitPending.store(false, memory_order_relaxed);
+    {
+        CollectorPause pause;
+        collectNow(true);
+        completeSweep();
+    }
+    size_t limit = hardLimit.load(memory_order_relaxed);
+    hardLimitExhausted.store(limit && heapUsed.load(memory_order_relaxed) >= limit, memory_order_relaxed);
+}
+
+void GC::beforeAllocateSlow(size_t bytes) {
+    if (inAllocationHook) return;
+    GCThreadState& t = self();
+
+    // Collecting here could free the object whose constructor is
+    // allocating, and whatever the caller holds in raw pointers. The full
+    // collection waits for the next safepoint; only an allocation that
+    // still does not fit after it fails.
+    size_t limit = hardLimit.load(memory_order_relaxed);
+    if (limit && heapUsed.load(memory_order_relaxed) + t.heapBytesPending + bytes > limit) {
+        hardLimitPending.store(true, memory_order_relaxed);
+        if (hardLimitExhausted.load(memory_order_relaxed)) {
+            LOG("Heap limit of " << limit << " bytes reached");
+            throw bad_alloc();
+        }
+    }
+
+    Phase current = phase;
+    if (pauseTarget.count() == 0 || (current != Phase::Marking && current != Phase::Sweep)) {
+        refreshAllocationHook();
+        return;
+    }
+    t.workDebt += allocationTax * static_cast<double>(bytes);
+    int budget = current == Phase::Marking ? markBudget : sweepBudget;
+    if (t.workDebt < budget) return;
+    t.workDebt -= budget;
+    inAllocationHook = true;
+    incrementalCollectStep();
+    inAllocationHook = false;
+}
 
-    if (owner->marked && !child->marked) {
-        child->marked = true;
-        markStack.push_back(child);
-        LOG("writeBarrier: pushed child to markStack");
+GCStats GC::stats() {
+    WorldStop stop;
+    totals.rangeSlotsMarked += markTracer.takeRangeSlots() + GCMarker::takeRangeSlots();
+    GCStats s = totals;
+    // The nursery's bytes are counted when it is reset; add what it holds now.
+    s.bytesAllocated += GCHeap::nurseryBytes();
+    for (GCPage* page : GCHeap::pages()) {
+        if (page->sizeClass == GCHeap::kLargeClass) {
+            if (page->allocBits.test(0)) s.largeBytes += page->mappedBytes;
+            continue;
+        }
+        size_t young = 0;
+        size_t old = 0;
+        for (uint32_t w = 0; w < page->bitmapWords(); ++w) {
+            young += popcount(page->allocBits.words[w] & page->youngBits.words[w]);
+            old += popcount(page->allocBits.words[w] & ~page->youngBits.words[w]);
+        }
+        s.youngBytes += young * page->cellSize;
+        s.oldBytes += old * page->cellSize;
     }
+    s.youngObjects = youngCount;
+    s.oldObjects = oldCount;
+    s.largeObjects = largeCount;
+    s.nurseryObjects = nurseryCount;
+    s.nurseryBytes = GCHeap::nurseryBytes();
+    s.heapBytes = heapUsed.load(memory_order_relaxed);
+    s.heapGoal = heapGoalBytes.load(memory_order_relaxed);
+    s.mappedBytes = GCHeap::mappedBytes();
+    forEachRootSlot([&s](GCObject**) { ++s.roots; });
+    return s;
 }
 
+bool GC::dumpHeap(const string& path) {
+    CollectorPause pause;
+    GCTraceScope trace(GCTracePoint::HeapDump);
+    // As in collectNow(): no marks or sweep position may be left half done.
+    if (phase != Phase::Idle) {
+        if (snapshotActive) GCMarker::backgroundIdle(true);
+        if (phase == Phase::Sweep && sweepMode == GCSweepMode::Background) GCSweeper::wait();
+        while (!incrementalCollectStep()) {}
+    }
+    completeSweep();
+    // Nursery objects have no cells to enumerate.
+    if (GCHeap::nurseryUsed()) collectNow(false);
+
+    vector<GCObject*> roots;
+    forEachRootSlot([&roots](GCObject** slot) {
+        if (*slot) roots.push_back(*slot);
+    });
+    trace.value = static_cast<uint32_t>(youngCount + oldCount + largeCount);
+    return GCHeapSnapshot::write(path, roots);
+}
+
+int GC::addCycleHook(function<void(const GCCycleEvent&)> hook) {
+    WorldStop stop;
+    cycleHooks.emplace_back(++nextCycleHookId, std::move(hook));
+    return nextCycleHookId;
+}
+
+void GC::removeCycleHook(int id) {
+    WorldStop stop;
+    erase_if(cycleHooks, [id](const auto& entry) { return entry.first == id; });
+}
 
 void GC::setMarkBudget(int b) { markBudget = b; }
+void GC::setMarkWorkers(unsigned count) { GCMarker::setWorkerCount(count); }
 void GC::setSweepBudget(int b) { sweepBudget = b; }
 
+// Calls visit(GCObject**) for every GCRef root and every live GCLocal slot
+// of every thread. The world must be stopped.
+template <typename Visit>
+static void forEachRootSlot(Visit visit) {
+    for (auto& t : threadStates) {
+        for (GCRefBase* r : t->roots) visit(r->slot());
+        if (!t->shadow) continue;
+        const GCShadowStack& stack = *t->shadow;
+        GCShadowStack::Segment* cur = stack.current();
+        for (GCShadowStack::Segment* seg = cur ? stack.first : nullptr; seg; seg = seg->next) {
+            GCObject** end = seg == cur ? stack.top : seg->slots + GCShadowStack::kSegmentSlots;
+            for (GCObject** slot = seg->slots; slot != end; ++slot) visit(slot);
+            if (seg == cur) break;
+        }
+    }
+}
+
 static void seedRoots() {
-    LOG("seedRoots: scanning roots (" << roots.size() << ")");
-    for (GCRefBase* r : roots) {
-        if (!r) continue;
-        GCObject* obj = r->getObject();
-        if (obj && !obj->marked) {
-            obj->marked = true;
+    GCTraceScope trace(GCTracePoint::RootScan);
+    size_t before = markStack.size();
+    forEachRootSlot([](GCObject** slot) {
+        GCObject* obj = *slot;
+        if (obj && GCHeap::tryMark(obj)) {
             markStack.push_back(obj);
         }
-    }
-    LOG("seedRoots pushed " << markStack.size() << " objects");
+    });
+    trace.value = static_cast<uint32_t>(markStack.size() - before);
+}
+
+// Incremental cycles do not barrier stores into roots or GCLocals, so the
+// roots are scanned again once the mark stack runs dry. The sweep may only
+// start when that turns up nothing new.
+static bool rescanRoots() {
+    seedRoots();
+    return !markStack.empty();
 }
 
 static bool doMarkStep() {
+    GCTraceScope trace(GCTracePoint::MarkStep);
     int work = 0;
     while (!markStack.empty() && work < markBudget) {
         GCObject* obj = markStack.back();
         markStack.pop_back();
-        obj->black = true;
-
-        vector<GCObject*> children;
-        obj->traceChildren(children);
-        for (GCObject* c : children) {
-            if (c && !c->marked) {
-                c->marked = true;
-                markStack.push_back(c);
-            }
-        }
+
+        // Children are marked and pushed as they are visited.
+        markTracer.reset();
+        obj->trace(markTracer);
+        if (markTracer.pointsYoung() && !GCHeap::isYoung(obj)) rememberObject(obj);
         ++work;
     }
-    bool more = !markStack.empty();
-    LOG("doMarkStep did " << work << " units; more=" << more);
-    return more;
+    stepUnits += work;
+    trace.value = static_cast<uint32_t>(work);
+    return !markStack.empty();
 }
 
 static bool doSweepStep() {
-    if (!sweepPool) return false;
-    int work = 0;
-    if (sweepIt == sweepPool->end()) sweepIt = sweepPool->begin();
+    GCTraceScope trace(GCTracePoint::SweepStep);
+    int budget = sweepBudget;
+    int freed = 0;
+    const vector<GCPage*>& pages = GCHeap::pages();
 
-    while (sweepIt != sweepPool->end() && work < sweepBudget) {
-        GCObject* obj = *sweepIt;
-        if (!obj->marked) {
-            for (GCRefBase* r : roots) {
-                if (r) r->nullIfPointsTo(obj);
+    // Marking is complete, so a dead object can only be referenced by other
+    // dead objects. Nothing live needs to be patched and each dead object is
+    // simply destroyed in place.
+    while (sweepPageIndex < pages.size() && budget > 0) {
+        bool released = false;
+        sweepCell = sweepPageCells(pages[sweepPageIndex], sweepCell, false, false, budget, freed, released);
+        if (released) {
+            // The last page moved into this slot and has not been swept yet.
+            sweepCell = 0;
+        } else if (sweepCell >= pages[sweepPageIndex]->cellCount) {
+            ++sweepPageIndex;
+            sweepCell = 0;
+        }
+    }
+
+    stepUnits += sweepBudget - budget;
+    trace.value = static_cast<uint32_t>(sweepBudget - budget);
+    return sweepPageIndex < pages.size();
+}
+
+// Sweeps the registered cells of one page starting at cell `from`, a
+// bitmap word at a time. Dead cells are found as allocated & ~marked and are
+// the only objects touched. Young survivors age, or are promoted if they had
+// already aged, purely through bitmap operations. Stops once `budget` units
+// are spent and returns the cell to resume from, or cellCount when done.
+// `released` is set when freeing the object unmapped the page itself.
+// With `destroyed`, the background sweeper has already run the dead
+// objects' destructors and only their cells are freed. Outside Inline
+// finalization, dead objects are queued rather than destroyed, and a large
+// page is only unmapped once its object's destructor has run.
+static uint32_t sweepPageCells(GCPage* page, uint32_t from, bool youngOnly, bool destroyed,
+                               int& budget, int& freed, bool& released) {
+    const uint32_t cellCount = page->cellCount;
+    const bool large = page->sizeClass == GCHeap::kLargeClass;
+    const uint32_t words = page->bitmapWords();
+
+    for (uint32_t w = from / 64; w < words; ++w) {
+        uint64_t range = ~uint64_t{0};
+        if (w == from / 64) range <<= from % 64;
+
+        const uint64_t young = page->youngBits.words[w];
+        uint64_t candidates = page->allocBits.words[w] & range;
+        if (youngOnly) candidates &= young;
+
+        // Every object visited, live or dead, costs one unit. If the budget
+        // runs out inside this word, stop at the first cell it cannot cover.
+        uint32_t stop = cellCount;
+        int count = popcount(candidates);
+        if (count > budget) {
+            uint64_t rest = candidates;
+            for (int k = 0; k < budget; ++k) rest &= rest - 1;
+            stop = w * 64 + static_cast<uint32_t>(countr_zero(rest));
+            candidates &= (uint64_t{1} << (stop % 64)) - 1;
+            count = budget;
+        }
+        budget -= count;
+        totals.objectsSwept += count;
+
+        const uint64_t marked = page->markBits.words[w];
+        const uint64_t liveYoung = candidates & young & marked;
+        const uint64_t promote = liveYoung & page->agedBits.words[w];
+        page->youngBits.store(w, young & ~promote);
+        page->agedBits.words[w] = (page->agedBits.words[w] & ~(candidates & young)) | (liveYoung & ~promote);
+        youngCount -= popcount(promote);
+        oldCount += popcount(promote);
+        totals.objectsPromoted += popcount(promote);
+        totals.bytesPromoted += popcount(promote) * uint64_t{page->cellSize};
+        if (promote) GC_TRACE_INSTANT(Promotion, popcount(promote));
+
+        // A newly promoted object may still point at younger survivors.
+        for (uint64_t bits = promote; bits; bits &= bits - 1) {
+            rememberObject(reinterpret_cast<GCObject*>(page->cellAt(w * 64 + countr_zero(bits))));
+        }
+
+        uint64_t dead = candidates & ~marked;
+        if (dead) {
+            heapUsed.fetch_sub(popcount(dead) * size_t{page->cellSize}, memory_order_relaxed);
+            totals.objectsFreed += popcount(dead);
+            totals.bytesFreed += popcount(dead) * uint64_t{page->cellSize};
+        }
+        while (dead) {
+            uint32_t i = w * 64 + static_cast<uint32_t>(countr_zero(dead));
+            dead &= dead - 1;
+            if (large) {
+                --largeCount;
+            } else if (young & (uint64_t{1} << (i % 64))) {
+                --youngCount;
+            } else {
+                --oldCount;
             }
-            for (GCObject* o : youngObjects) {
-                for (GCRefBase* mr : o->getMemberRefs()) {
-                    if (mr) mr->nullIfPointsTo(obj);
-                }
+            if (destroyed) {
+                GCHeap::deallocate(page->cellAt(i));
+            } else if (finalization != GCFinalization::Inline) {
+                // The cell stays reserved, but no longer holds an object as
+                // far as the collector is concerned, until the destructor
+                // has run and freed it.
+                page->allocBits.clear(i);
+                page->youngBits.clear(i);
+                page->markBits.clear(i);
+                page->agedBits.clear(i);
+                if (page->rememberedBits.test(i)) page->rememberedBits.clearAtomic(i);
+                finalizable.push_back(reinterpret_cast<GCObject*>(page->cellAt(i)));
+                ++freed;
+                if (large) break;
+                continue;
+            } else {
+                reinterpret_cast<GCObject*>(page->cellAt(i))->~GCObject();
+                GCHeap::deallocate(page->cellAt(i));
             }
-            for (GCObject* o : oldObjects) {
-                for (GCRefBase* mr : o->getMemberRefs()) {
-                    if (mr) mr->nullIfPointsTo(obj);
-                }
+            ++freed;
+            if (large) {
+                released = true;
+                return cellCount;
             }
+        }
 
-            auto itToErase = sweepIt++;
-            sweepPool->erase(itToErase);
-            delete obj;
-            ++work;
-            continue;
-        } else {
+        if (!finalizable.empty()) GCFinalizer::enqueue(finalizable);
+        if (stop != cellCount) return stop;
+        if (budget <= 0) return min((w + 1) * 64, cellCount);
+    }
+    return cellCount;
+}
 
-            if (!sweepingOld) {
-                obj->survivalCount++;
-                obj->marked = false;
-                obj->black = false;
-                if (obj->survivalCount >= promotedSurvivals) {
-                    GCObject* toPromote = obj;
-                    auto itCur = sweepIt++;
-                    sweepPool->erase(itCur);
-                    oldObjects.insert(toPromote);
-                    toPromote->generation = Generation::Old;
-                    toPromote->survivalCount = 0;
-                    toPromote->marked = false;
-                    toPromote->black = false;
-                    LOG("Promoted object during incremental sweep");
-                    ++work;
-                    continue;
-                } else {
-                    ++sweepIt;
-                }
-            } else {
-                obj->marked = false;
-                obj->black = false;
-                ++sweepIt;
-            }
+// Starts reclaiming dead objects after a completed major mark, in the
+// configured sweep mode.
+static void beginSweep() {
+    clearWeakRefs();
+    updateHeapGoal();
+    sweepPageIndex = 0;
+    sweepCell = 0;
+    if (sweepMode != GCSweepMode::Incremental) {
+        // The sweep outlives this pause, so no thread may allocate into a
+        // page until it has been swept. Every page starts out withdrawn and
+        // is handed back once its dead cells are free.
+        GCHeap::retireAllCursors();
+        GCHeap::withdrawPages();
+    }
+    switch (sweepMode) {
+        case GCSweepMode::Incremental:
+            phase = Phase::Sweep;
+            break;
+        case GCSweepMode::Lazy:
+            queueLazySweep();
+            finishCycle();
+            break;
+        case GCSweepMode::Background:
+            backgroundPages = GCHeap::pages();
+            backgroundReclaimed = 0;
+            GCSweeper::start(backgroundPages);
+            phase = Phase::Sweep;
+            break;
+    }
+}
+
+static void finishCycle() {
+    phase = Phase::Idle;
+    GCHeap::openNursery();
+    // Lazily swept pages may still hold dead remembered objects; they are
+    // pruned once those pages have been swept.
+    pruneRememberedSet();
+    if (incrementalCycleActive) {
+        incrementalCycleActive = false;
+        endCycle(incrementalCycle);
+    }
+    LOG("Collection cycle finished");
+}
+
+// Hands every small page to the lazy sweep. Only the page headers are
+// touched here; the cells are swept when the allocator asks for them.
+// Large pages hold one object each and are swept at once, so a dead large
+// object's memory goes back to the OS without waiting for the next large
+// allocation.
+static void queueLazySweep() {
+    const vector<GCPage*>& pages = GCHeap::pages();
+    int budget = INT_MAX;
+    int freed = 0;
+    for (size_t p = 0; p < pages.size();) {
+        GCPage* page = pages[p];
+        if (page->sizeClass == GCHeap::kLargeClass) {
+            bool released = false;
+            sweepPageCells(page, 0, false, false, budget, freed, released);
+            if (released) continue;
+        } else {
+            page->sweepPending = true;
+            lazyPages[page->sizeClass].push_back(page);
         }
-        ++work;
+        ++p;
+    }
+    LOG("Queued " << pages.size() << " pages for lazy sweeping");
+}
+
+// Sweeps pending pages of one size class, stopping at the first page that
+// frees something unless `all` is set. Returns the objects freed.
+static int lazySweepClass(unsigned cls, bool all) {
+    GCTraceScope trace(GCTracePoint::LazySweep);
+    vector<GCPage*>& pending = lazyPages[cls];
+    int freed = 0;
+    while (!pending.empty()) {
+        GCPage* page = pending.back();
+        pending.pop_back();
+        page->sweepPending = false;
+        int budget = INT_MAX;
+        int before = freed;
+        bool released = false;
+        sweepPageCells(page, 0, false, false, budget, freed, released);
+        if (!released) GCHeap::releasePage(page);
+        if (!all && freed > before) break;
     }
+    trace.value = static_cast<uint32_t>(freed);
+    return freed;
+}
 
-    bool more = (sweepIt != sweepPool->end());
-    LOG("doSweepStep did " << work << " units; more=" << more << " (pool=" << (sweepingOld ? "old" : "young") << ")");
+static void finishLazySweep() {
+    int freed = 0;
+    for (unsigned cls = 0; cls <= GCHeap::kLargeClass; ++cls) {
+        if (!lazyPages[cls].empty()) freed += lazySweepClass(cls, true);
+    }
+    if (freed) {
+        LOG("finishLazySweep freed " << freed << " objects");
+        pruneRememberedSet();
+    }
+}
+
+// Frees the cells of pages the background sweeper has finished. Only
+// bitmap work happens here; the destructors already ran on the sweeper.
+// Returns true while pages remain.
+static bool reclaimBackground() {
+    GCTraceScope trace(GCTracePoint::BackgroundReclaim);
+    size_t done = GCSweeper::finished();
+    int budget = INT_MAX;
+    int freed = 0;
+    for (; backgroundReclaimed < done; ++backgroundReclaimed) {
+        GCPage* page = backgroundPages[backgroundReclaimed];
+        bool released = false;
+        sweepPageCells(page, 0, false, true, budget, freed, released);
+        if (!released) GCHeap::releasePage(page);
+    }
+    trace.value = static_cast<uint32_t>(freed);
+    bool more = backgroundReclaimed < backgroundPages.size();
+    if (!more) backgroundPages.clear();
     return more;
 }
 
+// Installed as GCHeap::refillHook outside incremental sweep mode, so the
+// allocator reclaims swept cells before it maps new memory. Runs with the
+// heap lock held.
+static void refillFromSweep(unsigned cls) {
+    if (lazyRefilling) return;
+    lazyRefilling = true;
+    if (!lazyPages[cls].empty()) {
+        lazySweepClass(cls, false);
+    } else if (phase == Phase::Sweep && sweepMode == GCSweepMode::Background) {
+        reclaimBackground();
+    }
+    lazyRefilling = false;
+}
+
 static int blockingMark() {
+    GCTraceScope trace(GCTracePoint::BlockingMark);
+    markStack.clear();
+    GCHeap::clearMarks();
+    clearRememberedSet();
+    seedRoots();
+
+    // The transitive closure runs on the marker pool. The remembered set is
+    // rebuilt from what the workers report, on this thread.
+    vector<GCObject*> pointsYoung;
+    auto markedCount = static_cast<int>(GCMarker::markFrom(markStack, pointsYoung));
+    while (traceEphemerons()) markedCount += static_cast<int>(GCMarker::markFrom(markStack, pointsYoung));
+    for (GCObject* o : pointsYoung) rememberObject(o);
+    trace.value = static_cast<uint32_t>(markedCount);
+    LOG("blockingMark marked " << markedCount << " objects with "
+        << GCMarker::workerCount() << " workers");
+    return markedCount;
+}
+
+// Traces the young generation from roots and the remembered set. Live
+// nursery objects are evacuated into old-generation pages and every slot
+// that referenced them is redirected; young page objects are marked in
+// place for the sweep. Returns the number of nursery objects that died.
+static int blockingMinorMark() {
+    GCTraceScope trace(GCTracePoint::MinorMark);
     int markedCount = 0;
-    for (GCRefBase* r : roots) {
-        if (!r) continue;
-        GCObject* o = r->getObject();
-        if (o && !o->marked) {
-            o->marked = true;
-            markStack.push_back(o);
+    markStack.clear();
+    GCHeap::sealNursery();
+    for (GCPage* page : youngPages) {
+        for (uint32_t w = 0; w < page->bitmapWords(); ++w) {
+            page->markBits.words[w] &= ~page->youngBits.words[w];
         }
     }
-    while (!markStack.empty()) {
-        GCObject* o = markStack.back();
-        markStack.pop_back();
-        o->black = true;
-
-        vector<GCObject*> children;
-        o->traceChildren(children);
-        for (GCObject* c : children) {
-            if (c && !c->marked) {
-                c->marked = true;
-                markStack.push_back(c);
+
+    forEachRootSlot(minorVisitSlot);
+
+    // Remembered objects are scanned in place. Evacuated copies and young
+    // page objects are scanned as they come off the stack; copies are old
+    // now, so any young page object they still point at must be remembered.
+    // Ephemeron values whose keys survive are traced once the stack runs
+    // dry, until that finds nothing new.
+    size_t remembered = rememberedSet.size();
+    size_t i = 0;
+    do {
+        while (i < remembered || !markStack.empty()) {
+            GCObject* o;
+            if (i < remembered) {
+                o = rememberedSet[i++];
+            } else {
+                o = markStack.back();
+                markStack.pop_back();
+                ++markedCount;
             }
+            o->visitMemberSlots(minorVisitSlot);
+            scratchChildren.clear();
+            o->trace(childTracer);
+            for (GCObject* c : scratchChildren) minorVisitValue(c);
+            rememberIfPointsYoung(o, scratchChildren);
         }
-        ++markedCount;
+    } while (minorTraceEphemerons());
+
+    updateWeakRefsMinor();
+    int died = releaseNursery();
+    trace.value = static_cast<uint32_t>(died);
+    LOG("blockingMinorMark traced " << markedCount << " young objects from "
+        << remembered << " remembered; " << died << " nursery objects died");
+    return died;
+}
+
+// Copies a nursery object into an old-generation cell, or returns the copy
+// made earlier in this collection.
+static GCObject* evacuate(GCObject* obj) {
+    if (GCHeap::isForwarded(obj)) return static_cast<GCObject*>(GCHeap::forwardee(obj));
+
+    size_t size = GCHeap::nurseryObjectSize(obj);
+    auto* copy = static_cast<GCObject*>(GCHeap::allocate(size));
+    memcpy(static_cast<void*>(copy), static_cast<const void*>(obj), size);
+    copy->relocateMemberRefs(obj);
+    GCHeap::setForwarded(obj, copy);
+
+    GCPage* page = GCHeap::pageOf(copy);
+    page->allocBits.set(page->indexOf(copy));
+    heapUsed.fetch_add(page->cellSize, memory_order_relaxed);
+    --nurseryCount;
+    ++oldCount;
+    nurseryEvacuatedBytes += size;
+    ++totals.objectsPromoted;
+    totals.bytesPromoted += page->cellSize;
+    GC_TRACE_INSTANT(Evacuation, size);
+    markStack.push_back(copy);
+    return copy;
+}
+
+static void minorVisitSlot(GCObject** slot) {
+    GCObject* o = *slot;
+    if (!o) return;
+    if (GCHeap::inNursery(o)) {
+        *slot = evacuate(o);
+    } else if (GCHeap::isYoung(o) && GCHeap::tryMark(o)) {
+        markStack.push_back(o);
     }
-    LOG("blockingMark marked " << markedCount << " objects");
-    return markedCount;
 }
 
-static int blockingSweep(unordered_set<GCObject*>& pool) {
+// Children reported only by a trace() override, without a matching
+// visitExtraSlots(), cannot be redirected, so movable objects must not be
+// reachable that way.
+static void minorVisitValue(GCObject* o) {
+    if (!o) return;
+    if (GCHeap::inNursery(o)) {
+        assert(false && "movable objects must be referenced through GCRef slots");
+        evacuate(o);
+    } else if (GCHeap::isYoung(o) && GCHeap::tryMark(o)) {
+        markStack.push_back(o);
+    }
+}
+
+// Drops every nursery object that was not evacuated. Their destructors do
+// not run; only member-reference storage the GC handed out is released.
+static int releaseNursery() {
+    for (GCObject* o : nurseryStorage) {
+        if (GCHeap::isNurseryObject(o) && !GCHeap::isForwarded(o)) o->releaseMemberRefs();
+    }
+    nurseryStorage.clear();
+    auto died = static_cast<int>(nurseryCount);
+    size_t claimed = GCHeap::nurseryBytes();
+    totals.bytesAllocated += claimed;
+    totals.objectsFreed += nurseryCount;
+    totals.bytesFreed += claimed - min(claimed, nurseryEvacuatedBytes);
+    nurseryEvacuatedBytes = 0;
+    nurseryCount = 0;
+    GCHeap::resetNursery();
+    return died;
+}
+
+static int blockingSweep(bool youngOnly) {
+    GCTraceScope trace(GCTracePoint::BlockingSweep);
+    int budget = INT_MAX;
     int freed = 0;
-    vector<GCObject*> dead;
-    for (auto it = pool.begin(); it != pool.end();) {
-        GCObject* o = *it;
-        if (!o->marked) {
-            dead.push_back(o);
-            it = pool.erase(it);
-            ++freed;
+    if (youngOnly) {
+        for (size_t p = 0; p < youngPages.size();) {
+            GCPage* page = youngPages[p];
+            bool released = false;
+            sweepPageCells(page, 0, true, false, budget, freed, released);
+            if (released) continue;
+
+            bool anyYoung = false;
+            for (uint32_t w = 0; w < page->bitmapWords() && !anyYoung; ++w) {
+                anyYoung = page->youngBits.words[w] != 0;
+            }
+            if (!anyYoung) {
+                dropYoungPage(page);
+                continue;
+            }
+            ++p;
+        }
+    } else {
+        const vector<GCPage*>& pages = GCHeap::pages();
+        for (size_t p = 0; p < pages.size();) {
+            bool released = false;
+            sweepPageCells(pages[p], 0, false, false, budget, freed, released);
+            if (!released) ++p;
+        }
+    }
+    trace.value = static_cast<uint32_t>(freed);
+    LOG("blockingSweep freed " << freed << " objects; remaining=" << (youngCount + oldCount));
+    return freed;
+}
+
+static void rememberObject(GCObject* obj) {
+    GCPage* page = GCHeap::pageOf(obj);
+    uint32_t index = page->indexOf(obj);
+    // Lazy sweeps promote while write barriers on other threads set bits.
+    if (!page->rememberedBits.trySetAtomic(index)) return;
+    rememberedSet.push_back(obj);
+}
+
+// Called for every object the minor collector scans, after its children
+// were evacuated, so that copies now in the old generation do not count.
+static void rememberIfPointsYoung(GCObject* obj, const vector<GCObject*>& children) {
+    if (GCHeap::isYoung(obj)) return;
+    for (GCObject* c : children) {
+        if (c && GCHeap::isYoung(c)) {
+            rememberObject(obj);
+            return;
+        }
+    }
+}
+
+// Grays the values of ephemeron entries whose keys are marked. Returns
+// true if that marked anything, so marking has to continue.
+static bool traceEphemerons() {
+    lock_guard<mutex> guard(ephemeronLock);
+    bool marked = false;
+    for (GCEphemeronTable* table : ephemeronTables) {
+        for (const GCEphemeronTable::Entry& e : table->collectorEntries()) {
+            if (e.value && GCHeap::isMarked(e.key) && GCHeap::tryMark(e.value)) {
+                markStack.push_back(e.value);
+                marked = true;
+            }
+        }
+    }
+    return marked;
+}
+
+// Once a major mark is complete, nulls the weak references whose objects
+// it left unmarked and drops ephemeron entries whose keys it left unmarked.
+static void clearWeakRefs() {
+    for (auto& t : threadStates) {
+        RootGuard guard(*t);
+        for (GCWeakRefBase* r : t->weakRefs) {
+            GCObject** slot = r->slot();
+            if (*slot && !GCHeap::isMarked(*slot)) *slot = nullptr;
+        }
+    }
+    lock_guard<mutex> guard(ephemeronLock);
+    for (GCEphemeronTable* table : ephemeronTables) {
+        vector<GCEphemeronTable::Entry>& entries = table->collectorEntries();
+        if (erase_if(entries, [](const GCEphemeronTable::Entry& e) { return !GCHeap::isMarked(e.key); })) {
+            table->reindex();
+        }
+    }
+}
+
+// Whether an object survives the minor collection being traced: old
+// objects are assumed live, nursery objects live if they were evacuated
+// and young page objects if they were marked.
+static bool survivesMinor(GCObject* obj) {
+    if (GCHeap::inNursery(obj)) return GCHeap::isForwarded(obj);
+    return !GCHeap::isYoung(obj) || GCHeap::isMarked(obj);
+}
+
+// Minor-collection counterpart of traceEphemerons(): evacuates or marks the
+// values of entries whose keys survive.
+static bool minorTraceEphemerons() {
+    lock_guard<mutex> guard(ephemeronLock);
+    size_t before = markStack.size();
+    for (GCEphemeronTable* table : ephemeronTables) {
+        for (GCEphemeronTable::Entry& e : table->collectorEntries()) {
+            if (e.value && survivesMinor(e.key)) minorVisitSlot(&e.value);
+        }
+    }
+    return markStack.size() != before;
+}
+
+// Redirects weak references and ephemeron keys to evacuated copies and
+// clears those whose young objects died. Must run before the nursery's
+// forwarding information is reset.
+static void updateWeakRefsMinor() {
+    for (auto& t : threadStates) {
+        RootGuard guard(*t);
+        for (GCWeakRefBase* r : t->weakRefs) {
+            GCObject** slot = r->slot();
+            if (!*slot) continue;
+            if (GCHeap::inNursery(*slot)) {
+                *slot = GCHeap::isForwarded(*slot) ? static_cast<GCObject*>(GCHeap::forwardee(*slot)) : nullptr;
+            } else if (GCHeap::isYoung(*slot) && !GCHeap::isMarked(*slot)) {
+                *slot = nullptr;
+            }
+        }
+    }
+    lock_guard<mutex> guard(ephemeronLock);
+    for (GCEphemeronTable* table : ephemeronTables) {
+        vector<GCEphemeronTable::Entry>& entries = table->collectorEntries();
+        bool changed = false;
+        for (size_t i = 0; i < entries.size();) {
+            GCEphemeronTable::Entry& e = entries[i];
+            if (!survivesMinor(e.key)) {
+                e = entries.back();
+                entries.pop_back();
+                changed = true;
+                continue;
+            }
+            if (GCHeap::inNursery(e.key)) {
+                e.key = static_cast<GCObject*>(GCHeap::forwardee(e.key));
+                changed = true;
+            }
+            ++i;
+        }
+        if (changed) table->reindex();
+    }
+}
+
+static void clearRememberedSet() {
+    for (GCObject* o : rememberedSet) {
+        GCPage* page = GCHeap::pageOf(o);
+        page->rememberedBits.clear(page->indexOf(o));
+    }
+    rememberedSet.clear();
+}
+
+// Drops entries that no longer point into the young generation, for example
+// because their children were promoted or the reference was overwritten.
+static void pruneRememberedSet() {
+    size_t kept = 0;
+    for (GCObject* o : rememberedSet) {
+        GCPage* page = GCHeap::pageOf(o);
+        uint32_t index = page->indexOf(o);
+        if (!page->allocBits.test(index) || page->youngBits.test(index)) continue;
+
+        youngTracer.reset();
+        o->trace(youngTracer);
+        if (youngTracer.pointsYoung()) {
+            rememberedSet[kept++] = o;
         } else {
-            o->marked = false;
-            o->black = false;
-            ++it;
+            page->rememberedBits.clear(index);
         }
     }
-    for (GCObject* d : dead) {
-        for (GCRefBase* r : roots) if (r) r->nullIfPointsTo(d);
-        for (GCObject* o : youngObjects) {
-            for (GCRefBase* mr : o->getMemberRefs()) if (mr) mr->nullIfPointsTo(d);
+    rememberedSet.resize(kept);
+}
+
+static void dropYoungPage(GCPage* page) {
+    if (page->youngIndex < 0) return;
+    GCPage* last = youngPages.back();
+    youngPages[page->youngIndex] = last;
+    last->youngIndex = page->youngIndex;
+    youngPages.pop_back();
+    page->youngIndex = -1;
+}
+
+// Adds a thread's allocation to the heap total once a batch has built up,
+// and starts a cycle if that takes the heap past its goal.
+static void addHeapBytes(GCThreadState& t, size_t bytes) {
+    t.heapBytesPending += bytes;
+    if (t.heapBytesPending < kHeapBytesBatch) return;
+    size_t batch = exchange(t.heapBytesPending, 0);
+    size_t used = heapUsed.fetch_add(batch, memory_order_relaxed) + batch;
+    if (used >= heapGoalBytes.load(memory_order_relaxed)) GC::startIncrementalCollect();
+}
+
+// Finishes the sweep of the current or last major cycle, in whichever mode
+// it runs. The world must be stopped.
+static void completeSweep() {
+    if (phase == Phase::Sweep) {
+        if (sweepMode == GCSweepMode::Background) GCSweeper::wait();
+        while (!GC::incrementalCollectStep()) {}
+    }
+    finishLazySweep();
+}
+
+// Cells on a page that hold neither an object nor a queued finalizer.
+// Cursors must be retired, so every free cell is on the page's own list.
+static uint32_t freeCellCount(GCPage* page) {
+    uint32_t count = page->cellCount - page->bumpIndex;
+    for (GCFreeCell* cell = page->freeList; cell; cell = cell->next) ++count;
+    return count;
+}
+
+// Returns where a compacted object went. An object on a page being
+// emptied has moved once its alloc bit is gone, and its old cell starts
+// with the new address.
+static GCObject* compactedAddress(GCObject* obj) {
+    if (!obj || GCHeap::inNursery(obj)) return obj;
+    GCPage* page = GCHeap::pageOf(obj);
+    if (!page->evacuating || page->allocBits.test(page->indexOf(obj))) return obj;
+    return *reinterpret_cast<GCObject**>(obj);
+}
+
+static void compactVisitSlot(GCObject** slot) {
+    *slot = compactedAddress(*slot);
+}
+
+// Copies one object to a free cell of its size class on a page that
+// stays, with its color, age and remembered bit, and leaves the new
+// address in the old cell.
+static void moveObject(GCPage* from, uint32_t i) {
+    auto* obj = reinterpret_cast<GCObject*>(from->cellAt(i));
+    auto* copy = static_cast<GCObject*>(GCHeap::allocateSmall(from->sizeClass));
+    memcpy(static_cast<void*>(copy), static_cast<const void*>(obj), from->cellSize);
+    copy->relocateMemberRefs(obj);
+
+    GCPage* to = GCHeap::pageOf(copy);
+    uint32_t j = to->indexOf(copy);
+    to->allocBits.set(j);
+    if (from->markBits.test(i)) to->markBits.set(j);
+    if (from->agedBits.test(i)) to->agedBits.set(j);
+    if (from->rememberedBits.test(i)) to->rememberedBits.set(j);
+    if (from->youngBits.test(i)) {
+        to->youngBits.set(j);
+        if (to->youngIndex < 0) {
+            to->youngIndex = static_cast<int32_t>(youngPages.size());
+            youngPages.push_back(to);
         }
-        for (GCObject* o : oldObjects) {
-            for (GCRefBase* mr : o->getMemberRefs()) if (mr) mr->nullIfPointsTo(d);
+    }
+    from->allocBits.clear(i);
+    *reinterpret_cast<GCObject**>(obj) = copy;
+    ++totals.objectsCompacted;
+    totals.bytesCompacted += from->cellSize;
+}
+
+// Empties the sparsest pages of each size class into the free cells of the
+// pages that stay and unmaps them. Runs after a complete major collection,
+// with the world stopped. Only pages whose every object is movable and
+// unpinned are emptied, and only as many as the other pages of the class
+// can absorb, so no new page is mapped. References are then redirected
+// through every GCRef and GCMember slot, root, weak reference and
+// ephemeron entry.
+static void compactHeap() {
+    GCTraceScope trace(GCTracePoint::Compaction);
+    GCHeap::retireAllCursors();
+    GCHeap::withdrawPages();
+
+    struct Candidate {
+        GCPage* page;
+        uint32_t live;
+    };
+    vector<Candidate> candidates[GCHeap::kSizeClassCount];
+    size_t freeCells[GCHeap::kSizeClassCount] = {};
+    for (GCPage* page : GCHeap::pages()) {
+        if (page->sizeClass == GCHeap::kLargeClass) continue;
+        uint32_t free = freeCellCount(page);
+        freeCells[page->sizeClass] += free;
+        uint32_t live = 0;
+        bool movable = true;
+        for (uint32_t w = 0; w < page->bitmapWords() && movable; ++w) {
+            uint64_t bits = page->allocBits.words[w];
+            live += popcount(bits);
+            for (; bits && movable; bits &= bits - 1) {
+                auto* obj = reinterpret_cast<GCObject*>(page->cellAt(w * 64 + countr_zero(bits)));
+                uint16_t flags = obj->gcHeader().flags();
+                movable = (flags & (GCHeader::kMovable | GCHeader::kPinned)) == GCHeader::kMovable;
+            }
         }
-        delete d;
+        // Cells that are neither live nor free belong to queued finalizers.
+        if (movable && live + free == page->cellCount) candidates[page->sizeClass].push_back({page, live});
     }
-    LOG("blockingSweep freed " << freed << " objects; remaining=" << pool.size());
-    return freed;
+
+    vector<GCPage*> sources;
+    for (unsigned cls = 0; cls < GCHeap::kSizeClassCount; ++cls) {
+        vector<Candidate>& list = candidates[cls];
+        sort(list.begin(), list.end(), [](const Candidate& a, const Candidate& b) { return a.live < b.live; });
+        size_t capacity = freeCells[cls];
+        size_t moving = 0;
+        for (const Candidate& c : list) {
+            size_t free = c.page->cellCount - c.live;
+            if (moving + c.live > capacity - free) break;
+            capacity -= free;
+            moving += c.live;
+            c.page->evacuating = true;
+            sources.push_back(c.page);
+        }
+    }
+    for (GCPage* page : GCHeap::pages()) {
+        if (!page->evacuating) GCHeap::releasePage(page);
+    }
+
+    for (GCPage* page : sources) {
+        for (uint32_t w = 0; w < page->bitmapWords(); ++w) {
+            for (uint64_t bits = page->allocBits.words[w]; bits; bits &= bits - 1) {
+                moveObject(page, w * 64 + static_cast<uint32_t>(countr_zero(bits)));
+            }
+        }
+    }
+
+    if (!sources.empty()) {
+        forEachRootSlot(compactVisitSlot);
+        for (GCPage* page : GCHeap::pages()) {
+            if (page->evacuating) continue;
+            for (uint32_t w = 0; w < page->bitmapWords(); ++w) {
+                for (uint64_t bits = page->allocBits.words[w]; bits; bits &= bits - 1) {
+                    auto* obj = reinterpret_cast<GCObject*>(page->cellAt(w * 64 + countr_zero(bits)));
+                    obj->visitMemberSlots(compactVisitSlot);
+                }
+            }
+        }
+        for (auto& t : threadStates) {
+            for (GCWeakRefBase* r : t->weakRefs) compactVisitSlot(r->slot());
+        }
+        {
+            lock_guard<mutex> guard(ephemeronLock);
+            for (GCEphemeronTable* table : ephemeronTables) {
+                for (GCEphemeronTable::Entry& e : table->collectorEntries()) {
+                    e.key = compactedAddress(e.key);
+                    e.value = compactedAddress(e.value);
+                }
+                table->reindex();
+            }
+        }
+        for (GCObject*& o : rememberedSet) o = compactedAddress(o);
+    }
+
+    for (GCPage* page : sources) {
+        dropYoungPage(page);
+        GCHeap::freePage(page);
+    }
+    totals.pagesCompacted += sources.size();
+    trace.value = static_cast<uint32_t>(sources.size());
+    LOG("Compaction unmapped " << sources.size() << " pages");
 }
 
-static void promoteObject(GCObject* obj) {
-    if (!obj) return;
-    if (youngObjects.erase(obj) > 0) {
-        oldObjects.insert(obj);
-        obj->generation = Generation::Old;
-        obj->survivalCount = 0;
-        obj->marked = false;
-        obj->black = false;
+// Measures what survived a completed major mark and sets the next goal
+// from it. Objects allocated black during the cycle count as live.
+static void updateHeapGoal() {
+    size_t live = 0;
+    for (GCPage* page : GCHeap::pages()) {
+        size_t cells = 0;
+        for (uint32_t w = 0; w < page->bitmapWords(); ++w) {
+            cells += popcount(page->allocBits.words[w] & page->markBits.words[w]);
+        }
+        live += cells * page->cellSize;
     }
+    liveBytes = live;
+    computeHeapGoal();
 }
 
-static void adaptThresholds() {
-    if (lastMinorCollected < youngThreshold / 10 && youngThreshold < 2000) {
-        youngThreshold = static_cast<int>(youngThreshold * 1.5);
-    } else if (lastMinorCollected > youngThreshold / 2 && youngThreshold > 20) {
-        youngThreshold = static_cast<int>(youngThreshold * 0.8);
+// Applies the policy to liveBytes: grow by the ratio, but no further than
+// the soft target while the live data still fits under it.
+static void computeHeapGoal() {
+    size_t goal = SIZE_MAX;
+    if (policy.growthRatio > 0) {
+        double grown = static_cast<double>(liveBytes) * (1 + policy.growthRatio);
+        goal = grown >= static_cast<double>(SIZE_MAX) ? SIZE_MAX : static_cast<size_t>(grown);
+        goal = max(goal, policy.minHeapBytes);
     }
-    int total = static_cast<int>(youngObjects.size() + oldObjects.size() + roots.size());
-    if (total > 1000 && allocationThreshold < 100000) allocationThreshold *= 2;
-    LOG("adaptThresholds: youngThreshold=" << youngThreshold << " allocationThreshold=" << allocationThreshold);
+    if (softTarget && goal > softTarget) goal = max(softTarget, liveBytes + liveBytes / 16);
+    heapGoalBytes.store(goal, memory_order_relaxed);
+    LOG("Heap goal " << goal << " bytes over " << liveBytes << " live bytes");
+}
+
+// Spreads the cycle's work over the bytes the heap may still grow by:
+// marking at most every object, then sweeping every object plus those
+// allocated meanwhile. The runway is the headroom the goal gave over the
+// last live size, or the object-count trigger's worth of allocation. An
+// allocation always owes at least two units, so a cycle that outlives its
+// runway still gains on the objects allocated behind it.
+static void startPacing() {
+    double objects = static_cast<double>(youngCount + oldCount + largeCount);
+    double used = static_cast<double>(heapUsed.load(memory_order_relaxed));
+    double averageBytes = objects > 0 ? max(used / objects, 16.0) : 64.0;
+    double runway = 0;
+    size_t goal = heapGoalBytes.load(memory_order_relaxed);
+    if (goal != SIZE_MAX) runway = static_cast<double>(goal - min(goal, liveBytes));
+    if (allocationThreshold > 0) {
+        double counted = allocationThreshold * averageBytes;
+        runway = runway > 0 ? min(runway, counted) : counted;
+    }
+    runway = max(runway, double{kHeapBytesBatch});
+    allocationTax = max((2 * objects + runway / averageBytes) / runway, 2 / averageBytes);
+    for (auto& t : threadStates) t->workDebt = 0;
+    LOG("startPacing: " << objects << " objects, tax " << allocationTax << " units per byte");
+}
+
+// Folds one step's cost per unit into the running average for its phase
+// and resizes that phase's budget to fit the pause target.
+static void adaptBudgets(Phase stepPhase, chrono::nanoseconds elapsed) {
+    if (stepUnits <= 0 || (stepPhase != Phase::Marking && stepPhase != Phase::Sweep)) return;
+    double sample = static_cast<double>(elapsed.count()) / stepUnits;
+    bool marking = stepPhase == Phase::Marking;
+    double& perUnit = marking ? markNsPerUnit : sweepNsPerUnit;
+    perUnit = perUnit > 0 ? 0.75 * perUnit + 0.25 * sample : sample;
+    double fit = static_cast<double>(pauseTarget.count()) / perUnit;
+    int budget = static_cast<int>(clamp(fit, double{kMinPacedBudget}, double{kMaxPacedBudget}));
+    (marking ? markBudget : sweepBudget) = budget;
+}
+
+// Starts timing a collection and tells the hooks it has begun.
+static CycleRecord beginCycle(GCCycleKind kind, uint64_t cycle) {
+    CycleRecord record;
+    record.kind = kind;
+    record.cycle = cycle;
+    record.start = chrono::steady_clock::now();
+    record.objectsFreed = totals.objectsFreed;
+    record.bytesFreed = totals.bytesFreed;
+
+    GCCycleEvent event{kind, false, cycle};
+    event.heapBytes = heapUsed.load(memory_order_relaxed);
+    fireCycleEvent(event);
+    return record;
+}
+
+// Tells the hooks a collection has ended and returns how long it took.
+static chrono::nanoseconds endCycle(const CycleRecord& record) {
+    GCCycleEvent event{record.kind, true, record.cycle};
+    event.duration = chrono::steady_clock::now() - record.start;
+    event.objectsFreed = totals.objectsFreed - record.objectsFreed;
+    event.bytesFreed = totals.bytesFreed - record.bytesFreed;
+    event.heapBytes = heapUsed.load(memory_order_relaxed);
+    fireCycleEvent(event);
+    return event.duration;
+}
+
+static void fireCycleEvent(const GCCycleEvent& event) {
+    for (auto& entry : cycleHooks) entry.second(event);
 }
@@ -0,0 +1,149 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: src/GCFinalizer.cpp
+// ----------------------------------
+
+#include "../include/GCFinalizer.h"
+#include "../include/GC.h"
+#include "../include/GCHeap.h"
+#include "../include/GCObject.h"
+#include "../include/GCTrace.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+namespace {
+    struct Finalizer {
+        mutex lock;
+        condition_variable wake;   // work arrived or the thread was enabled
+        condition_variable idle;   // a batch finished
+        vector<GCObject*> queue;
+        size_t inFlight = 0;       // taken from the queue, not yet destroyed
+        bool background = false;
+        bool started = false;
+    };
+
+    // Never destroyed: the finalizer thread is attached to the collector and
+    // is still waiting on this state when the program exits.
+    Finalizer& finalizer = *new Finalizer;
+
+    // Objects taken from the queue at a time, so the lock is not taken for
+    // every object and one batch stays short between safepoint polls.
+    constexpr size_t kBatch = 64;
+
+    // Moves up to kBatch objects from the queue into `batch`. Needs the lock.
+    void take(vector<GCObject*>& batch) {
+        size_t n = min(kBatch, finalizer.queue.size());
+        batch.assign(finalizer.queue.end() - static_cast<ptrdiff_t>(n), finalizer.queue.end());
+        finalizer.queue.resize(finalizer.queue.size() - n);
+        finalizer.inFlight += n;
+    }
+
+    // Returns the objects of a batch that were not destroyed to the queue.
+    void finish(vector<GCObject*>& batch, size_t done) {
+        {
+            lock_guard<mutex> guard(finalizer.lock);
+            finalizer.queue.insert(finalizer.queue.end(), batch.begin() + static_cast<ptrdiff_t>(done), batch.end());
+            finalizer.inFlight -= batch.size();
+        }
+        finalizer.idle.notify_all();
+        batch.clear();
+    }
+
+    // Runs a queued object's destructor and frees its cell.
+    void destroy(GCObject* obj) {
+        obj->~GCObject();
+        GCHeap::deallocate(obj);
+    }
+
+    void finalizerLoop() {
+        vector<GCObject*> batch;
+        for (;;) {
+            {
+                // Waiting is a safe region, so collections never wait for an
+                // idle finalizer. The lock is released before the region
+                // ends, since leaving it waits for a running collection.
+                GCSafeRegion safe;
+                unique_lock<mutex> guard(finalizer.lock);
+                finalizer.wake.wait(guard, [] { return finalizer.background && !finalizer.queue.empty(); });
+                take(batch);
+            }
+            GCTraceScope trace(GCTracePoint::Finalization);
+            for (GCObject* obj : batch) {
+                destroy(obj);
+                GC::safepoint();
+            }
+            trace.value = static_cast<uint32_t>(batch.size());
+            finish(batch, batch.size());
+        }
+    }
+}
+
+void GCFinalizer::enqueue(vector<GCObject*>& objects) {
+    if (objects.empty()) return;
+    bool notify;
+    {
+        lock_guard<mutex> guard(finalizer.lock);
+        notify = finalizer.background && finalizer.queue.empty();
+        finalizer.queue.insert(finalizer.queue.end(), objects.begin(), objects.end());
+    }
+    objects.clear();
+    if (notify) finalizer.wake.notify_one();
+}
+
+size_t GCFinalizer::run(chrono::nanoseconds budget) {
+    auto start = chrono::steady_clock::now();
+    vector<GCObject*> batch;
+    size_t count = 0;
+    for (;;) {
+        {
+            lock_guard<mutex> guard(finalizer.lock);
+            take(batch);
+        }
+        if (batch.empty()) break;
+        GCTraceScope trace(GCTracePoint::Finalization);
+        size_t done = 0;
+        bool expired = false;
+        while (done < batch.size() && !expired) {
+            destroy(batch[done++]);
+            expired = chrono::steady_clock::now() - start >= budget;
+        }
+        trace.value = static_cast<uint32_t>(done);
+        count += done;
+        finish(batch, done);
+        if (expired) break;
+    }
+    return count;
+}
+
+void GCFinalizer::drain() {
+    run(chrono::nanoseconds::max());
+    // The finalizer thread may poll a safepoint mid-batch, so this thread
+    // must not hold up a collection while it waits.
+    GCSafeRegion safe;
+    unique_lock<mutex> guard(finalizer.lock);
+    finalizer.idle.wait(guard, [] { return finalizer.inFlight == 0; });
+}
+
+size_t GCFinalizer::pending() {
+    lock_guard<mutex> guard(finalizer.lock);
+    return finalizer.queue.size() + finalizer.inFlight;
+}
+
+void GCFinalizer::setBackground(bool enabled) {
+    {
+        lock_guard<mutex> guard(finalizer.lock);
+        finalizer.background = enabled;
+        if (enabled && !finalizer.started) {
+            finalizer.started = true;
+            thread(finalizerLoop).detach();
+        }
+    }
+    if (enabled) finalizer.wake.notify_one();
+}
@@ -0,0 +1,469 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: src/GCHeap.cpp
+// ----------------------------------
+
+#include "../include/GCHeap.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+namespace {
+    // Pages of each size class that have free cells and are not the
+    // cursor's current page.
+    vector<GCPage*> availablePages[GCHeap::kSizeClassCount];
+
+    // Every mapped page; GCPage::pageIndex is the slot.
+    vector<GCPage*> allPages;
+
+    size_t totalMapped = 0;
+
+    // Page id table behind GCHeap::isPage(). Chunks are never moved or
+    // freed and ids stay put while their page lives, so readers take no lock.
+    constexpr size_t kPageIdChunk = 4096;
+    constexpr size_t kPageIdChunks = 4096;
+    atomic<atomic<GCPage*>*> pageIdChunks[kPageIdChunks];
+    uint32_t nextPageId = 0;
+    vector<uint32_t> freePageIds;
+
+    // Guards everything above plus page free lists and ownership. A thread
+    // that already holds it may take it again.
+    mutex heapLock;
+    thread_local bool heapLockHeld = false;
+
+    // Allocation buffers of every thread that has taken a page or a nursery
+    // chunk, so the collector can retire them with the world stopped.
+    vector<GCHeap::ThreadHeap*> threadHeaps;
+
+    // Nursery bookkeeping beyond the inline fast-path fields. Threads claim
+    // kNurseryChunk bytes at a time from nurseryClaim.
+    size_t nurseryRequested = GCHeap::kDefaultNurserySize;
+    bool nurseryIsClosed = false;
+    atomic<char*> nurseryClaim{nullptr};
+    vector<uint64_t> nurseryStartBits;
+    vector<uint64_t> nurseryForwardBits;
+
+    static_assert(GCHeap::kNurseryChunk % (64 * GCHeap::kCellAlign) == 0,
+                  "nursery chunks must cover whole start-bitmap words");
+
+    size_t granuleOf(const void* p) {
+        return static_cast<size_t>(static_cast<const char*>(p) - GCHeap::nurseryStart.load(memory_order_relaxed))
+               / GCHeap::kCellAlign;
+    }
+
+    // End of the claimed part of the nursery.
+    char* nurseryEnd() {
+        char* start = GCHeap::nurseryStart.load(memory_order_relaxed);
+        return min(nurseryClaim.load(memory_order_relaxed), start + GCHeap::nurseryCapacity.load(memory_order_relaxed));
+    }
+
+    bool testGranule(const vector<uint64_t>& bits, size_t g) {
+        return (bits[g >> 6] >> (g & 63)) & 1u;
+    }
+
+    // Maps bytes of zeroed memory aligned to kPageSize.
+    void* mapAligned(size_t bytes) {
+#ifdef _WIN32
+        // VirtualAlloc reservations are aligned to the 64 KiB allocation
+        // granularity, which matches kPageSize.
+        void* p = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (!p) throw bad_alloc();
+        return p;
+#else
+        size_t padded = bytes + GCHeap::kPageSize;
+        void* raw = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) throw bad_alloc();
+        auto start = reinterpret_cast<uintptr_t>(raw);
+        uintptr_t aligned = (start + GCHeap::kPageSize - 1) & ~(uintptr_t{GCHeap::kPageSize} - 1);
+        size_t head = aligned - start;
+        size_t tail = padded - head - bytes;
+        if (head) munmap(raw, head);
+        if (tail) munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+        return reinterpret_cast<void*>(aligned);
+#endif
+    }
+
+    atomic<GCPage*>& pageIdSlot(uint32_t id) {
+        return pageIdChunks[id / kPageIdChunk].load(memory_order_relaxed)[id % kPageIdChunk];
+    }
+
+    uint32_t assignPageId(GCPage* page) {
+        uint32_t id;
+        if (!freePageIds.empty()) {
+            id = freePageIds.back();
+            freePageIds.pop_back();
+        } else {
+            if (nextPageId == kPageIdChunk * kPageIdChunks) throw bad_alloc();
+            id = nextPageId;
+            if (id % kPageIdChunk == 0) {
+                pageIdChunks[id / kPageIdChunk].store(new atomic<GCPage*>[kPageIdChunk](), memory_order_release);
+            }
+            ++nextPageId;
+        }
+        pageIdSlot(id).store(page, memory_order_release);
+        return id;
+    }
+
+    void unmap(void* p, size_t bytes) {
+#ifdef _WIN32
+        (void)bytes;
+        VirtualFree(p, 0, MEM_RELEASE);
+#else
+        munmap(p, bytes);
+#endif
+    }
+
+    GCPage* newPage(unsigned cls, size_t cellSize, uint32_t cellCount, size_t bytes) {
+        auto* page = static_cast<GCPage*>(mapAligned(bytes));
+        try {
+            page->pageId = assignPageId(page);
+        } catch (...) {
+            unmap(page, bytes);
+            throw;
+        }
+        page->sizeClass = cls;
+        page->cellSize = static_cast<uint32_t>(cellSize);
+        page->cellCount = cellCount;
+        page->cellReciprocal = static_cast<uint32_t>(((uint64_t{1} << 32) + cellSize - 1) / cellSize);
+        page->pageIndex = static_cast<uint32_t>(allPages.size());
+        page->youngIndex = -1;
+        page->bumpIndex = 0;
+        page->available = false;
+        page->sweepPending = false;
+        page->evacuating = false;
+        page->mappedBytes = bytes;
+        page->freeList = nullptr;
+        page->cursor = nullptr;
+        allPages.push_back(page);
+        totalMapped += bytes;
+        return page;
+    }
+
+    void makeAvailable(GCPage* page) {
+        if (page->available || page->cursor || page->sweepPending) return;
+        if (!page->freeList && page->bumpIndex >= page->cellCount) return;
+        page->available = true;
+        availablePages[page->sizeClass].push_back(page);
+    }
+
+    // Hands the cursor's leftover state back to its page. Cells other threads
+    // freed while the cursor owned the page are already on the page's list.
+    void retireCursor(GCAllocCursor& c) {
+        GCPage* page = c.page;
+        if (!page) return;
+        page->bumpIndex = static_cast<uint32_t>((c.bump - page->cells()) / page->cellSize);
+        GCFreeCell* foreign = page->freeList;
+        page->freeList = c.freeList;
+        while (foreign) {
+            GCFreeCell* next = foreign->next;
+            foreign->next = page->freeList;
+            page->freeList = foreign;
+            foreign = next;
+        }
+        page->cursor = nullptr;
+        c = GCAllocCursor{};
+        makeAvailable(page);
+    }
+
+    // Ends a thread's nursery chunk. The unused tail gets a start bit of its
+    // own so the last object's size still ends at its allocation top.
+    void retireChunk(GCHeap::ThreadHeap& t) {
+        if (t.nurseryTop && t.nurseryTop < t.nurseryLimit) {
+            size_t g = granuleOf(t.nurseryTop);
+            nurseryStartBits[g >> 6] |= uint64_t{1} << (g & 63);
+        }
+        t.nurseryTop = t.nurseryLimit = nullptr;
+    }
+
+    void registerThread(GCHeap::ThreadHeap& t) {
+        if (t.registered) return;
+        t.registered = true;
+        threadHeaps.push_back(&t);
+    }
+}
+
+GCHeap::Lock::Lock(bool engage) : held(engage && !heapLockHeld) {
+    if (!held) return;
+    heapLock.lock();
+    heapLockHeld = true;
+}
+
+GCHeap::Lock::~Lock() {
+    if (!held) return;
+    heapLockHeld = false;
+    heapLock.unlock();
+}
+
+static_assert(sizeof(GCPage) <= GCHeap::kPageHeaderSize, "page header does not fit");
+static_assert((GCHeap::kPageSize - GCHeap::kPageHeaderSize) / GCHeap::kCellAlign <= GCBitmap::kWords * 64,
+              "bitmaps do not cover the smallest size class");
+static_assert(GCHeap::classSize(GCHeap::kSizeClassCount - 1) == GCHeap::kMaxSmallSize,
+              "size class table does not end at kMaxSmallSize");
+
+void* GCHeap::allocateSlow(unsigned cls) {
+    if (!local.registered && threadHook) threadHook();
+    Lock lock;
+    registerThread(local);
+    GCAllocCursor& c = local.cursors[cls];
+    retireCursor(c);
+    if (refillHook) {
+        refillHook(cls);
+        // A destructor run by the hook may have allocated into the cursor.
+        retireCursor(c);
+    }
+
+    GCPage* page;
+    if (!availablePages[cls].empty()) {
+        page = availablePages[cls].back();
+        availablePages[cls].pop_back();
+        page->available = false;
+    } else {
+        size_t cellSize = classSize(cls);
+        auto cellCount = static_cast<uint32_t>((kPageSize - kPageHeaderSize) / cellSize);
+        page = newPage(cls, cellSize, cellCount, kPageSize);
+    }
+
+    c.page = page;
+    page->cursor = &c;
+    c.freeList = page->freeList;
+    page->freeList = nullptr;
+    c.bump = page->cellAt(page->bumpIndex);
+    c.bumpEnd = page->cellAt(page->cellCount);
+    return allocateSmall(cls);
+}
+
+void* GCHeap::allocateLarge(size_t size) {
+    if (size > kMaxLargeSize) throw bad_alloc();
+    Lock lock;
+    if (refillHook) refillHook(kLargeClass);
+    size_t bytes = (kPageHeaderSize + size + kPageSize - 1) & ~(kPageSize - 1);
+    GCPage* page = newPage(kLargeClass, static_cast<uint32_t>(bytes - kPageHeaderSize), 1, bytes);
+    page->bumpIndex = 1;
+    return page->cells();
+}
+
+void GCHeap::deallocate(void* p) {
+    if (!p) return;
+
+    if (inNursery(p)) {
+        // Constructor threw; leave the hole and forget the object start.
+        size_t g = granuleOf(p);
+        nurseryStarts[g >> 6] &= ~(uint64_t{1} << (g & 63));
+        return;
+    }
+
+    Lock lock(!worldStopped);
+    GCPage* page = pageOf(p);
+    if (page->sizeClass == kLargeClass) {
+        freePage(page);
+        return;
+    }
+
+    uint32_t index = page->indexOf(p);
+    page->allocBits.clear(index);
+    page->youngBits.clear(index);
+    page->agedBits.clear(index);
+    page->markBits.clear(index);
+    // Write barriers on other threads may be setting neighbouring bits.
+    if (page->rememberedBits.test(index)) page->rememberedBits.clearAtomic(index);
+
+    // A cell goes straight back to the cursor that owns its page when that
+    // cursor is this thread's, or when its thread is stopped. Otherwise it
+    // waits on the page's list until the owner retires the page.
+    auto* cell = static_cast<GCFreeCell*>(p);
+    GCAllocCursor* owner = page->cursor;
+    if (owner && (owner == &local.cursors[page->sizeClass] || worldStopped)) {
+        cell->next = owner->freeList;
+        owner->freeList = cell;
+        return;
+    }
+
+    cell->next = page->freeList;
+    page->freeList = cell;
+    makeAvailable(page);
+}
+
+void GCHeap::freePage(GCPage* page) {
+    Lock lock(!worldStopped);
+    GCPage* last = allPages.back();
+    allPages[page->pageIndex] = last;
+    last->pageIndex = page->pageIndex;
+    allPages.pop_back();
+    pageIdSlot(page->pageId).store(nullptr, memory_order_relaxed);
+    freePageIds.push_back(page->pageId);
+    totalMapped -= page->mappedBytes;
+    unmap(page, page->mappedBytes);
+}
+
+void GCHeap::clearMarks() {
+    for (GCPage* page : allPages) {
+        memset(page->markBits.words, 0, page->bitmapWords() * sizeof(uint64_t));
+    }
+}
+
+bool GCHeap::isPage(const GCPage* page) {
+    uint32_t id = page->pageId;
+    if (id >= kPageIdChunk * kPageIdChunks) return false;
+    atomic<GCPage*>* chunk = pageIdChunks[id / kPageIdChunk].load(memory_order_acquire);
+    return chunk && chunk[id % kPageIdChunk].load(memory_order_acquire) == page;
+}
+
+const vector<GCPage*>& GCHeap::pages() {
+    return allPages;
+}
+
+size_t GCHeap::mappedBytes() {
+    return totalMapped;
+}
+
+void GCHeap::releaseThread() {
+    Lock lock;
+    if (!local.registered) return;
+    for (GCAllocCursor& c : local.cursors) retireCursor(c);
+    retireChunk(local);
+    threadHeaps.erase(find(threadHeaps.begin(), threadHeaps.end(), &local));
+    local.registered = false;
+}
+
+void GCHeap::retireAllCursors() {
+    for (ThreadHeap* t : threadHeaps) {
+        for (GCAllocCursor& c : t->cursors) retireCursor(c);
+    }
+}
+
+void GCHeap::withdrawPages() {
+    for (vector<GCPage*>& list : availablePages) {
+        for (GCPage* page : list) page->available = false;
+        list.clear();
+    }
+}
+
+void GCHeap::releasePage(GCPage* page) {
+    makeAvailable(page);
+}
+
+void* GCHeap::allocateNurserySlow(size_t size) {
+    if (size > kNurseryChunk) return nullptr;
+    ThreadHeap& t = local;
+    if (!t.registered && threadHook) threadHook();
+    if (t.nurseryTop) retireChunk(t);
+
+    // nurseryCapacity is published last, so a non-zero capacity means the
+    // rest of the nursery state is ready.
+    if (nurseryCapacity.load(memory_order_acquire) == 0 || !t.registered) {
+        Lock lock;
+        registerThread(t);
+        if (!nurseryStart.load(memory_order_relaxed) && !nurseryIsClosed && nurseryRequested != 0) {
+            size_t bytes = (nurseryRequested + kPageSize - 1) & ~(kPageSize - 1);
+            bytes = (bytes + kNurseryChunk - 1) & ~(kNurseryChunk - 1);
+            auto* start = static_cast<char*>(mapAligned(bytes));
+            size_t words = (bytes / kCellAlign + 63) / 64;
+            nurseryStartBits.assign(words, 0);
+            nurseryForwardBits.assign(words, 0);
+            nurseryStarts = nurseryStartBits.data();
+            totalMapped += bytes;
+            nurseryClaim.store(start, memory_order_relaxed);
+            nurseryStart.store(start, memory_order_relaxed);
+            nurseryCapacity.store(bytes, memory_order_release);
+        }
+    }
+    size_t capacity = nurseryCapacity.load(memory_order_acquire);
+    if (capacity == 0 || nurseryIsClosed) return nullptr;
+
+    char* end = nurseryStart.load(memory_order_relaxed) + capacity;
+    char* chunk = nurseryClaim.load(memory_order_relaxed);
+    do {
+        if (static_cast<size_t>(end - chunk) < kNurseryChunk) return nullptr;
+    } while (!nurseryClaim.compare_exchange_weak(chunk, chunk + kNurseryChunk, memory_order_relaxed));
+    t.nurseryTop = chunk;
+    t.nurseryLimit = chunk + kNurseryChunk;
+    return allocateNursery(size);
+}
+
+bool GCHeap::nurseryUsed() {
+    return nurseryClaim.load(memory_order_relaxed) != nurseryStart.load(memory_order_relaxed);
+}
+
+size_t GCHeap::nurseryBytes() {
+    return static_cast<size_t>(nurseryEnd() - nurseryStart.load(memory_order_relaxed));
+}
+
+bool GCHeap::isNurseryObject(const void* p) {
+    return testGranule(nurseryStartBits, granuleOf(p));
+}
+
+size_t GCHeap::nurseryObjectSize(const void* p) {
+    // Objects are bump-allocated back to back, so an object ends where the
+    // next recorded start (or the claimed end) begins. Sealed chunks record
+    // their unused tail as a start too.
+    size_t g = granuleOf(p) + 1;
+    size_t end = granuleOf(nurseryEnd());
+    size_t w = g >> 6;
+    uint64_t bits = (g & 63) ? nurseryStartBits[w] & (~uint64_t{0} << (g & 63)) : nurseryStartBits[w];
+    size_t lastWord = (end + 63) / 64;
+    while (!bits && ++w < lastWord) bits = nurseryStartBits[w];
+    size_t next = bits ? w * 64 + static_cast<size_t>(countr_zero(bits)) : end;
+    if (next > end) next = end;
+    return (next - granuleOf(p)) * kCellAlign;
+}
+
+bool GCHeap::isForwarded(const void* p) {
+    return testGranule(nurseryForwardBits, granuleOf(p));
+}
+
+void GCHeap::setForwarded(void* p, void* to) {
+    size_t g = granuleOf(p);
+    nurseryForwardBits[g >> 6] |= uint64_t{1} << (g & 63);
+    *static_cast<void**>(p) = to;
+}
+
+void GCHeap::sealNursery() {
+    for (ThreadHeap* t : threadHeaps) retireChunk(*t);
+}
+
+void GCHeap::resetNursery() {
+    sealNursery();
+    char* start = nurseryStart.load(memory_order_relaxed);
+    if (!start) return;
+    size_t words = (granuleOf(nurseryEnd()) + 63) / 64;
+    fill_n(nurseryStartBits.begin(), words, 0);
+    fill_n(nurseryForwardBits.begin(), words, 0);
+    nurseryClaim.store(start, memory_order_relaxed);
+}
+
+void GCHeap::closeNursery() {
+    sealNursery();
+    nurseryIsClosed = true;
+}
+
+void GCHeap::openNursery() {
+    nurseryIsClosed = false;
+}
+
+void GCHeap::setNurserySize(size_t bytes) {
+    nurseryRequested = bytes;
+    char* start = nurseryStart.load(memory_order_relaxed);
+    if (!start || nurseryUsed()) return;
+    size_t capacity = nurseryCapacity.load(memory_order_relaxed);
+    totalMapped -= capacity;
+    unmap(start, capacity);
+    nurseryCapacity.store(0, memory_order_relaxed);
+    nurseryStart.store(nullptr, memory_order_relaxed);
+    nurseryClaim.store(nullptr, memory_order_relaxed);
+    nurseryStarts = nullptr;
+}
@@ -0,0 +1,346 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: src/GCHeapSnapshot.cpp
+// ----------------------------------
+
+#include "../include/GCHeapSnapshot.h"
+#include "../include/GCHeap.h"
+#include "../include/GCObject.h"
+#include "../include/GCTracer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif
+
+using namespace std;
+
+namespace {
+    // Buffered sequential writer; remembers the first error.
+    class SnapshotFile {
+    public:
+        explicit SnapshotFile(const string& path) : out(fopen(path.c_str(), "wb")) {
+            if (out) setvbuf(out, nullptr, _IOFBF, kBuffer);
+        }
+
+        ~SnapshotFile() {
+            if (out) fclose(out);
+        }
+
+        bool isOpen() const { return out != nullptr; }
+
+        void put(const void* data, size_t bytes) {
+            if (ok && bytes && fwrite(data, 1, bytes, out) != bytes) ok = false;
+            offset += bytes;
+        }
+
+        template <typename T>
+        void put(const T& value) { put(&value, sizeof(T)); }
+
+        template <typename T>
+        void put(const vector<T>& values) { put(values.data(), values.size() * sizeof(T)); }
+
+        uint64_t position() const { return offset; }
+
+        // Pads with zeros to a multiple of 8 bytes, so the next section can
+        // be read in place from a mapping.
+        void align() {
+            static constexpr char zeros[8] = {};
+            put(zeros, (8 - offset % 8) % 8);
+        }
+
+        // Rewrites the header, then closes the file.
+        bool finish(const GCSnapshotHeader& header) {
+            ok = ok && fseek(out, 0, SEEK_SET) == 0;
+            put(header);
+            ok = ok && !ferror(out);
+            FILE* f = exchange(out, nullptr);
+            return fclose(f) == 0 && ok;
+        }
+
+    private:
+        static constexpr size_t kBuffer = 1 << 20;
+
+        FILE* out;
+        uint64_t offset = 0;
+        bool ok = true;
+    };
+
+    string typeNameOf(const type_info& type) {
+#if __has_include(<cxxabi.h>)
+        int status = 0;
+        unique_ptr<char, void (*)(void*)> name(abi::__cxa_demangle(type.name(), nullptr, nullptr, &status), free);
+        if (status == 0 && name) return name.get();
+#endif
+        return type.name();
+    }
+
+    // Numbers the heap's objects in address order: pages sorted by
+    // address, cells in order within a page. An object's number is found
+    // from its page's bitmaps in constant time instead of by searching.
+    class ObjectIndex {
+    public:
+        ObjectIndex() : pages(GCHeap::pages()), wordStart(pages.size()) {
+            sort(pages.begin(), pages.end());
+            for (GCPage* page : pages) {
+                wordStart[page->pageIndex] = static_cast<uint32_t>(prefix.size());
+                for (uint32_t w = 0; w < page->bitmapWords(); ++w) {
+                    prefix.push_back(count);
+                    count += static_cast<uint32_t>(popcount(page->allocBits.words[w]));
+                }
+            }
+        }
+
+        // Pages in address order.
+        const vector<GCPage*>& sortedPages() const { return pages; }
+
+        uint32_t size() const { return count; }
+
+        // The object's number, or -1 if no registered object starts there.
+        int64_t find(const GCObject* obj) const {
+            GCPage* page = GCHeap::pageOf(obj);
+            uint32_t cell = page->indexOf(obj);
+            if (page->cellAt(cell) != reinterpret_cast<const char*>(obj) || !page->allocBits.test(cell)) return -1;
+            uint64_t below = page->allocBits.words[cell / 64] & ((uint64_t{1} << (cell % 64)) - 1);
+            return prefix[wordStart[page->pageIndex] + cell / 64] + popcount(below);
+        }
+
+    private:
+        vector<GCPage*> pages;
+        vector<uint32_t> wordStart; // by GCPage::pageIndex: first entry in prefix
+        vector<uint32_t> prefix;    // objects before each bitmap word
+        uint32_t count = 0;
+    };
+
+    uint8_t flagsOf(GCObject* obj, const GCPage* page) {
+        uint16_t header = obj->gcHeader().flags();
+        uint8_t flags = 0;
+        if (page->sizeClass == GCHeap::kLargeClass) flags |= GCSnapshotObject::kLarge;
+        if (header & GCHeader::kMovable) flags |= GCSnapshotObject::kMovable;
+        if (header & GCHeader::kPinned) flags |= GCSnapshotObject::kPinned;
+        return flags;
+    }
+}
+
+bool GCHeapSnapshot::write(const string& path, const vector<GCObject*>& roots) {
+    SnapshotFile file(path);
+    if (!file.isOpen()) return false;
+
+    ObjectIndex index;
+    vector<GCObject*> objects;
+    objects.reserve(index.size());
+    for (GCPage* page : index.sortedPages()) {
+        for (uint32_t w = 0; w < page->bitmapWords(); ++w) {
+            for (uint64_t bits = page->allocBits.words[w]; bits; bits &= bits - 1) {
+                objects.push_back(reinterpret_cast<GCObject*>(page->cellAt(w * 64 + countr_zero(bits))));
+            }
+        }
+    }
+
+    GCSnapshotHeader header{};
+    file.put(header);
+
+    // Edges, object by object. Only the counts are kept, so the object
+    // section can be written after them without tracing twice.
+    header.edgesOffset = file.position();
+    vector<uint32_t> edgeCounts(objects.size());
+    vector<GCObject*> children;
+    vector<uint32_t> targets;
+    GCTracer tracer(GCTracer::Mode::Collect, &children);
+    for (size_t i = 0; i < objects.size(); ++i) {
+        children.clear();
+        targets.clear();
+        objects[i]->trace(tracer);
+        for (GCObject* child : children) {
+            int64_t target = index.find(child);
+            if (target >= 0) targets.push_back(static_cast<uint32_t>(target));
+        }
+        edgeCounts[i] = static_cast<uint32_t>(targets.size());
+        header.edgeCount += targets.size();
+        file.put(targets);
+    }
+
+    file.align();
+    header.objectsOffset = file.position();
+    unordered_map<const type_info*, uint32_t> typeIndex;
+    vector<const type_info*> types;
+    uint64_t firstEdge = 0;
+    for (size_t i = 0; i < objects.size(); ++i) {
+        GCObject* obj = objects[i];
+        const type_info& type = typeid(*obj);
+        auto [it, added] = typeIndex.try_emplace(&type, static_cast<uint32_t>(types.size()));
+        if (added) types.push_back(&type);
+
+        GCPage* page = GCHeap::pageOf(obj);
+        GCSnapshotObject record{};
+        record.address = reinterpret_cast<uintptr_t>(obj);
+        record.firstEdge = firstEdge;
+        record.size = static_cast<uint32_t>(page->sizeClass == GCHeap::kLargeClass ? page->mappedBytes : page->cellSize);
+        record.type = it->second;
+        record.edgeCount = edgeCounts[i];
+        record.generation = page->youngBits.test(page->indexOf(obj)) ? 0 : 1;
+        record.flags = flagsOf(obj, page);
+        file.put(record);
+        firstEdge += edgeCounts[i];
+    }
+
+    header.rootsOffset = file.position();
+    vector<uint32_t> rootIndices;
+    for (GCObject* root : roots) {
+        int64_t target = index.find(root);
+        if (target >= 0) rootIndices.push_back(static_cast<uint32_t>(target));
+    }
+    sort(rootIndices.begin(), rootIndices.end());
+    rootIndices.erase(unique(rootIndices.begin(), rootIndices.end()), rootIndices.end());
+    file.put(rootIndices);
+
+    file.align();
+    header.typesOffset = file.position();
+    vector<string> names;
+    uint64_t nameOffset = 0;
+    for (const type_info* type : types) {
+        names.push_back(typeNameOf(*type));
+        file.put(GCSnapshotType{nameOffset, names.back().size()});
+        nameOffset += names.back().size();
+    }
+
+    header.stringsOffset = file.position();
+    for (const string& name : names) file.put(name.data(), name.size());
+
+    memcpy(header.magic, GCSnapshotHeader::kMagic, sizeof(header.magic));
+    header.version = GCSnapshotHeader::kVersion;
+    header.objectRecordSize = sizeof(GCSnapshotObject);
+    header.objectCount = objects.size();
+    header.rootCount = rootIndices.size();
+    header.typeCount = types.size();
+    header.stringBytes = nameOffset;
+    return file.finish(header);
+}
+
+bool GCHeapSnapshot::open(const string& path) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return fail("cannot open " + path);
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || static_cast<uint64_t>(size.QuadPart) < sizeof(GCSnapshotHeader)) {
+        CloseHandle(file);
+        return fail(path + " is too short to be a heap snapshot");
+    }
+    mappedBytes = static_cast<size_t>(size.QuadPart);
+    // The view holds its own reference to the file, so both handles can go.
+    HANDLE section = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    void* p = section ? MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (section) CloseHandle(section);
+    if (!p) return fail("cannot map " + path);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return fail("cannot open " + path);
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(GCSnapshotHeader)) {
+        ::close(fd);
+        return fail(path + " is too short to be a heap snapshot");
+    }
+    mappedBytes = static_cast<size_t>(st.st_size);
+    void* p = mmap(nullptr, mappedBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) return fail("cannot map " + path);
+#endif
+    mapping = p;
+
+    const auto* base = static_cast<const char*>(mapping);
+    GCSnapshotHeader header;
+    memcpy(&header, base, sizeof(header));
+    if (memcmp(header.magic, GCSnapshotHeader::kMagic, sizeof(header.magic)) != 0) {
+        return fail(path + " is not a heap snapshot");
+    }
+    if (header.version != GCSnapshotHeader::kVersion || header.objectRecordSize != sizeof(GCSnapshotObject)) {
+        return fail(path + " was written by an incompatible version");
+    }
+
+    // Every section must lie inside the file.
+    auto fits = [this](uint64_t offset, uint64_t count, size_t size) {
+        return offset <= mappedBytes && count <= (mappedBytes - offset) / size;
+    };
+    if (!fits(header.edgesOffset, header.edgeCount, sizeof(uint32_t))
+        || !fits(header.objectsOffset, header.objectCount, sizeof(GCSnapshotObject))
+        || !fits(header.rootsOffset, header.rootCount, sizeof(uint32_t))
+        || !fits(header.typesOffset, header.typeCount, sizeof(GCSnapshotType))
+        || !fits(header.stringsOffset, header.stringBytes, 1)) {
+        return fail(path + " is truncated");
+    }
+    edgeList = {reinterpret_cast<const uint32_t*>(base + header.edgesOffset), header.edgeCount};
+    objectList = {reinterpret_cast<const GCSnapshotObject*>(base + header.objectsOffset), header.objectCount};
+    rootList = {reinterpret_cast<const uint32_t*>(base + header.rootsOffset), header.rootCount};
+    typeList = {reinterpret_cast<const GCSnapshotType*>(base + header.typesOffset), header.typeCount};
+    strings = base + header.stringsOffset;
+
+    // So readers can index without checks.
+    for (const GCSnapshotObject& o : objectList) {
+        if (o.firstEdge > edgeList.size() || o.edgeCount > edgeList.size() - o.firstEdge || o.type >= typeList.size()) {
+            return fail(path + " has an invalid object record");
+        }
+    }
+    auto inRange = [this](uint32_t index) { return index < objectList.size(); };
+    if (!all_of(edgeList.begin(), edgeList.end(), inRange) || !all_of(rootList.begin(), rootList.end(), inRange)) {
+        return fail(path + " has an edge to a missing object");
+    }
+    for (const GCSnapshotType& t : typeList) {
+        if (t.nameOffset > header.stringBytes || t.nameLength > header.stringBytes - t.nameOffset) {
+            return fail(path + " has an invalid type name");
+        }
+    }
+    message.clear();
+    return true;
+}
+
+void GCHeapSnapshot::close() {
+    if (mapping) {
+#ifdef _WIN32
+        UnmapViewOfFile(mapping);
+#else
+        munmap(mapping, mappedBytes);
+#endif
+    }
+    mapping = nullptr;
+    mappedBytes = 0;
+    objectList = {};
+    edgeList = {};
+    rootList = {};
+    typeList = {};
+    strings = nullptr;
+}
+
+int64_t GCHeapSnapshot::find(uint64_t address) const {
+    auto it = lower_bound(objectList.begin(), objectList.end(), address,
+                          [](const GCSnapshotObject& o, uint64_t a) { return o.address < a; });
+    return it != objectList.end() && it->address == address ? it - objectList.begin() : -1;
+}
+
+bool GCHeapSnapshot::fail(const string& why) {
+    close();
+    message = why;
+    return false;
+}
@@ -0,0 +1,353 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: src/GCMarker.cpp
+// ----------------------------------
+
+#include "../include/GCMarker.h"
+#include "../include/GCHeap.h"
+#include "../include/GCObject.h"
+#include "../include/GCTracer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    // A worker shares half of its private stack once it grows past this and
+    // its shared deque has run dry.
+    constexpr size_t kShareThreshold = 64;
+
+    // Entries a thief takes from a victim's shared deque at most.
+    constexpr size_t kMaxSteal = 256;
+
+    struct Worker {
+        vector<GCObject*> local;       // private mark stack
+        GCTracer tracer{GCTracer::Mode::MarkAtomic, &local, true};
+        vector<GCObject*> pointsYoung; // old objects with young children
+        size_t scanned = 0;
+
+        mutex sharedLock;
+        deque<GCObject*> shared;       // owner pushes/pops the back, thieves take the front
+        atomic<size_t> sharedSize{0};  // read without the lock to find victims
+    };
+
+    // Helper threads are started once and parked between collections.
+    struct Pool {
+        vector<unique_ptr<Worker>> workers;
+        vector<thread> threads;
+        mutex lock;
+        condition_variable wake;
+        condition_variable done;
+        uint64_t epoch = 0;
+        unsigned running = 0;
+        bool stopping = false;
+        atomic<unsigned> idle{0};
+
+        ~Pool() { stop(); }
+
+        void stop() {
+            {
+                lock_guard<mutex> guard(lock);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (thread& t : threads) t.join();
+            threads.clear();
+            stopping = false;
+        }
+    };
+
+    unsigned requestedWorkers = 1;
+    Pool pool;
+
+    // Objects the collector thread scans before letting the mutator in to
+    // change a member list.
+    constexpr int kBackgroundBatch = 64;
+
+    struct Background {
+        thread worker;
+        mutex lock;
+        condition_variable wake;
+        condition_variable idle;
+        vector<GCObject*> gray;        // marked, children not scanned
+        vector<GCObject*> overwritten; // snapshot entries, maybe unmarked
+        size_t scanned = 0;
+        bool busy = false;
+        bool exiting = false;
+
+        ~Background() {
+            {
+                lock_guard<mutex> guard(lock);
+                exiting = true;
+            }
+            wake.notify_all();
+            if (worker.joinable()) worker.join();
+        }
+    };
+
+    Background background;
+
+    // Held by the collector thread while it scans a batch, and by the
+    // mutator while it edits a member list during background marking.
+    mutex graphLock;
+    atomic<bool> graphShared{false};
+    atomic<int> graphWaiters{0};
+
+    // Slots the workers and the collector thread marked through
+    // GCTracer::visitRange(), until GC::stats() takes them.
+    atomic<size_t> rangeSlots{0};
+
+    void scan(Worker& w, GCObject* obj) {
+        w.tracer.reset();
+        obj->trace(w.tracer);
+        if (w.tracer.pointsYoung() && !GCHeap::isYoung(obj)) w.pointsYoung.push_back(obj);
+        ++w.scanned;
+    }
+
+    // Moves the older half of the private stack to the shared deque. The
+    // bottom of a depth-first stack holds the widest unexplored subtrees.
+    void share(Worker& w) {
+        size_t half = w.local.size() / 2;
+        lock_guard<mutex> guard(w.sharedLock);
+        w.shared.insert(w.shared.end(), w.local.begin(), w.local.begin() + static_cast<ptrdiff_t>(half));
+        w.sharedSize.store(w.shared.size(), memory_order_relaxed);
+        w.local.erase(w.local.begin(), w.local.begin() + static_cast<ptrdiff_t>(half));
+    }
+
+    bool takeShared(Worker& w) {
+        if (w.sharedSize.load(memory_order_relaxed) == 0) return false;
+        lock_guard<mutex> guard(w.sharedLock);
+        if (w.shared.empty()) return false;
+        w.local.push_back(w.shared.back());
+        w.shared.pop_back();
+        w.sharedSize.store(w.shared.size(), memory_order_relaxed);
+        return true;
+    }
+
+    bool steal(Worker& self, unsigned selfIndex, unsigned count) {
+        for (unsigned k = 1; k < count; ++k) {
+            Worker& victim = *pool.workers[(selfIndex + k) % count];
+            if (victim.sharedSize.load(memory_order_relaxed) == 0) continue;
+            lock_guard<mutex> guard(victim.sharedLock);
+            size_t take = min(kMaxSteal, (victim.shared.size() + 1) / 2);
+            if (take == 0) continue;
+            self.local.insert(self.local.end(), victim.shared.begin(), victim.shared.begin() + static_cast<ptrdiff_t>(take));
+            victim.shared.erase(victim.shared.begin(), victim.shared.begin() + static_cast<ptrdiff_t>(take));
+            victim.sharedSize.store(victim.shared.size(), memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    bool anyShared(unsigned count) {
+        for (unsigned k = 0; k < count; ++k) {
+            if (pool.workers[k]->sharedSize.load(memory_order_relaxed) != 0) return true;
+        }
+        return false;
+    }
+
+    // Marks until every worker is idle at once. Work only ever sits in a
+    // busy worker's private stack or in a shared deque, and a worker goes
+    // idle only after finding its own deque empty, so when all are idle no
+    // work is left anywhere.
+    void runWorker(unsigned index, unsigned count) {
+        Worker& w = *pool.workers[index];
+        for (;;) {
+            while (!w.local.empty()) {
+                GCObject* obj = w.local.back();
+                w.local.pop_back();
+                scan(w, obj);
+                if (count > 1 && w.local.size() > kShareThreshold
+                    && w.sharedSize.load(memory_order_relaxed) == 0) {
+                    share(w);
+                }
+            }
+            if (count == 1) return;
+            if (takeShared(w) || steal(w, index, count)) continue;
+
+            pool.idle.fetch_add(1, memory_order_acq_rel);
+            for (;;) {
+                if (pool.idle.load(memory_order_acquire) == count) return;
+                if (anyShared(count)) {
+                    pool.idle.fetch_sub(1, memory_order_acq_rel);
+                    break;
+                }
+                this_thread::yield();
+            }
+        }
+    }
+
+    void helperLoop(unsigned index, uint64_t seen) {
+        for (;;) {
+            unsigned count;
+            {
+                unique_lock<mutex> guard(pool.lock);
+                pool.wake.wait(guard, [&] { return pool.stopping || pool.epoch != seen; });
+                if (pool.stopping) return;
+                seen = pool.epoch;
+                count = static_cast<unsigned>(pool.threads.size()) + 1;
+            }
+            runWorker(index, count);
+            {
+                lock_guard<mutex> guard(pool.lock);
+                --pool.running;
+            }
+            pool.done.notify_one();
+        }
+    }
+
+    void ensureWorkers(unsigned count) {
+        if (pool.workers.size() == count) return;
+        pool.stop();
+        pool.workers.clear();
+        for (unsigned i = 0; i < count; ++i) pool.workers.push_back(make_unique<Worker>());
+        for (unsigned i = 1; i < count; ++i) pool.threads.emplace_back(helperLoop, i, pool.epoch);
+    }
+}
+
+void GCMarker::setWorkerCount(unsigned count) {
+    if (count == 0) count = max(1u, thread::hardware_concurrency());
+    requestedWorkers = count;
+}
+
+unsigned GCMarker::workerCount() {
+    return requestedWorkers;
+}
+
+size_t GCMarker::markFrom(vector<GCObject*>& gray, vector<GCObject*>& pointsYoung) {
+    const unsigned count = requestedWorkers;
+    ensureWorkers(count);
+
+    // Deal the gray objects out round-robin so every worker starts busy.
+    for (unsigned i = 0; i < count; ++i) pool.workers[i]->local.clear();
+    for (size_t i = 0; i < gray.size(); ++i) pool.workers[i % count]->local.push_back(gray[i]);
+    gray.clear();
+
+    if (count > 1) {
+        pool.idle.store(0, memory_order_relaxed);
+        {
+            lock_guard<mutex> guard(pool.lock);
+            pool.running = count - 1;
+            ++pool.epoch;
+        }
+        pool.wake.notify_all();
+    }
+
+    runWorker(0, count);
+
+    if (count > 1) {
+        unique_lock<mutex> guard(pool.lock);
+        pool.done.wait(guard, [] { return pool.running == 0; });
+    }
+
+    size_t scanned = 0;
+    for (unsigned i = 0; i < count; ++i) {
+        Worker& w = *pool.workers[i];
+        scanned += w.scanned;
+        w.scanned = 0;
+        rangeSlots.fetch_add(w.tracer.takeRangeSlots(), memory_order_relaxed);
+        pointsYoung.insert(pointsYoung.end(), w.pointsYoung.begin(), w.pointsYoung.end());
+        w.pointsYoung.clear();
+    }
+    return scanned;
+}
+
+static void backgroundLoop() {
+    vector<GCObject*> stack;
+    vector<GCObject*> shadeList;
+    GCTracer tracer(GCTracer::Mode::MarkAtomic, &stack);
+    unique_lock<mutex> guard(background.lock);
+    for (;;) {
+        background.wake.wait(guard, [] {
+            return background.exiting || !background.gray.empty() || !background.overwritten.empty();
+        });
+        if (background.exiting) return;
+        stack.insert(stack.end(), background.gray.begin(), background.gray.end());
+        background.gray.clear();
+        shadeList.swap(background.overwritten);
+        background.busy = true;
+        guard.unlock();
+
+        for (GCObject* o : shadeList) {
+            if (GCHeap::tryMarkAtomic(o)) stack.push_back(o);
+        }
+        shadeList.clear();
+
+        size_t scanned = 0;
+        while (!stack.empty()) {
+            {
+                lock_guard<mutex> graph(graphLock);
+                for (int n = 0; n < kBackgroundBatch && !stack.empty(); ++n) {
+                    GCObject* obj = stack.back();
+                    stack.pop_back();
+                    obj->trace(tracer);
+                    ++scanned;
+                }
+            }
+            // Let a blocked mutator take the lock before the next batch.
+            while (graphWaiters.load(memory_order_acquire) != 0) this_thread::yield();
+        }
+
+        rangeSlots.fetch_add(tracer.takeRangeSlots(), memory_order_relaxed);
+        guard.lock();
+        background.scanned += scanned;
+        background.busy = false;
+        if (background.gray.empty() && background.overwritten.empty()) background.idle.notify_all();
+    }
+}
+
+void GCMarker::startBackground(vector<GCObject*>& gray) {
+    if (!background.worker.joinable()) background.worker = thread(backgroundLoop);
+    graphShared.store(true, memory_order_relaxed);
+    {
+        lock_guard<mutex> guard(background.lock);
+        background.scanned = 0;
+        background.gray.insert(background.gray.end(), gray.begin(), gray.end());
+    }
+    gray.clear();
+    background.wake.notify_one();
+}
+
+void GCMarker::shade(vector<GCObject*>& overwritten) {
+    {
+        lock_guard<mutex> guard(background.lock);
+        background.overwritten.insert(background.overwritten.end(), overwritten.begin(), overwritten.end());
+    }
+    overwritten.clear();
+    background.wake.notify_one();
+}
+
+bool GCMarker::backgroundIdle(bool wait) {
+    unique_lock<mutex> guard(background.lock);
+    auto idle = [] { return !background.busy && background.gray.empty() && background.overwritten.empty(); };
+    if (wait) background.idle.wait(guard, idle);
+    return idle();
+}
+
+size_t GCMarker::stopBackground() {
+    graphShared.store(false, memory_order_relaxed);
+    lock_guard<mutex> guard(background.lock);
+    return exchange(background.scanned, 0);
+}
+
+size_t GCMarker::takeRangeSlots() {
+    return rangeSlots.exchange(0, memory_order_relaxed);
+}
+
+unique_lock<mutex> GCMarker::lockGraph() {
+    if (!graphShared.load(memory_order_relaxed)) return {};
+    graphWaiters.fetch_add(1, memory_order_acq_rel);
+    unique_lock<mutex> guard(graphLock);
+    graphWaiters.fetch_sub(1, memory_order_acq_rel);
+    return guard;
+}
@@ -8,31 +8,128 @@
 #include "../include/GCObject.h"
 #include "../include/GCRefBase.h"
 #include "../include/GC.h"
+#include "../include/GCHeap.h"
+#include "../include/GCMarker.h"
+#include "../include/GCMember.h"
+#include "../include/GCTracer.h"
 
-#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
 
-GCObject::GCObject() : marked(false), survivalCount(0), generation(Generation::Young) {
+GCObject::GCObject() {
     GC::registerObject(this);
 }
 
-GCObject::~GCObject() = default;
+GCObject::~GCObject() {
+    std::free(header.memberRefs());
+}
+
+Generation GCObject::generation() const {
+    if (GCHeap::inNursery(this)) return Generation::Young;
+    GCPage* page = GCHeap::pageOf(this);
+    return page->youngBits.test(page->indexOf(this)) ? Generation::Young : Generation::Old;
+}
+
+void* GCObject::operator new(std::size_t size) {
+    GC::beforeAllocate(size);
+    return GCHeap::allocate(size);
+}
+
+void GCObject::operator delete(void* p) noexcept {
+    // The collector destroys objects itself, so this only runs when the
+    // constructor of a new T(...) throws.
+    GC::unregisterObject(static_cast<GCObject*>(p));
+    GCHeap::deallocate(p);
+}
 
 void GCObject::addMemberRef(GCRefBase* r) {
-    memberRefs.push_back(r);
+    auto guard = GCMarker::lockGraph();
+    GCMemberRefList* list = header.memberRefs();
+    if (!list || list->size == list->capacity) {
+        if (!list && GCHeap::inNursery(this)) GC::registerNurseryStorage(this);
+        std::uint32_t capacity = list ? list->capacity * 2 : 2;
+        auto* grown = static_cast<GCMemberRefList*>(
+            std::realloc(list, sizeof(GCMemberRefList) + capacity * sizeof(GCRefBase*)));
+        if (!grown) throw std::bad_alloc();
+        if (!list) grown->size = 0;
+        grown->capacity = capacity;
+        list = grown;
+        header.setMemberRefs(list);
+    }
+    list->refs()[list->size++] = r;
 }
 
 void GCObject::removeMemberRef(GCRefBase* r) {
-    memberRefs.erase(std::remove(memberRefs.begin(), memberRefs.end(), r), memberRefs.end());
+    auto guard = GCMarker::lockGraph();
+    GCMemberRefList* list = header.memberRefs();
+    if (!list) return;
+    // Members are destroyed in reverse order, so search from the back.
+    GCRefBase** refs = list->refs();
+    for (std::uint32_t i = list->size; i-- > 0;) {
+        if (refs[i] == r) {
+            refs[i] = refs[--list->size];
+            return;
+        }
+    }
+}
+
+std::span<GCRefBase* const> GCObject::getMemberRefs() const {
+    GCMemberRefList* list = header.memberRefs();
+    if (!list) return {};
+    return {list->refs(), list->size};
+}
+
+void GCObject::relocateMemberRefs(const GCObject* from) {
+    auto delta = reinterpret_cast<const char*>(this) - reinterpret_cast<const char*>(from);
+    GCMemberRefList* list = header.memberRefs();
+    if (!list) return;
+    GCRefBase** refs = list->refs();
+    for (std::uint32_t i = 0; i < list->size; ++i) {
+        refs[i] = reinterpret_cast<GCRefBase*>(reinterpret_cast<char*>(refs[i]) + delta);
+        refs[i]->owner = this;
+    }
+}
+
+void GCObject::visitMemberSlots(void (*visit)(GCObject**)) {
+    if (const GCFieldMap* map = fieldMap()) {
+        char* start = reinterpret_cast<char*>(this);
+        for (std::uint32_t offset : map->offsets) visit(reinterpret_cast<GCObject**>(start + offset));
+    }
+    for (GCRefBase* r : getMemberRefs()) visit(r->slot());
+    visitExtraSlots(visit);
+}
+
+void GCObject::releaseMemberRefs() {
+    std::free(header.memberRefs());
+    header.setMemberRefs(nullptr);
+}
+
+void GCObject::trace(GCTracer& tracer) const {
+    traceFields(tracer);
+    std::vector<GCObject*>& children = tracer.scratch();
+    children.clear();
+    traceChildren(children);
+    for (GCObject* c : children) tracer.visit(c);
 }
 
-const std::vector<GCRefBase*>& GCObject::getMemberRefs() const {
-    return memberRefs;
+void GCObject::traceMembers(GCTracer& tracer) const {
+    traceFields(tracer);
+    for (GCRefBase* r : getMemberRefs()) tracer.visit(*r);
+}
+
+void GCObject::traceFields(GCTracer& tracer) const {
+    const GCFieldMap* map = fieldMap();
+    if (!map) return;
+    const char* start = reinterpret_cast<const char*>(this);
+    for (std::uint32_t offset : map->offsets) {
+        auto* slot = reinterpret_cast<GCObject* const*>(start + offset);
+        tracer.visit(std::atomic_ref<GCObject*>(const_cast<GCObject*&>(*slot)).load(std::memory_order_relaxed));
+    }
 }
 
 void GCObject::traceChildren(std::vector<GCObject*>& out) const {
-    for (GCRefBase* r : memberRefs) {
-        if (!r) continue;
-        GCObject* child = r->getObject();
-        if (child) out.push_back(child);
+    for (GCRefBase* r : getMemberRefs()) {
+        if (GCObject* child = r->load()) out.push_back(child);
     }
 }
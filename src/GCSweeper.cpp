@@ -0,0 +1,99 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: src/GCSweeper.cpp
+// ----------------------------------
+
+#include "../include/GCSweeper.h"
+#include "../include/GCHeap.h"
+#include "../include/GCObject.h"
+
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    struct Sweeper {
+        thread worker;
+        mutex lock;
+        condition_variable wake;
+        condition_variable done;
+        const vector<GCPage*>* pages = nullptr;
+        atomic<size_t> finished{0};
+        bool exiting = false;
+
+        ~Sweeper() {
+            {
+                lock_guard<mutex> guard(lock);
+                exiting = true;
+            }
+            wake.notify_all();
+            if (worker.joinable()) worker.join();
+        }
+    };
+
+    Sweeper sweeper;
+
+    // Destroys the dead objects of one page. Pages are withdrawn from the
+    // allocator until the mutator reclaims them, and objects born black
+    // publish their mark before their alloc bit, so a live cell never
+    // looks dead here.
+    void destroyDead(GCPage* page) {
+        for (uint32_t w = 0; w < page->bitmapWords(); ++w) {
+            uint64_t alloc = page->allocBits.loadAcquire(w);
+            uint64_t dead = alloc & ~page->markBits.loadAcquire(w);
+            while (dead) {
+                uint32_t i = w * 64 + static_cast<uint32_t>(countr_zero(dead));
+                dead &= dead - 1;
+                reinterpret_cast<GCObject*>(page->cellAt(i))->~GCObject();
+            }
+        }
+    }
+
+    void sweeperLoop() {
+        unique_lock<mutex> guard(sweeper.lock);
+        for (;;) {
+            sweeper.wake.wait(guard, [] { return sweeper.exiting || sweeper.pages; });
+            if (sweeper.exiting) return;
+            // The mutator may drop the list once the last page is reported,
+            // so nothing is read from it after that.
+            GCPage* const* pages = sweeper.pages->data();
+            const size_t count = sweeper.pages->size();
+            guard.unlock();
+
+            for (size_t i = 0; i < count; ++i) {
+                destroyDead(pages[i]);
+                sweeper.finished.store(i + 1, memory_order_release);
+            }
+
+            guard.lock();
+            sweeper.pages = nullptr;
+            sweeper.done.notify_all();
+        }
+    }
+}
+
+void GCSweeper::start(const vector<GCPage*>& pages) {
+    if (!sweeper.worker.joinable()) sweeper.worker = thread(sweeperLoop);
+    {
+        lock_guard<mutex> guard(sweeper.lock);
+        sweeper.finished.store(0, memory_order_relaxed);
+        sweeper.pages = &pages;
+    }
+    sweeper.wake.notify_one();
+}
+
+size_t GCSweeper::finished() {
+    return sweeper.finished.load(memory_order_acquire);
+}
+
+void GCSweeper::wait() {
+    unique_lock<mutex> guard(sweeper.lock);
+    sweeper.done.wait(guard, [] { return !sweeper.pages; });
+}
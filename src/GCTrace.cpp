@@ -0,0 +1,131 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: src/GCTrace.cpp
+// ----------------------------------
+
+#include "../include/GCTrace.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    // Every ring ever attached. Rings outlive their threads so their
+    // records can still be dumped, and are reused by later threads.
+    mutex ringsLock;
+    vector<unique_ptr<GCTraceRing>> rings;
+
+    // Releases the thread's ring when it exits.
+    struct RingOwner {
+        GCTraceRing* ring = nullptr;
+        ~RingOwner() {
+            if (ring) ring->inUse.store(false, memory_order_release);
+        }
+    };
+    thread_local RingOwner ringOwner;
+
+    // Pairs a tick count with the steady clock, taken when the first ring is
+    // attached, so ticks can be converted to time when the trace is written.
+    struct ClockPoint {
+        uint64_t ticks;
+        chrono::steady_clock::time_point time;
+    };
+    ClockPoint origin;
+
+    ClockPoint now() { return {GCTrace::ticks(), chrono::steady_clock::now()}; }
+
+    const char* const kPointNames[] = {
+        "Collection", "IncrementalStep", "RootScan", "MarkStep", "SweepStep", "MinorMark",
+        "BlockingMark", "BlockingSweep", "LazySweep", "BackgroundReclaim", "WriteBarrier",
+        "Promotion", "Evacuation", "Compaction", "Finalization", "HeapDump"
+    };
+
+    // Copies the records still in a ring, oldest first. Records the owner
+    // overwrote during the copy are dropped, including the slot of record
+    // `after`, which the owner may be writing before it publishes head.
+    void snapshot(const GCTraceRing& r, vector<GCTraceRecord>& out) {
+        uint64_t head = r.head.load(memory_order_acquire);
+        uint64_t first = head > GCTraceRing::kRecords ? head - GCTraceRing::kRecords : 0;
+        size_t start = out.size();
+        for (uint64_t i = first; i < head; ++i) out.push_back(r.records[i & (GCTraceRing::kRecords - 1)]);
+        // Keeps the copy above from moving past the second load of head.
+        atomic_thread_fence(memory_order_acquire);
+        uint64_t after = r.head.load(memory_order_relaxed);
+        uint64_t overwritten = after + 1 > GCTraceRing::kRecords ? after + 1 - GCTraceRing::kRecords : 0;
+        if (overwritten > first) {
+            auto drop = static_cast<size_t>(min(overwritten, head) - first);
+            out.erase(out.begin() + static_cast<ptrdiff_t>(start), out.begin() + static_cast<ptrdiff_t>(start + drop));
+        }
+    }
+}
+
+GCTraceRing* GCTrace::attachRing() {
+    lock_guard<mutex> guard(ringsLock);
+    GCTraceRing* found = nullptr;
+    for (auto& r : rings) {
+        if (!r->inUse.load(memory_order_acquire)) {
+            r->inUse.store(true, memory_order_relaxed);
+            found = r.get();
+            break;
+        }
+    }
+    if (!found) {
+        if (rings.empty()) origin = now();
+        rings.push_back(make_unique<GCTraceRing>());
+        found = rings.back().get();
+        found->id = static_cast<uint16_t>(rings.size() - 1);
+    }
+    ringOwner.ring = found;
+    ring = found;
+    return found;
+}
+
+bool GCTrace::dump(const string& path) {
+    FILE* out = fopen(path.c_str(), "w");
+    if (!out) return false;
+
+    vector<GCTraceRecord> records;
+    ClockPoint end = now();
+    {
+        lock_guard<mutex> guard(ringsLock);
+        for (auto& r : rings) snapshot(*r, records);
+    }
+
+    // Nanoseconds per tick, measured over the life of the trace.
+    double nsPerTick = 1.0;
+    if (end.ticks > origin.ticks) {
+        chrono::duration<double, nano> elapsed = end.time - origin.time;
+        nsPerTick = elapsed.count() / static_cast<double>(end.ticks - origin.ticks);
+    }
+
+    // Buffered sequential writes; one line per record.
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", out);
+    bool first = true;
+    for (const GCTraceRecord& rec : records) {
+        double us = rec.ticks >= origin.ticks
+            ? static_cast<double>(rec.ticks - origin.ticks) * nsPerTick / 1000.0 : 0.0;
+        const char* phase = rec.kind == GCTraceKind::Begin ? "B" : rec.kind == GCTraceKind::End ? "E" : "i";
+        fprintf(out, "%s\n{\"name\":\"%s\",\"cat\":\"gc\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":%u",
+                first ? "" : ",", kPointNames[static_cast<unsigned>(rec.point)], phase, us,
+                static_cast<unsigned>(rec.thread));
+        if (rec.kind == GCTraceKind::Instant) fputs(",\"s\":\"t\"", out);
+        if (rec.kind != GCTraceKind::Begin) fprintf(out, ",\"args\":{\"value\":%u}", rec.value);
+        fputc('}', out);
+        first = false;
+    }
+    fputs("\n]}\n", out);
+    bool ok = !ferror(out);
+    return fclose(out) == 0 && ok;
+}
+
+void GCTrace::clear() {
+    lock_guard<mutex> guard(ringsLock);
+    for (auto& r : rings) r->head.store(0, memory_order_relaxed);
+}
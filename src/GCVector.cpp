@@ -0,0 +1,93 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: src/GCVector.cpp
+// ----------------------------------
+
+#include "../include/GCVector.h"
+#include "../include/GCMarker.h"
+#include "../include/GCTracer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+using namespace std;
+
+GCVectorBase::GCVectorBase(size_t n) {
+    if (n == 0) return;
+    grow(n);
+    count = n;
+}
+
+GCVectorBase::~GCVectorBase() {
+    free(slots);
+}
+
+void GCVectorBase::trace(GCTracer& tracer) const {
+    traceMembers(tracer);
+    tracer.visitRange(slots, size());
+}
+
+void GCVectorBase::visitExtraSlots(void (*visit)(GCObject**)) {
+    for (size_t i = 0; i < count; ++i) visit(&slots[i]);
+}
+
+void GCVectorBase::grow(size_t n) {
+    size_t capacity = max(n, slotCapacity * 2);
+    // The background marker reads the buffer, so it must not be freed
+    // under it. Slots past the end are kept null.
+    auto guard = GCMarker::lockGraph();
+    auto* grown = static_cast<GCObject**>(realloc(slots, capacity * sizeof(GCObject*)));
+    if (!grown) throw bad_alloc();
+    memset(static_cast<void*>(grown + slotCapacity), 0, (capacity - slotCapacity) * sizeof(GCObject*));
+    slots = grown;
+    slotCapacity = capacity;
+}
+
+void GCVectorBase::overwriteRange(size_t from, size_t to) const {
+    for (size_t i = from; i < to; ++i) GC::deletionBarrier(load(slots[i]));
+}
+
+void GCVectorBase::popBack() {
+    assert(count > 0 && "pop_back on an empty container");
+    size_t n = count - 1;
+    overwriteRange(n, count);
+    setCount(n);
+    store(slots[n], nullptr);
+}
+
+void GCVectorBase::resizeTo(size_t n) {
+    if (n < count) {
+        overwriteRange(n, count);
+        size_t old = count;
+        setCount(n);
+        for (size_t i = n; i < old; ++i) store(slots[i], nullptr);
+    } else if (n > count) {
+        reserveSlots(n);
+        setCount(n);
+    }
+}
+
+void GCVectorBase::fillRange(size_t from, size_t to, GCObject* p) {
+    assert(from <= to && to <= count && "fill range out of bounds");
+    overwriteRange(from, to);
+    for (size_t i = from; i < to; ++i) store(slots[i], p);
+    // Every element holds the same object, so one barrier covers the range.
+    if (p && from < to) GC::writeBarrier(this, p);
+}
+
+void GCVectorBase::copyRange(size_t at, const GCVectorBase& src, size_t from, size_t n) {
+    assert(at + n <= count && from + n <= src.count && "copy range out of bounds");
+    overwriteRange(at, at + n);
+    // Plain memmove would tear elements the background marker is reading.
+    if (&src == this && at > from) {
+        for (size_t i = n; i-- > 0;) store(slots[at + i], load(src.slots[from + i]));
+    } else {
+        for (size_t i = 0; i < n; ++i) store(slots[at + i], load(src.slots[from + i]));
+    }
+    GC::writeBarrierRange(this, slots + at, n);
+}
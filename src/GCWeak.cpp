@@ -0,0 +1,54 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: src/GCWeak.cpp
+// ----------------------------------
+
+#include "../include/GCWeak.h"
+
+#include <cassert>
+
+using namespace std;
+
+GCObject* GCEphemeronTable::find(GCObject* key) const {
+    auto it = index.find(key);
+    if (it == index.end()) return nullptr;
+    GCObject* value = entries[it->second].value;
+    GC::readBarrier(value);
+    return value;
+}
+
+void GCEphemeronTable::insert(GCObject* key, GCObject* value) {
+    assert(key && "ephemeron keys must not be null");
+    auto [it, added] = index.try_emplace(key, entries.size());
+    if (added) {
+        entries.push_back({key, value});
+    } else {
+        entries[it->second].value = value;
+    }
+}
+
+bool GCEphemeronTable::erase(GCObject* key) {
+    auto it = index.find(key);
+    if (it == index.end()) return false;
+    size_t slot = it->second;
+    index.erase(it);
+    if (slot != entries.size() - 1) {
+        entries[slot] = entries.back();
+        index[entries[slot].key] = slot;
+    }
+    entries.pop_back();
+    return true;
+}
+
+void GCEphemeronTable::clear() {
+    entries.clear();
+    index.clear();
+}
+
+void GCEphemeronTable::reindex() {
+    index.clear();
+    index.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) index.emplace(entries[i].key, i);
+}
@@ -0,0 +1,111 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: tests/test_gc_compact.cpp
+// ----------------------------------
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "GC.h"
+#include "GCHeap.h"
+#include "GCMember.h"
+#include "GCObject.h"
+#include "GCRef.h"
+#include "GCWeak.h"
+
+#include <vector>
+
+class CompactNode : public GCObject {
+public:
+    static constexpr bool gcMovable = true;
+    GCRef<CompactNode> next;
+    int value;
+
+    explicit CompactNode(int v = 0) : next(this, nullptr), value(v) {}
+};
+
+class CompactHolder : public GCObject {
+public:
+    GCMember<CompactNode> node;
+
+    GC_FIELDS(&CompactHolder::node)
+};
+
+// Allocates `count` movable nodes, moves them onto heap pages and keeps
+// every `keepEvery`-th one, each linked to the previous kept node.
+static std::vector<GCRef<CompactNode>> scatter(int count, int keepEvery) {
+    std::vector<GCRef<CompactNode>> all;
+    all.reserve(count);
+    for (int i = 0; i < count; ++i) all.emplace_back(GC::make<CompactNode>(i));
+    GC::collectNow(false);
+
+    std::vector<GCRef<CompactNode>> kept;
+    for (int i = 0; i < count; i += keepEvery) {
+        if (!kept.empty()) all[i]->next = kept.back().get();
+        kept.push_back(all[i]);
+    }
+    return kept;
+}
+
+TEST_CASE("Compaction empties sparse pages and redirects references") {
+    GC::init(50, 50, 0, 50);
+    GC::collectNow(true);
+    GC::setCompaction(true);
+    std::vector<GCRef<CompactNode>> kept = scatter(20000, 8);
+    REQUIRE_FALSE(GCHeap::inNursery(kept.front().get()));
+
+    CompactNode* pinned = kept[10].get();
+    GC::pin(pinned);
+    GCWeakRef<CompactNode> weak(kept[5].get());
+    GCEphemeronMap<CompactNode, CompactNode> map;
+    map.set(kept[6].get(), kept[7].get());
+    GCRef<CompactHolder> holder(GC::make<CompactHolder>());
+    holder->node = kept[8].get();
+
+    GCStats before = GC::stats();
+    GC::collectNow(true);
+    GCStats after = GC::stats();
+
+    REQUIRE(after.pagesCompacted > before.pagesCompacted);
+    REQUIRE(after.objectsCompacted > before.objectsCompacted);
+    REQUIRE(after.mappedBytes < before.mappedBytes);
+    REQUIRE(kept[10].get() == pinned);
+
+    for (size_t i = 0; i < kept.size(); ++i) {
+        REQUIRE(kept[i]->value == static_cast<int>(i) * 8);
+        if (i > 0) REQUIRE(kept[i]->next.get() == kept[i - 1].get());
+    }
+    REQUIRE(weak.get() == kept[5].get());
+    REQUIRE(map.get(kept[6].get()) == kept[7].get());
+    REQUIRE(holder->node.get() == kept[8].get());
+
+    // The moved objects are still collected normally.
+    GC::unpin(pinned);
+    kept.clear();
+    holder = nullptr;
+    GC::collectNow(true);
+    REQUIRE(weak.expired());
+    REQUIRE(map.size() == 0);
+    GC::setCompaction(false);
+}
+
+TEST_CASE("Pages holding non-movable objects stay in place") {
+    GC::init(50, 50, 0, 50);
+    GC::collectNow(true);
+    GC::setCompaction(true);
+    std::vector<GCRef<CompactHolder>> holders;
+    for (int i = 0; i < 2000; ++i) {
+        GCRef<CompactHolder> h(GC::make<CompactHolder>());
+        if (i % 16 == 0) holders.push_back(h);
+    }
+    std::vector<CompactHolder*> addresses;
+    for (auto& h : holders) addresses.push_back(h.get());
+
+    GC::collectNow(true);
+    for (size_t i = 0; i < holders.size(); ++i) REQUIRE(holders[i].get() == addresses[i]);
+
+    holders.clear();
+    GC::collectNow(true);
+    GC::setCompaction(false);
+}
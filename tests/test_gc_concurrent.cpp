@@ -0,0 +1,113 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: tests/test_gc_concurrent.cpp
+// ----------------------------------
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "GC.h"
+#include "GCObject.h"
+#include "GCRef.h"
+
+#include <atomic>
+#include <thread>
+
+class ConcNode : public GCObject {
+public:
+    GCRef<ConcNode> next;
+    GCRef<ConcNode> side;
+    int value;
+    static std::atomic<int> live;
+    static std::atomic<int> tracedOnMain;
+    static std::thread::id mainThread;
+
+    explicit ConcNode(int v = 0) : next(this, nullptr), side(this, nullptr), value(v) { ++live; }
+    ~ConcNode() override { --live; }
+
+    void traceChildren(std::vector<GCObject*>& out) const override {
+        if (std::this_thread::get_id() == mainThread) ++tracedOnMain;
+        GCObject::traceChildren(out);
+    }
+};
+
+std::atomic<int> ConcNode::live{0};
+std::atomic<int> ConcNode::tracedOnMain{0};
+std::thread::id ConcNode::mainThread = std::this_thread::get_id();
+
+static ConcNode* buildChain(int n) {
+    ConcNode* head = GC::make<ConcNode>(0);
+    ConcNode* tail = head;
+    for (int i = 1; i < n; ++i) {
+        tail->next = GC::make<ConcNode>(i);
+        tail = tail->next.get();
+    }
+    return head;
+}
+
+TEST_CASE("Concurrent marking keeps objects moved behind the marker") {
+    GC::init(50, 1000, 1000000, 50);
+    GC::setConcurrentMarking(true);
+
+    const int n = 20000;
+    GCRef<ConcNode> a(buildChain(n));
+    GCRef<ConcNode> b(GC::make<ConcNode>(-1));
+
+    GC::startIncrementalCollect();
+    GC::incrementalCollectStep();
+
+    // Cut the second half of the chain loose and hang it off b while the
+    // collector thread may still be walking the first half. Only the
+    // deletion barrier tells the marker about it.
+    ConcNode* mid = a.get();
+    for (int i = 0; i < n / 2 - 1; ++i) mid = mid->next.get();
+    b->side = mid->next.get();
+    mid->next = nullptr;
+
+    // Objects allocated during the cycle are black.
+    b->next = GC::make<ConcNode>(-2);
+
+    while (!GC::incrementalCollectStep()) {}
+
+    REQUIRE(ConcNode::live == n + 2);
+    int count = 0;
+    for (ConcNode* c = b->side.get(); c; c = c->next.get()) {
+        REQUIRE(c->value == n / 2 + count);
+        ++count;
+    }
+    REQUIRE(count == n / 2);
+
+    a = nullptr;
+    b = nullptr;
+    GC::collectNow(true);
+    REQUIRE(ConcNode::live == 0);
+    GC::setConcurrentMarking(false);
+}
+
+TEST_CASE("Concurrent cycle does not trace the heap on the mutator thread") {
+    GC::init(50, 1000000, 1000000, 50);
+    GC::setConcurrentMarking(true);
+
+    GCRef<ConcNode> root(buildChain(50000));
+    buildChain(1000);
+
+    ConcNode::tracedOnMain = 0;
+    GC::startIncrementalCollect();
+    while (!GC::incrementalCollectStep()) {
+        root->side = GC::make<ConcNode>(1);
+    }
+
+    // The remark only traces objects the mutator overwrote, not the chain.
+    REQUIRE(ConcNode::tracedOnMain < 1000);
+
+    // Objects allocated during the cycle were born black and are only
+    // reclaimed by the next one.
+    GC::collectNow(true);
+    REQUIRE(ConcNode::live == 50000 + 1);
+
+    root = nullptr;
+    GC::collectNow(true);
+    REQUIRE(ConcNode::live == 0);
+    GC::setConcurrentMarking(false);
+}
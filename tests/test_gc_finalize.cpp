@@ -0,0 +1,120 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: tests/test_gc_finalize.cpp
+// ----------------------------------
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "GC.h"
+#include "GCHeap.h"
+#include "GCObject.h"
+#include "GCRef.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+class FinalNode : public GCObject {
+public:
+    GCRef<FinalNode> next;
+    static std::atomic<int> live;
+
+    FinalNode() : next(this, nullptr) { ++live; }
+    ~FinalNode() override { --live; }
+};
+
+std::atomic<int> FinalNode::live{0};
+
+class LargeFinalNode : public GCObject {
+public:
+    char payload[GCHeap::kMaxSmallSize * 2];
+    static std::atomic<int> live;
+
+    LargeFinalNode() { ++live; }
+    ~LargeFinalNode() override { --live; }
+};
+
+std::atomic<int> LargeFinalNode::live{0};
+
+TEST_CASE("Deferred finalization queues dead objects until the application runs them") {
+    GC::init(50, 50, 0, 50);
+    GC::setFinalization(GCFinalization::Deferred);
+    GCRef<FinalNode> kept(GC::make<FinalNode>());
+    for (int i = 0; i < 100; ++i) {
+        FinalNode* n = GC::make<FinalNode>();
+        n->next = GC::make<FinalNode>();
+    }
+
+    GC::collectNow(true);
+    REQUIRE(FinalNode::live == 201);
+    REQUIRE(GC::pendingFinalizers() == 200);
+
+    // A zero budget still finishes the destructor it started.
+    REQUIRE(GC::runFinalizers(std::chrono::nanoseconds(0)) == 1);
+    REQUIRE(GC::pendingFinalizers() == 199);
+
+    REQUIRE(GC::runFinalizers() == 199);
+    REQUIRE(GC::pendingFinalizers() == 0);
+    REQUIRE(FinalNode::live == 1);
+
+    kept = nullptr;
+    GC::collectNow(true);
+    GC::setFinalization(GCFinalization::Inline);
+    REQUIRE(GC::pendingFinalizers() == 0);
+    REQUIRE(FinalNode::live == 0);
+}
+
+TEST_CASE("Queued large objects keep their pages until finalized") {
+    GC::init(50, 50, 0, 50);
+    GC::setFinalization(GCFinalization::Deferred);
+    GC::make<LargeFinalNode>();
+    std::size_t mapped = GCHeap::mappedBytes();
+
+    GC::collectNow(true);
+    REQUIRE(LargeFinalNode::live == 1);
+    REQUIRE(GCHeap::mappedBytes() == mapped);
+
+    REQUIRE(GC::runFinalizers() == 1);
+    REQUIRE(LargeFinalNode::live == 0);
+    REQUIRE(GCHeap::mappedBytes() < mapped);
+    GC::setFinalization(GCFinalization::Inline);
+}
+
+TEST_CASE("The finalizer thread drains the queue while the mutator collects") {
+    GC::init(50, 50, 0, 50);
+    GC::setFinalization(GCFinalization::Background);
+    GCRef<FinalNode> kept(GC::make<FinalNode>());
+    for (int round = 0; round < 20; ++round) {
+        for (int i = 0; i < 200; ++i) GC::make<FinalNode>();
+        GC::collectNow(round % 2 == 0);
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (GC::pendingFinalizers() != 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+    REQUIRE(GC::pendingFinalizers() == 0);
+    REQUIRE(FinalNode::live == 1);
+
+    kept = nullptr;
+    GC::collectNow(true);
+    GC::setFinalization(GCFinalization::Inline);
+    REQUIRE(FinalNode::live == 0);
+}
+
+TEST_CASE("Incremental sweeps queue dead objects as well") {
+    GC::init(50, 50, 0, 50);
+    GC::setFinalization(GCFinalization::Deferred);
+    for (int i = 0; i < 100; ++i) GC::make<FinalNode>();
+
+    GC::startIncrementalCollect();
+    while (!GC::incrementalCollectStep()) {}
+    GC::collectNow(false);
+    REQUIRE(GC::pendingFinalizers() == 100);
+
+    GC::setFinalization(GCFinalization::Inline);
+    REQUIRE(GC::pendingFinalizers() == 0);
+    REQUIRE(FinalNode::live == 0);
+}
@@ -0,0 +1,105 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: tests/test_gc_generational.cpp
+// ----------------------------------
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "GC.h"
+#include "GCObject.h"
+#include "GCRef.h"
+
+#include <vector>
+
+class GenNode : public GCObject {
+public:
+    GCRef<GenNode> child;
+    static int traced;
+    static int live;
+
+    GenNode() : child(this, nullptr) { ++live; }
+    ~GenNode() override { --live; }
+
+    void traceChildren(std::vector<GCObject*>& out) const override {
+        ++traced;
+        GCObject::traceChildren(out);
+    }
+};
+
+int GenNode::traced = 0;
+int GenNode::live = 0;
+
+static void promote() {
+    GC::collectNow(false);
+    GC::collectNow(false);
+}
+
+TEST_CASE("Old-to-young store keeps the young object alive across minor GCs") {
+    GC::init(50, 50, 1000000, 50);
+
+    GCRef<GenNode> root(GC::make<GenNode>());
+    promote();
+    REQUIRE(root->generation() == Generation::Old);
+
+    GenNode* young = GC::make<GenNode>();
+    root->child = young;
+    REQUIRE(young->generation() == Generation::Young);
+
+    GC::collectNow(false);
+    REQUIRE(root->child.get() == young);
+    REQUIRE(GenNode::live == 2);
+
+    GC::collectNow(false);
+    REQUIRE(young->generation() == Generation::Old);
+
+    root = nullptr;
+    GC::collectNow(true);
+    REQUIRE(GenNode::live == 0);
+}
+
+TEST_CASE("Minor GC does not trace the old generation") {
+    GC::init(50, 50, 1000000, 50);
+
+    const int n = 200;
+    GCRef<GenNode> head(GC::make<GenNode>());
+    GenNode* tail = head.get();
+    for (int i = 0; i < n; ++i) {
+        GenNode* next = GC::make<GenNode>();
+        tail->child = next;
+        tail = next;
+    }
+    promote();
+
+    GenNode::traced = 0;
+    GC::make<GenNode>();
+    GC::collectNow(false);
+    REQUIRE(GenNode::traced == 0);
+    REQUIRE(GenNode::live == n + 1);
+
+    head = nullptr;
+    GC::collectNow(true);
+    REQUIRE(GenNode::live == 0);
+}
+
+TEST_CASE("Promoted parent remembers a child that is still young") {
+    GC::init(50, 50, 1000000, 50);
+
+    GCRef<GenNode> root(GC::make<GenNode>());
+    GC::collectNow(false);
+
+    // root has aged once; its new child is born now and lags one survival.
+    root->child = GC::make<GenNode>();
+    GC::collectNow(false);
+    REQUIRE(root->generation() == Generation::Old);
+    REQUIRE(root->child->generation() == Generation::Young);
+
+    GC::collectNow(false);
+    REQUIRE(GenNode::live == 2);
+    REQUIRE(root->child->generation() == Generation::Old);
+
+    root = nullptr;
+    GC::collectNow(true);
+    REQUIRE(GenNode::live == 0);
+}
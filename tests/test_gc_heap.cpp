@@ -0,0 +1,223 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: tests/test_gc_heap.cpp
+// ----------------------------------
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "GC.h"
+#include "GCHeap.h"
+#include "GCObject.h"
+#include "GCRef.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+class HeapLeaf : public GCObject {
+public:
+    int value;
+    explicit HeapLeaf(int v) : value(v) {}
+};
+
+class HeapBlob : public GCObject {
+public:
+    char payload[GCHeap::kMaxSmallSize * 2];
+};
+
+class HeapBoom : public GCObject {
+public:
+    HeapBoom() { throw std::runtime_error("boom"); }
+};
+
+class HeapBigBoom : public GCObject {
+public:
+    char payload[GCHeap::kMaxSmallSize * 2];
+    HeapBigBoom() { throw std::runtime_error("boom"); }
+};
+
+class HeapMovableBoom : public GCObject {
+public:
+    static constexpr bool gcMovable = true;
+    HeapMovableBoom() { throw std::runtime_error("boom"); }
+};
+
+// Empty, so GCObject still starts the object; it throws before GCObject()
+// has registered anything.
+class HeapBoomBase {
+public:
+    HeapBoomBase() { throw std::runtime_error("boom"); }
+};
+
+class HeapEarlyBoom : public HeapBoomBase, public GCObject {
+public:
+    static constexpr bool gcMovable = true;
+};
+
+class HeapBranch : public GCObject {
+public:
+    GCRef<HeapLeaf> a, b, c, d;
+
+    HeapBranch() : a(this, nullptr), b(this, nullptr), c(this, nullptr), d(this, nullptr) {}
+};
+
+TEST_CASE("make allocates from size-class pages") {
+    GC::init(50, 50, 1000000, 50);
+
+    HeapLeaf* a = GC::make<HeapLeaf>(1);
+    HeapLeaf* b = GC::make<HeapLeaf>(2);
+    GCRef<HeapLeaf> ra(a);
+    GCRef<HeapLeaf> rb(b);
+
+    REQUIRE(a->value == 1);
+    REQUIRE(b->value == 2);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(a) % GCHeap::kCellAlign == 0);
+
+    GCPage* page = GCHeap::pageOf(a);
+    REQUIRE(page->sizeClass == GCHeap::sizeClassFor(sizeof(HeapLeaf)));
+    REQUIRE(GCHeap::pageOf(b) == page);
+
+    ra = nullptr;
+    rb = nullptr;
+    GC::collectNow(true);
+}
+
+TEST_CASE("Swept cells are reused by later allocations") {
+    GC::init(50, 50, 1000000, 50);
+
+    HeapLeaf* dead = GC::make<HeapLeaf>(7);
+    GC::collectNow(true);
+
+    HeapLeaf* reused = new HeapLeaf(8);
+    GCRef<HeapLeaf> keep(reused);
+    REQUIRE(reused == dead);
+
+    keep = nullptr;
+    GC::collectNow(true);
+}
+
+TEST_CASE("Large objects get a page of their own") {
+    GC::init(50, 50, 1000000, 50);
+
+    std::size_t before = GCHeap::mappedBytes();
+    HeapBlob* blob = GC::make<HeapBlob>();
+    GCPage* page = GCHeap::pageOf(blob);
+    REQUIRE(page->sizeClass == GCHeap::kLargeClass);
+    REQUIRE(GCHeap::mappedBytes() > before);
+
+    GC::collectNow(true);
+    REQUIRE(GCHeap::mappedBytes() == before);
+}
+
+TEST_CASE("Survivors are promoted in place after two minor collections") {
+    GC::init(50, 50, 1000000, 50);
+
+    HeapLeaf* leaf = GC::make<HeapLeaf>(3);
+    GCRef<HeapLeaf> keep(leaf);
+    GCPage* page = GCHeap::pageOf(leaf);
+    std::uint32_t cell = page->indexOf(leaf);
+    REQUIRE(page->allocBits.test(cell));
+    REQUIRE(page->youngBits.test(cell));
+
+    GC::collectNow(false);
+    REQUIRE(page->youngBits.test(cell));
+    GC::collectNow(false);
+    REQUIRE_FALSE(page->youngBits.test(cell));
+    REQUIRE(leaf->generation() == Generation::Old);
+    REQUIRE(keep->value == 3);
+
+    keep = nullptr;
+    GC::collectNow(true);
+    REQUIRE_FALSE(page->allocBits.test(cell));
+}
+
+TEST_CASE("Budgeted sweep resumes mid-word without losing cells") {
+    GC::init(1000, 3, 1000000, 50);
+
+    std::vector<GCRef<HeapLeaf>> keep;
+    std::vector<HeapLeaf*> kept;
+    for (int i = 0; i < 300; ++i) {
+        HeapLeaf* leaf = GC::make<HeapLeaf>(i);
+        if (i % 3 == 0) {
+            keep.emplace_back(leaf);
+            kept.push_back(leaf);
+        }
+    }
+
+    GC::startIncrementalCollect();
+    while (!GC::incrementalCollectStep()) {}
+
+    for (std::size_t i = 0; i < kept.size(); ++i) {
+        GCPage* page = GCHeap::pageOf(kept[i]);
+        REQUIRE(page->allocBits.test(page->indexOf(kept[i])));
+        REQUIRE(kept[i]->value == static_cast<int>(i) * 3);
+    }
+
+    keep.clear();
+    GC::collectNow(true);
+    for (HeapLeaf* leaf : kept) {
+        GCPage* page = GCHeap::pageOf(leaf);
+        REQUIRE_FALSE(page->allocBits.test(page->indexOf(leaf)));
+    }
+}
+
+TEST_CASE("GCObject adds one header word to the vtable pointer") {
+    REQUIRE(sizeof(GCObject) == sizeof(void*) + sizeof(GCHeader));
+    REQUIRE(sizeof(GCHeader) == 8);
+}
+
+TEST_CASE("Header flags survive member list changes") {
+    GC::init(50, 50, 1000000, 50);
+
+    GCRef<HeapBranch> branch(GC::make<HeapBranch>());
+    branch->gcHeader().setFlags(0x8001);
+    REQUIRE(branch->getMemberRefs().size() == 4);
+
+    // Replace a member out of order; the list is compacted by swapping.
+    branch->b = GCRef<HeapLeaf>(branch.get(), GC::make<HeapLeaf>(2));
+    branch->d = GC::make<HeapLeaf>(4);
+    REQUIRE(branch->getMemberRefs().size() == 4);
+    REQUIRE(branch->gcHeader().flags() == 0x8001);
+
+    GC::collectNow(true);
+    REQUIRE(branch->b->value == 2);
+    REQUIRE(branch->d->value == 4);
+
+    branch->gcHeader().clearFlags(0x8001);
+    REQUIRE(branch->gcHeader().flags() == 0);
+    REQUIRE(branch->getMemberRefs().size() == 4);
+    branch = nullptr;
+    GC::collectNow(true);
+}
+
+TEST_CASE("A throwing constructor leaves no accounting behind") {
+    GC::init(50, 50, 1000000, 50);
+    GC::collectNow(true);
+    GCStats before = GC::stats();
+
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE_THROWS_AS(GC::make<HeapBoom>(), std::runtime_error);
+        REQUIRE_THROWS_AS(new HeapBoom(), std::runtime_error);
+        REQUIRE_THROWS_AS(GC::make<HeapMovableBoom>(), std::runtime_error);
+        REQUIRE_THROWS_AS(GC::make<HeapEarlyBoom>(), std::runtime_error);
+        REQUIRE_THROWS_AS(new HeapEarlyBoom(), std::runtime_error);
+    }
+    for (int i = 0; i < 10; ++i) {
+        REQUIRE_THROWS_AS(GC::make<HeapBigBoom>(), std::runtime_error);
+    }
+
+    GCStats after = GC::stats();
+    REQUIRE(after.heapBytes == before.heapBytes);
+    REQUIRE(after.youngObjects == before.youngObjects);
+    REQUIRE(after.largeObjects == before.largeObjects);
+    REQUIRE(after.nurseryObjects == before.nurseryObjects);
+    REQUIRE(after.objectsAllocated == before.objectsAllocated);
+
+    // The freed cells are reused.
+    HeapLeaf* leaf = GC::make<HeapLeaf>(1);
+    REQUIRE(leaf->value == 1);
+    GC::collectNow(true);
+    REQUIRE(GC::stats().heapBytes == before.heapBytes);
+}
@@ -0,0 +1,205 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: tests/test_gc_heap_policy.cpp
+// ----------------------------------
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "GC.h"
+#include "GCMember.h"
+#include "GCObject.h"
+#include "GCRef.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+class BudgetNode : public GCObject {
+public:
+    GCMember<BudgetNode> next;
+    static int live;
+
+    BudgetNode() { ++live; }
+    ~BudgetNode() override { --live; }
+
+    GC_FIELDS(&BudgetNode::next)
+};
+
+int BudgetNode::live = 0;
+
+static BudgetNode* buildBudgetChain(int length) {
+    BudgetNode* head = GC::make<BudgetNode>();
+    BudgetNode* tail = head;
+    for (int i = 1; i < length; ++i) {
+        tail->next = GC::make<BudgetNode>();
+        tail = tail->next.get();
+    }
+    return head;
+}
+
+TEST_CASE("A cycle starts once the heap grows past its goal") {
+    GC::init(50, 50, 0, 50);
+    GCHeapPolicy policy;
+    policy.minHeapBytes = 256 * 1024;
+    GC::setHeapPolicy(policy);
+
+    GCRef<BudgetNode> kept(buildBudgetChain(20000));
+    GC::collectNow(true);
+    size_t live = GC::heapBytes();
+    REQUIRE(live >= 20000 * sizeof(BudgetNode));
+    REQUIRE(GC::heapGoal() == std::max(policy.minHeapBytes, 2 * live));
+
+    // Stay well below the goal: no cycle has started, so a step finds
+    // nothing to do.
+    for (int i = 0; i < 1000; ++i) GC::make<BudgetNode>();
+    REQUIRE(GC::incrementalCollectStep());
+
+    while (GC::heapBytes() < GC::heapGoal()) GC::make<BudgetNode>();
+    REQUIRE_FALSE(GC::incrementalCollectStep());
+    while (!GC::incrementalCollectStep()) {}
+    GC::collectNow(true);
+    REQUIRE(BudgetNode::live == 20000);
+
+    kept = nullptr;
+    GC::setHeapPolicy(GCHeapPolicy{});
+    GC::collectNow(true);
+    REQUIRE(BudgetNode::live == 0);
+}
+
+TEST_CASE("The soft target caps the goal while live data fits under it") {
+    GC::init(50, 50, 0, 50);
+    GCHeapPolicy policy;
+    policy.minHeapBytes = 0;
+    policy.softLimitBytes = 1024 * 1024;
+    GC::setHeapPolicy(policy);
+
+    GCRef<BudgetNode> kept(buildBudgetChain(20000));
+    GC::collectNow(true);
+    size_t live = GC::heapBytes();
+    REQUIRE(live < policy.softLimitBytes);
+    REQUIRE(2 * live > policy.softLimitBytes);
+    REQUIRE(GC::heapGoal() == policy.softLimitBytes);
+
+    // Past the target the heap only gets a sliver of room to grow.
+    kept = buildBudgetChain(40000);
+    GC::collectNow(true);
+    live = GC::heapBytes();
+    REQUIRE(live > policy.softLimitBytes);
+    REQUIRE(GC::heapGoal() == live + live / 16);
+
+    // With no growth ratio the soft target is the only trigger.
+    policy.growthRatio = 0;
+    policy.softLimitBytes = 0;
+    GC::setHeapPolicy(policy);
+    REQUIRE(GC::heapGoal() == SIZE_MAX);
+
+    kept = nullptr;
+    GC::setHeapPolicy(GCHeapPolicy{});
+    GC::collectNow(true);
+    REQUIRE(BudgetNode::live == 0);
+}
+
+// An allocation may pass the hard limit by one object before the next
+// safepoint collects.
+constexpr size_t kLimitSlack = 256;
+
+TEST_CASE("The hard limit collects at the next safepoint and then throws") {
+    GC::init(50, 50, 0, 50);
+    GCHeapPolicy policy;
+    policy.growthRatio = 0;
+    policy.hardLimitBytes = 2 * 1024 * 1024;
+    GC::setHeapPolicy(policy);
+    GC::collectNow(true);
+
+    // Garbage alone never takes the heap much over the limit, even though
+    // nothing but the limit starts a collection.
+    size_t peak = 0;
+    for (int i = 0; i < 200000; ++i) {
+        GC::make<BudgetNode>();
+        peak = std::max(peak, GC::heapBytes());
+        GC::safepoint();
+    }
+    REQUIRE(peak <= policy.hardLimitBytes + kLimitSlack);
+    REQUIRE(BudgetNode::live < 200000);
+
+    // Live data that does not fit is refused once a collection could not
+    // make room.
+    GCRef<BudgetNode> kept(GC::make<BudgetNode>());
+    REQUIRE_THROWS_AS(
+        [&] {
+            BudgetNode* tail = kept.get();
+            for (;;) {
+                tail->next = GC::make<BudgetNode>();
+                tail = tail->next.get();
+                GC::safepoint();
+            }
+        }(),
+        std::bad_alloc);
+    REQUIRE(GC::heapBytes() <= policy.hardLimitBytes + kLimitSlack);
+
+    kept = nullptr;
+    GC::setHeapPolicy(GCHeapPolicy{});
+    GC::collectNow(true);
+    REQUIRE(BudgetNode::live == 0);
+}
+
+class LimitPair : public GCObject {
+public:
+    GCMember<BudgetNode> left;
+    GCMember<BudgetNode> right;
+    static int destroyed;
+
+    // Nothing roots the pair while it allocates its children.
+    LimitPair() : left(GC::make<BudgetNode>()), right(GC::make<BudgetNode>()) {}
+    ~LimitPair() override { ++destroyed; }
+
+    GC_FIELDS(&LimitPair::left, &LimitPair::right)
+};
+
+int LimitPair::destroyed = 0;
+
+TEST_CASE("The hard limit never collects an object under construction") {
+    GC::init(50, 50, 0, 50);
+    GCHeapPolicy policy;
+    policy.growthRatio = 0;
+    policy.hardLimitBytes = 256 * 1024;
+    GC::setHeapPolicy(policy);
+    GC::collectNow(true);
+    LimitPair::destroyed = 0;
+    std::uint64_t majors = GC::stats().majorCollections;
+
+    GCRef<LimitPair> current;
+    for (int i = 0; i < 20000; ++i) {
+        // Pairs before the one `current` holds may be dead, never this one.
+        LimitPair* made = GC::make<LimitPair>();
+        REQUIRE(LimitPair::destroyed <= std::max(i - 1, 0));
+        current = made;
+        GC::safepoint();
+    }
+    REQUIRE(GC::stats().majorCollections > majors);
+    REQUIRE(current->left.get() != nullptr);
+    REQUIRE(current->right.get() != nullptr);
+
+    current = nullptr;
+    GC::setHeapPolicy(GCHeapPolicy{});
+    GC::collectNow(true);
+    REQUIRE(BudgetNode::live == 0);
+}
+
+TEST_CASE("The cgroup limit lowers the soft target") {
+    GC::init(50, 50, 0, 50);
+    size_t limit = GC::cgroupMemoryLimit();
+
+    GCHeapPolicy policy;
+    policy.useCgroupLimit = true;
+    GC::setHeapPolicy(policy);
+    GC::collectNow(true);
+    if (limit) {
+        REQUIRE(GC::heapGoal() <= std::max(limit / 4 * 3, GC::heapBytes() + GC::heapBytes() / 16));
+    } else {
+        REQUIRE(GC::heapGoal() == std::max(policy.minHeapBytes, 2 * GC::heapBytes()));
+    }
+    GC::setHeapPolicy(GCHeapPolicy{});
+}
@@ -0,0 +1,92 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: tests/test_gc_large.cpp
+// ----------------------------------
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "GC.h"
+#include "GCHeap.h"
+#include "GCObject.h"
+#include "GCRef.h"
+
+#include <new>
+
+class LargeBuffer : public GCObject {
+public:
+    GCRef<GCObject> child;
+    char bytes[1 << 20];
+    static int live;
+
+    LargeBuffer() : child(this, nullptr) { ++live; }
+    ~LargeBuffer() override { --live; }
+};
+
+int LargeBuffer::live = 0;
+
+class SmallChild : public GCObject {
+public:
+    int value = 42;
+};
+
+static_assert(GCHeap::sizeClassFor(sizeof(LargeBuffer)) == GCHeap::kLargeClass);
+
+TEST_CASE("Large objects are born old and have their own accounting") {
+    GC::init(50, 50, 0, 50);
+    GC::collectNow(true);
+    GCStats before = GC::stats();
+
+    GCRef<LargeBuffer> buffer(GC::make<LargeBuffer>());
+    REQUIRE(buffer->generation() == Generation::Old);
+
+    GCStats during = GC::stats();
+    REQUIRE(during.largeObjects == before.largeObjects + 1);
+    REQUIRE(during.largeBytes >= before.largeBytes + sizeof(LargeBuffer));
+    REQUIRE(during.youngObjects == before.youngObjects);
+
+    buffer = nullptr;
+    GC::collectNow(false);
+    REQUIRE(LargeBuffer::live == 1);
+
+    GC::collectNow(true);
+    REQUIRE(LargeBuffer::live == 0);
+    GCStats after = GC::stats();
+    REQUIRE(after.largeObjects == before.largeObjects);
+    REQUIRE(after.mappedBytes < during.mappedBytes);
+}
+
+TEST_CASE("Young children of large objects survive minor collections") {
+    GC::init(50, 50, 0, 50);
+    GCRef<LargeBuffer> buffer(GC::make<LargeBuffer>());
+    buffer->child = GC::make<SmallChild>();
+
+    GC::collectNow(false);
+    GC::collectNow(false);
+    REQUIRE(static_cast<SmallChild*>(buffer->child.get())->value == 42);
+
+    buffer = nullptr;
+    GC::collectNow(true);
+    REQUIRE(LargeBuffer::live == 0);
+}
+
+TEST_CASE("Lazy sweeping returns dead large objects to the OS at once") {
+    GC::init(50, 50, 0, 50);
+    GC::setSweepMode(GCSweepMode::Lazy);
+    GC::make<LargeBuffer>();
+    std::size_t mapped = GCHeap::mappedBytes();
+
+    GC::collectNow(true);
+    REQUIRE(LargeBuffer::live == 0);
+    REQUIRE(GCHeap::mappedBytes() < mapped);
+    GC::setSweepMode(GCSweepMode::Incremental);
+}
+
+TEST_CASE("Objects too large for a 32-bit cell size are rejected") {
+    GC::init(50, 50, 0, 50);
+    std::size_t mapped = GCHeap::mappedBytes();
+    REQUIRE_THROWS_AS(GCHeap::allocate(GCHeap::kMaxLargeSize + 1), std::bad_alloc);
+    REQUIRE_THROWS_AS(GCHeap::allocate(std::size_t{5} << 30), std::bad_alloc);
+    REQUIRE(GCHeap::mappedBytes() == mapped);
+}
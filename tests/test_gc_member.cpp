@@ -0,0 +1,196 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: tests/test_gc_member.cpp
+// ----------------------------------
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "GC.h"
+#include "GCMember.h"
+#include "GCObject.h"
+#include "GCRef.h"
+
+#include <stdexcept>
+
+class FieldNode : public GCObject {
+public:
+    GCMember<FieldNode> left;
+    GCMember<FieldNode> right;
+    static int live;
+
+    FieldNode() { ++live; }
+    ~FieldNode() override { --live; }
+
+    GC_FIELDS(&FieldNode::left, &FieldNode::right)
+};
+
+int FieldNode::live = 0;
+
+class FieldLeaf : public FieldNode {
+public:
+    GCMember<FieldNode> extra;
+
+    GC_DERIVED_FIELDS(FieldNode, &FieldLeaf::extra)
+};
+
+class MovableField : public GCObject {
+public:
+    static constexpr bool gcMovable = true;
+
+    GCMember<MovableField> next;
+    int value;
+
+    explicit MovableField(int v = 0) : value(v) {}
+
+    GC_FIELDS(&MovableField::next)
+};
+
+// Fields ahead of the data are in the first page and can be stored to.
+class BigHead : public GCObject {
+public:
+    GCMember<FieldNode> head;
+    unsigned char data[70000];
+
+    GC_FIELDS(&BigHead::head)
+};
+
+// The write barrier would look for this field's page inside `data`.
+class BigTail : public GCObject {
+public:
+    unsigned char data[70000];
+    GCMember<FieldNode> tail;
+
+    GC_FIELDS(&BigTail::tail)
+};
+
+// Stores into the far field before the object is even constructed.
+class BigTailInit : public GCObject {
+public:
+    unsigned char data[70000];
+    GCMember<FieldNode> tail;
+
+    BigTailInit() : tail(GC::make<FieldNode>()) {}
+
+    GC_FIELDS(&BigTailInit::tail)
+};
+
+TEST_CASE("GCMember fields are pointer-sized and keep their children alive") {
+    GC::init(50, 50, 1000000, 50);
+    REQUIRE(sizeof(GCMember<FieldNode>) == sizeof(void*));
+
+    GCRef<FieldNode> root(GC::make<FieldNode>());
+    root->left = GC::make<FieldNode>();
+    root->right = GC::make<FieldNode>();
+    root->left->left = GC::make<FieldNode>();
+    GC::make<FieldNode>();
+
+    GC::collectNow(true);
+    REQUIRE(FieldNode::live == 4);
+
+    root->left = nullptr;
+    GC::collectNow(true);
+    REQUIRE(FieldNode::live == 2);
+
+    root = nullptr;
+    GC::collectNow(true);
+    REQUIRE(FieldNode::live == 0);
+}
+
+TEST_CASE("Derived classes add their fields to the base's") {
+    GC::init(50, 50, 1000000, 50);
+
+    GCRef<FieldLeaf> root(GC::make<FieldLeaf>());
+    root->left = GC::make<FieldNode>();
+    root->extra = GC::make<FieldNode>();
+    REQUIRE(root->fieldMap()->offsets.size() == 3);
+
+    GC::collectNow(true);
+    REQUIRE(FieldNode::live == 3);
+
+    root = nullptr;
+    GC::collectNow(true);
+    REQUIRE(FieldNode::live == 0);
+}
+
+TEST_CASE("An old object storing a young child into a GCMember is remembered") {
+    GC::init(50, 50, 1000000, 50);
+
+    GCRef<FieldNode> root(GC::make<FieldNode>());
+    GC::collectNow(false);
+    GC::collectNow(false);
+    REQUIRE(root->generation() == Generation::Old);
+
+    FieldNode* young = GC::make<FieldNode>();
+    root->right = young;
+    GC::collectNow(false);
+    REQUIRE(root->right.get() == young);
+    REQUIRE(FieldNode::live == 2);
+
+    root = nullptr;
+    GC::collectNow(true);
+    REQUIRE(FieldNode::live == 0);
+}
+
+TEST_CASE("GCMember fields are redirected when nursery objects move") {
+    GC::init(50, 50, 1000000, 50);
+
+    GCRef<MovableField> head(GC::make<MovableField>(1));
+    head->next = GC::make<MovableField>(2);
+    head->next->next = GC::make<MovableField>(3);
+    REQUIRE(GCHeap::inNursery(head->next.get()));
+
+    GC::collectNow(false);
+    REQUIRE_FALSE(GCHeap::inNursery(head.get()));
+    REQUIRE_FALSE(GCHeap::inNursery(head->next.get()));
+    REQUIRE(head->value == 1);
+    REQUIRE(head->next->value == 2);
+    REQUIRE(head->next->next->value == 3);
+}
+
+TEST_CASE("A GCMember store during incremental marking is not lost") {
+    GC::init(1, 1000, 1000000, 50);
+
+    GCRef<FieldNode> root(GC::make<FieldNode>());
+    root->left = GC::make<FieldNode>();
+    root->left->left = GC::make<FieldNode>();
+
+    GC::startIncrementalCollect();
+    GC::incrementalCollectStep();
+
+    // Move the last node under the already-scanned root.
+    FieldNode* middle = root->left.get();
+    root->right = middle->left.get();
+    middle->left = nullptr;
+    while (!GC::incrementalCollectStep()) {}
+    REQUIRE(FieldNode::live == 3);
+
+    root = nullptr;
+    GC::collectNow(true);
+    REQUIRE(FieldNode::live == 0);
+}
+
+TEST_CASE("GCMember fields past a large object's first page are rejected") {
+    GC::init(50, 50, 1000000, 50);
+    GC::collectNow(true);
+    size_t heapBytes = GC::heapBytes();
+
+    GCRef<BigHead> ok(GC::make<BigHead>());
+    ok->head = GC::make<FieldNode>();
+
+    GCRef<BigTail> far(GC::make<BigTail>());
+    REQUIRE_THROWS_AS(far->tail = GC::make<FieldNode>(), std::length_error);
+    far->tail = nullptr;
+    far = nullptr;
+
+    REQUIRE_THROWS_AS(GC::make<BigTailInit>(), std::length_error);
+    REQUIRE_THROWS_AS(new BigTailInit(), std::length_error);
+
+    GC::collectNow(true);
+    REQUIRE(FieldNode::live == 1);
+    ok = nullptr;
+    GC::collectNow(true);
+    REQUIRE(FieldNode::live == 0);
+    REQUIRE(GC::heapBytes() == heapBytes);
+}
@@ -0,0 +1,135 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: tests/test_gc_nursery.cpp
+// ----------------------------------
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "GC.h"
+#include "GCHeap.h"
+#include "GCObject.h"
+#include "GCRef.h"
+
+class MovableNode : public GCObject {
+public:
+    static constexpr bool gcMovable = true;
+    static int constructed;
+
+    GCRef<MovableNode> next;
+    int value;
+
+    explicit MovableNode(int v = 0) : next(this, nullptr), value(v) { ++constructed; }
+};
+
+int MovableNode::constructed = 0;
+
+class PinnedHolder : public GCObject {
+public:
+    GCRef<MovableNode> child;
+
+    PinnedHolder() : child(this, nullptr) {}
+};
+
+TEST_CASE("Movable objects are bump-allocated in the nursery") {
+    GC::init(50, 50, 1000000, 50);
+
+    MovableNode* node = GC::make<MovableNode>(1);
+    REQUIRE(GCHeap::inNursery(node));
+    REQUIRE(node->generation() == Generation::Young);
+
+    PinnedHolder* holder = GC::make<PinnedHolder>();
+    REQUIRE_FALSE(GCHeap::inNursery(holder));
+
+    GC::collectNow(true);
+    REQUIRE(GCHeap::nurseryUsed() == 0);
+}
+
+TEST_CASE("Minor GC evacuates survivors and redirects references") {
+    GC::init(50, 50, 1000000, 50);
+
+    GCRef<MovableNode> head(GC::make<MovableNode>(0));
+    MovableNode* tail = head.get();
+    for (int i = 1; i < 100; ++i) {
+        tail->next = GC::make<MovableNode>(i);
+        tail = tail->next.get();
+    }
+    MovableNode* before = head.get();
+
+    GC::collectNow(false);
+    REQUIRE(head.get() != before);
+    REQUIRE_FALSE(GCHeap::inNursery(head.get()));
+    REQUIRE(head->generation() == Generation::Old);
+    REQUIRE(GCHeap::nurseryUsed() == 0);
+
+    int expected = 0;
+    for (MovableNode* n = head.get(); n; n = n->next.get()) {
+        REQUIRE(n->value == expected++);
+        REQUIRE_FALSE(GCHeap::inNursery(n));
+    }
+    REQUIRE(expected == 100);
+
+    // Member references were rebased onto the copy, so stores through them
+    // still run the barrier for the right owner.
+    head->next = GC::make<MovableNode>(42);
+    GC::collectNow(false);
+    REQUIRE(head->next->value == 42);
+    REQUIRE_FALSE(GCHeap::inNursery(head->next.get()));
+
+    head = nullptr;
+    GC::collectNow(true);
+}
+
+TEST_CASE("Dead nursery objects are discarded without copying") {
+    GC::init(50, 50, 1000000, 50);
+    GC::collectNow(true);
+
+    size_t mappedBefore = GCHeap::mappedBytes();
+    for (int round = 0; round < 20; ++round) {
+        for (int i = 0; i < 1000; ++i) GC::make<MovableNode>(i);
+        GC::collectNow(false);
+        REQUIRE(GCHeap::nurseryUsed() == 0);
+    }
+    // Garbage never leaves the nursery, so the page heap does not grow.
+    REQUIRE(GCHeap::mappedBytes() <= mappedBefore + GCHeap::kDefaultNurserySize);
+}
+
+TEST_CASE("Old object keeps a nursery child alive through the remembered set") {
+    GC::init(50, 50, 1000000, 50);
+
+    GCRef<PinnedHolder> holder(GC::make<PinnedHolder>());
+    GC::collectNow(false);
+    GC::collectNow(false);
+    REQUIRE(holder->generation() == Generation::Old);
+
+    MovableNode* child = GC::make<MovableNode>(7);
+    holder->child = child;
+    REQUIRE(GCHeap::inNursery(child));
+
+    GC::collectNow(false);
+    REQUIRE(holder->child.get() != child);
+    REQUIRE(holder->child->value == 7);
+
+    holder = nullptr;
+    GC::collectNow(true);
+}
+
+TEST_CASE("Incremental cycle empties the nursery before marking") {
+    GC::init(1, 1000, 1000000, 50);
+
+    GCRef<MovableNode> root(GC::make<MovableNode>(3));
+    GC::startIncrementalCollect();
+    while (!GC::incrementalCollectStep()) {
+        // The nursery stays closed while the cycle runs.
+        MovableNode* during = GC::make<MovableNode>(4);
+        REQUIRE_FALSE(GCHeap::inNursery(during));
+    }
+    REQUIRE_FALSE(GCHeap::inNursery(root.get()));
+    REQUIRE(root->value == 3);
+
+    REQUIRE(GCHeap::inNursery(GC::make<MovableNode>(5)));
+
+    root = nullptr;
+    GC::collectNow(true);
+}
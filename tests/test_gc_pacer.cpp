@@ -0,0 +1,101 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: tests/test_gc_pacer.cpp
+// ----------------------------------
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "GC.h"
+#include "GCMember.h"
+#include "GCObject.h"
+#include "GCRef.h"
+
+#include <chrono>
+#include <vector>
+
+class PacedNode : public GCObject {
+public:
+    GCMember<PacedNode> next;
+    int value;
+    static int live;
+    static int destroyed;
+
+    explicit PacedNode(int v = 0) : value(v) { ++live; }
+    ~PacedNode() override {
+        --live;
+        ++destroyed;
+    }
+
+    GC_FIELDS(&PacedNode::next)
+};
+
+int PacedNode::live = 0;
+int PacedNode::destroyed = 0;
+
+// Allocates its children from its own constructor, so paced steps run
+// while the parent is only partly built.
+class PacedPair : public GCObject {
+public:
+    GCMember<PacedNode> first;
+    GCMember<PacedNode> second;
+    int value;
+
+    explicit PacedPair(int v) : value(v) {
+        first = GC::make<PacedNode>(v);
+        second = GC::make<PacedNode>(v + 1);
+    }
+
+    GC_FIELDS(&PacedPair::first, &PacedPair::second)
+};
+
+TEST_CASE("Paced cycles run from allocation and safepoints alone") {
+    GC::init(20, 20, 500, 50);
+    GC::setPauseTarget(std::chrono::microseconds(200));
+
+    GCRef<PacedNode> kept(GC::make<PacedNode>(0));
+    PacedNode* tail = kept.get();
+    for (int i = 1; i < 100; ++i) {
+        tail->next = GC::make<PacedNode>(i);
+        tail = tail->next.get();
+    }
+
+    PacedNode::destroyed = 0;
+    for (int i = 0; i < 50000; ++i) {
+        GC::make<PacedNode>();
+        if (i % 16 == 0) GC::safepoint();
+    }
+
+    // Nothing here steps the collector by hand, so without pacing no
+    // garbage would have been freed.
+    REQUIRE(PacedNode::destroyed > 20000);
+    int i = 0;
+    for (PacedNode* node = kept.get(); node; node = node->next.get()) REQUIRE(node->value == i++);
+    REQUIRE(i == 100);
+
+    GC::setPauseTarget(std::chrono::microseconds(0));
+    kept = nullptr;
+    GC::collectNow(true);
+    REQUIRE(PacedNode::live == 0);
+}
+
+TEST_CASE("Paced steps inside a constructor leave the new object intact") {
+    GC::init(20, 20, 200, 50);
+    GC::setPauseTarget(std::chrono::microseconds(50));
+
+    std::vector<GCRef<PacedPair>> pairs(64);
+    for (int i = 0; i < 20000; ++i) {
+        pairs[i % pairs.size()] = GC::make<PacedPair>(i * 2);
+        if (i % 8 == 0) GC::safepoint();
+    }
+    for (auto& pair : pairs) {
+        REQUIRE(pair->first->value == pair->value);
+        REQUIRE(pair->second->value == pair->value + 1);
+    }
+
+    GC::setPauseTarget(std::chrono::microseconds(0));
+    pairs.clear();
+    GC::collectNow(true);
+    REQUIRE(PacedNode::live == 0);
+}
@@ -0,0 +1,96 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: tests/test_gc_parallel_mark.cpp
+// ----------------------------------
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "GC.h"
+#include "GCObject.h"
+#include "GCRef.h"
+
+#include <atomic>
+
+class MarkNode : public GCObject {
+public:
+    GCRef<MarkNode> left;
+    GCRef<MarkNode> right;
+    static std::atomic<int> live;
+
+    MarkNode() : left(this, nullptr), right(this, nullptr) { ++live; }
+    ~MarkNode() override { --live; }
+};
+
+std::atomic<int> MarkNode::live{0};
+
+static MarkNode* buildTree(int depth) {
+    MarkNode* node = GC::make<MarkNode>();
+    if (depth > 0) {
+        node->left = buildTree(depth - 1);
+        node->right = buildTree(depth - 1);
+    }
+    return node;
+}
+
+static MarkNode* buildList(int length) {
+    MarkNode* head = GC::make<MarkNode>();
+    MarkNode* tail = head;
+    for (int i = 1; i < length; ++i) {
+        tail->right = GC::make<MarkNode>();
+        tail = tail->right.get();
+    }
+    return head;
+}
+
+TEST_CASE("Parallel major collection keeps exactly the reachable objects") {
+    GC::init(50, 50, 1000000, 50);
+
+    for (unsigned workers : {1u, 2u, 4u}) {
+        GC::setMarkWorkers(workers);
+
+        GCRef<MarkNode> tree(buildTree(12));
+        GCRef<MarkNode> list(buildList(5000));
+        buildTree(8);
+        buildList(1000);
+
+        GC::collectNow(true);
+        REQUIRE(MarkNode::live == (1 << 13) - 1 + 5000);
+
+        tree->left = nullptr;
+        GC::collectNow(true);
+        REQUIRE(MarkNode::live == (1 << 12) + 5000);
+
+        tree = nullptr;
+        list = nullptr;
+        GC::collectNow(true);
+        REQUIRE(MarkNode::live == 0);
+    }
+    GC::setMarkWorkers(1);
+}
+
+TEST_CASE("Parallel major collection rebuilds the remembered set") {
+    GC::init(50, 50, 1000000, 50);
+    GC::setMarkWorkers(4);
+
+    GCRef<MarkNode> root(buildList(100));
+    GC::collectNow(false);
+    GC::collectNow(false);
+    REQUIRE(root->generation() == Generation::Old);
+
+    MarkNode* parent = root.get();
+    for (int i = 0; i < 50; ++i) parent = parent->right.get();
+    parent->left = GC::make<MarkNode>();
+    GC::collectNow(true);
+
+    // Only the remembered set reaches the young child in a minor collection.
+    GC::collectNow(false);
+    REQUIRE(parent->left.get() != nullptr);
+    REQUIRE(MarkNode::live == 101);
+
+    root = nullptr;
+    GC::collectNow(true);
+    REQUIRE(MarkNode::live == 0);
+    GC::setMarkWorkers(1);
+}
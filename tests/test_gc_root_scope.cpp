@@ -0,0 +1,115 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: tests/test_gc_root_scope.cpp
+// ----------------------------------
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "GC.h"
+#include "GCHeap.h"
+#include "GCObject.h"
+#include "GCRef.h"
+#include "GCRootScope.h"
+
+class ScopedNode : public GCObject {
+public:
+    GCRef<ScopedNode> next;
+    static int live;
+
+    ScopedNode() : next(this, nullptr) { ++live; }
+    ~ScopedNode() override { --live; }
+};
+
+int ScopedNode::live = 0;
+
+class ScopedMovable : public GCObject {
+public:
+    static constexpr bool gcMovable = true;
+
+    GCRef<ScopedMovable> next;
+    int value;
+
+    explicit ScopedMovable(int v = 0) : next(this, nullptr), value(v) {}
+};
+
+TEST_CASE("Locals keep objects alive until their scope ends") {
+    GC::init(50, 50, 1000000, 50);
+
+    {
+        GCRootScope scope;
+        GCLocal<ScopedNode> a(GC::make<ScopedNode>());
+        a->next = GC::make<ScopedNode>();
+        {
+            GCRootScope inner;
+            GCLocal<ScopedNode> b(GC::make<ScopedNode>());
+            GC::collectNow(true);
+            REQUIRE(ScopedNode::live == 3);
+        }
+        GC::collectNow(true);
+        REQUIRE(ScopedNode::live == 2);
+
+        GCLocal<ScopedNode> c = a;
+        a = nullptr;
+        GC::collectNow(true);
+        REQUIRE(ScopedNode::live == 2);
+        REQUIRE(c->next.get() != nullptr);
+    }
+    GC::collectNow(true);
+    REQUIRE(ScopedNode::live == 0);
+}
+
+TEST_CASE("Shadow stack grows past one segment and shrinks with its scope") {
+    GC::init(50, 50, 1000000, 50);
+
+    const int count = static_cast<int>(GCShadowStack::kSegmentSlots) * 3 + 10;
+    for (int round = 0; round < 2; ++round) {
+        GCRootScope scope;
+        for (int i = 0; i < count; ++i) GCLocal<ScopedNode> local(GC::make<ScopedNode>());
+        GC::collectNow(true);
+        REQUIRE(ScopedNode::live == count);
+    }
+    GC::collectNow(true);
+    REQUIRE(ScopedNode::live == 0);
+}
+
+TEST_CASE("Locals are redirected when nursery objects move") {
+    GC::init(50, 50, 1000000, 50);
+
+    GCRootScope scope;
+    GCLocal<ScopedMovable> head(GC::make<ScopedMovable>(1));
+    head->next = GC::make<ScopedMovable>(2);
+    REQUIRE(GCHeap::inNursery(head.get()));
+
+    GC::collectNow(false);
+    REQUIRE_FALSE(GCHeap::inNursery(head.get()));
+    REQUIRE(head->value == 1);
+    REQUIRE(head->next->value == 2);
+}
+
+TEST_CASE("A local set during incremental marking is rescanned before the sweep") {
+    GC::init(1, 1000, 1000000, 50);
+
+    GCRootScope scope;
+    GCRef<ScopedNode> root(GC::make<ScopedNode>());
+    root->next = GC::make<ScopedNode>();
+    root->next->next = GC::make<ScopedNode>();
+
+    // With a budget of one, the first step scans only the root.
+    GC::startIncrementalCollect();
+    GC::incrementalCollectStep();
+
+    // Move the only reference to the last node into a local before the
+    // marker reaches it.
+    ScopedNode* middle = root->next.get();
+    GCLocal<ScopedNode> held(middle->next.get());
+    middle->next = nullptr;
+    while (!GC::incrementalCollectStep()) {}
+    REQUIRE(ScopedNode::live == 3);
+
+    root = nullptr;
+    held = nullptr;
+    GC::collectNow(true);
+    REQUIRE(ScopedNode::live == 0);
+}
@@ -0,0 +1,111 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: tests/test_gc_snapshot.cpp
+// ----------------------------------
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "GC.h"
+#include "GCHeap.h"
+#include "GCHeapSnapshot.h"
+#include "GCMember.h"
+#include "GCObject.h"
+#include "GCRef.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+class SnapNode : public GCObject {
+public:
+    GCMember<SnapNode> left, right;
+
+    GC_FIELDS(&SnapNode::left, &SnapNode::right)
+};
+
+class SnapBlob : public GCObject {
+public:
+    char payload[GCHeap::kMaxSmallSize * 2];
+};
+
+class MovableSnapNode : public GCObject {
+public:
+    static constexpr bool gcMovable = true;
+    GCRef<SnapNode> target;
+
+    MovableSnapNode() : target(this, nullptr) {}
+};
+
+static std::string snapshotPath() {
+    return "test_gc_snapshot.bin";
+}
+
+TEST_CASE("Heap dumps record objects, edges and roots") {
+    GC::init(50, 50, 0, 50);
+    // An old object that dies is kept until the next major collection.
+    GCRef<SnapNode> doomed(GC::make<SnapNode>());
+    GC::collectNow(true);
+    GC::collectNow(true);
+    SnapNode* dead = doomed.get();
+    doomed = nullptr;
+
+    GCRef<SnapNode> root(GC::make<SnapNode>());
+    root->left = GC::make<SnapNode>();
+    root->right = GC::make<SnapNode>();
+    root->left->right = root->right.get();
+    GCRef<SnapBlob> blob(GC::make<SnapBlob>());
+    GCRef<MovableSnapNode> movable(GC::make<MovableSnapNode>());
+    movable->target = root.get();
+    dead->left = root.get();
+
+    REQUIRE(GC::dumpHeap(snapshotPath()));
+    // The nursery was emptied, so the movable object is on a page now.
+    REQUIRE_FALSE(GCHeap::inNursery(movable.get()));
+
+    GCHeapSnapshot snap;
+    REQUIRE(snap.open(snapshotPath()));
+    REQUIRE(snap.objects().size() == 6);
+    REQUIRE(snap.roots().size() == 3);
+    REQUIRE(snap.allEdges().size() == 5);
+
+    auto indexOf = [&snap](const void* obj) {
+        std::int64_t index = snap.find(reinterpret_cast<std::uintptr_t>(obj));
+        REQUIRE(index >= 0);
+        return static_cast<std::uint32_t>(index);
+    };
+    std::uint32_t r = indexOf(root.get());
+    REQUIRE(snap.edges(r).size() == 2);
+    REQUIRE(snap.edges(r)[0] == indexOf(root->left.get()));
+    REQUIRE(snap.edges(r)[1] == indexOf(root->right.get()));
+    REQUIRE(snap.edges(indexOf(movable.get()))[0] == r);
+    REQUIRE(snap.edges(indexOf(dead))[0] == r);
+
+    const GCSnapshotObject& b = snap.objects()[indexOf(blob.get())];
+    REQUIRE(b.flags & GCSnapshotObject::kLarge);
+    REQUIRE(b.size > GCHeap::kMaxSmallSize);
+    REQUIRE(b.generation == 1);
+    REQUIRE(snap.objects()[indexOf(dead)].generation == 1);
+    REQUIRE(snap.objects()[indexOf(movable.get())].flags & GCSnapshotObject::kMovable);
+    REQUIRE(snap.typeName(snap.objects()[r].type).find("SnapNode") != std::string::npos);
+    REQUIRE(snap.typeName(b.type).find("SnapBlob") != std::string::npos);
+
+    snap.close();
+    std::remove(snapshotPath().c_str());
+}
+
+TEST_CASE("Opening a file that is not a snapshot fails cleanly") {
+    const std::string path = snapshotPath();
+    FILE* f = std::fopen(path.c_str(), "wb");
+    REQUIRE(f);
+    std::fputs("not a heap snapshot, but long enough to hold a snapshot header........", f);
+    std::fclose(f);
+
+    GCHeapSnapshot snap;
+    REQUIRE_FALSE(snap.open(path));
+    REQUIRE_FALSE(snap.error().empty());
+    REQUIRE(snap.objects().empty());
+    REQUIRE_FALSE(snap.open("does-not-exist.bin"));
+    std::remove(path.c_str());
+}
@@ -0,0 +1,104 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: tests/test_gc_stats.cpp
+// ----------------------------------
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "GC.h"
+#include "GCMember.h"
+#include "GCObject.h"
+#include "GCRef.h"
+#include "GCStats.h"
+
+#include <chrono>
+#include <vector>
+
+class StatsNode : public GCObject {
+public:
+    GCMember<StatsNode> next;
+
+    GC_FIELDS(&StatsNode::next)
+};
+
+static StatsNode* buildStatsChain(int length) {
+    StatsNode* head = GC::make<StatsNode>();
+    StatsNode* tail = head;
+    for (int i = 1; i < length; ++i) {
+        tail->next = GC::make<StatsNode>();
+        tail = tail->next.get();
+    }
+    return head;
+}
+
+TEST_CASE("Stats count allocations, frees and collections") {
+    GC::init(50, 50, 0, 50);
+    GC::collectNow(true);
+    GCStats before = GC::stats();
+
+    GCRef<StatsNode> kept(buildStatsChain(100));
+    for (int i = 0; i < 400; ++i) GC::make<StatsNode>();
+    GC::collectNow(false);
+    GC::collectNow(true);
+
+    GCStats after = GC::stats();
+    REQUIRE(after.objectsAllocated - before.objectsAllocated == 500);
+    REQUIRE(after.bytesAllocated - before.bytesAllocated >= 500 * sizeof(StatsNode));
+    REQUIRE(after.objectsFreed - before.objectsFreed == 400);
+    REQUIRE(after.minorCollections == before.minorCollections + 1);
+    REQUIRE(after.majorCollections == before.majorCollections + 1);
+    REQUIRE(after.pauses.count == before.pauses.count + 2);
+    REQUIRE(after.roots >= 1);
+    REQUIRE(after.oldObjects + after.youngObjects >= 100);
+    REQUIRE(after.heapBytes == after.youngBytes + after.oldBytes);
+
+    kept = nullptr;
+    GC::collectNow(true);
+}
+
+TEST_CASE("Cycle hooks see the start and end of each collection") {
+    GC::init(50, 50, 0, 50);
+    GC::collectNow(true);
+
+    std::vector<GCCycleEvent> events;
+    int id = GC::addCycleHook([&events](const GCCycleEvent& e) { events.push_back(e); });
+
+    for (int i = 0; i < 300; ++i) GC::make<StatsNode>();
+    GC::collectNow(true);
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[0].kind == GCCycleKind::Major);
+    REQUIRE_FALSE(events[0].end);
+    REQUIRE(events[1].end);
+    REQUIRE(events[1].cycle == events[0].cycle);
+    REQUIRE(events[1].objectsFreed == 300);
+
+    events.clear();
+    GC::startIncrementalCollect();
+    while (!GC::incrementalCollectStep()) {}
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[0].kind == GCCycleKind::Incremental);
+    REQUIRE(events[1].kind == GCCycleKind::Incremental);
+    REQUIRE(events[1].end);
+
+    GC::removeCycleHook(id);
+    GC::collectNow(false);
+    REQUIRE(events.size() == 2);
+}
+
+TEST_CASE("Pause percentiles fall within a bucket of the recorded pauses") {
+    GCPauseHistogram histogram;
+    REQUIRE(histogram.percentile(0.5).count() == 0);
+    for (int i = 1; i <= 100; ++i) histogram.record(std::chrono::microseconds(i));
+
+    REQUIRE(histogram.count == 100);
+    REQUIRE(histogram.max == std::chrono::microseconds(100));
+    auto p50 = histogram.percentile(0.5);
+    REQUIRE(p50 >= std::chrono::microseconds(50));
+    REQUIRE(p50 <= std::chrono::microseconds(63));
+    REQUIRE(histogram.percentile(1.0) == std::chrono::microseconds(100));
+    for (unsigned b = 1; b < GCPauseHistogram::kBuckets; ++b) {
+        REQUIRE(GCPauseHistogram::bucketOf(GCPauseHistogram::bucketLimit(b - 1)) == b);
+    }
+}
@@ -0,0 +1,212 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: tests/test_gc_sweep.cpp
+// ----------------------------------
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "GC.h"
+#include "GCHeap.h"
+#include "GCObject.h"
+#include "GCRef.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+class SweepNode : public GCObject {
+public:
+    GCRef<SweepNode> next;
+    GCRef<SweepNode> other;
+    static int destroyed;
+
+    SweepNode() : next(this, nullptr), other(this, nullptr) {}
+    ~SweepNode() override { ++destroyed; }
+};
+
+int SweepNode::destroyed = 0;
+
+// Builds a live chain and an unreachable chain of n nodes each. The
+// unreachable nodes point at each other, so a sweep that patched every
+// reference to a dead object would scan the whole heap per dead object.
+static void buildChains(GCRef<SweepNode>& live, int n) {
+    live = new SweepNode();
+    SweepNode* tail = live.get();
+    for (int i = 0; i < n; ++i) {
+        SweepNode* node = new SweepNode();
+        tail->next = node;
+        tail = node;
+    }
+
+    SweepNode* prev = nullptr;
+    for (int i = 0; i < n; ++i) {
+        SweepNode* node = new SweepNode();
+        node->next = prev;
+        node->other = prev;
+        prev = node;
+    }
+}
+
+// Turns the heap-growth trigger off for a scope, so only the test's own
+// blocking collections sweep. The default policy comes back even when a
+// REQUIRE fails.
+struct NoGrowthTrigger {
+    NoGrowthTrigger() {
+        GCHeapPolicy policy;
+        policy.growthRatio = 0;
+        GC::setHeapPolicy(policy);
+    }
+    ~NoGrowthTrigger() { GC::setHeapPolicy(GCHeapPolicy{}); }
+};
+
+TEST_CASE("Sweep frees exactly the unreachable objects") {
+    GC::init(50, 50, 1000000, 50);
+    NoGrowthTrigger noTrigger;
+    GC::collectNow(true);
+
+    for (int n : {25000, 100000}) {
+        GCRef<SweepNode> live;
+        buildChains(live, n);
+
+        SweepNode::destroyed = 0;
+        GCStats before = GC::stats();
+        GC::collectNow(true);
+        GCStats after = GC::stats();
+        REQUIRE(SweepNode::destroyed == n);
+        REQUIRE(after.objectsFreed - before.objectsFreed == static_cast<std::uint64_t>(n));
+        // Each object on the heap is examined once, live or dead.
+        REQUIRE(after.objectsSwept - before.objectsSwept == before.youngObjects + before.oldObjects);
+
+        live = nullptr;
+        GC::collectNow(true);
+        REQUIRE(SweepNode::destroyed == 2 * n + 1);
+    }
+}
+
+// Times the blocking collection that frees the dead chain of n nodes and
+// returns its cost per dead object, best of several runs.
+static double sweepTimePerObject(int n) {
+    double best = 0;
+    for (int run = 0; run < 5; ++run) {
+        GCRef<SweepNode> live;
+        buildChains(live, n);
+
+        auto start = std::chrono::steady_clock::now();
+        GC::collectNow(true);
+        std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+
+        live = nullptr;
+        GC::collectNow(true);
+        double perObject = took.count() / n;
+        if (run == 0 || perObject < best) best = perObject;
+    }
+    return best;
+}
+
+TEST_CASE("Sweep time per dead object stays flat as the heap grows") {
+    GC::init(50, 50, 1000000, 50);
+    NoGrowthTrigger noTrigger;
+    GC::collectNow(true);
+
+    double small = sweepTimePerObject(25000);
+    double large = sweepTimePerObject(100000);
+
+    // Linear sweeping keeps the ratio near 1. Scanning every reference for
+    // each dead object makes it about 4, since the heap is 4x larger too.
+    REQUIRE(large < small * 2.5);
+}
+
+TEST_CASE("Root created during incremental marking keeps its object alive") {
+    GC::init(1, 1000, 1000000, 50);
+
+    SweepNode* kept = new SweepNode();
+    GCRef<SweepNode> anchor(new SweepNode());
+    for (int i = 0; i < 10; ++i) {
+        SweepNode* node = new SweepNode();
+        node->next = anchor.get();
+        anchor = node;
+    }
+
+    GC::startIncrementalCollect();
+    GC::incrementalCollectStep();
+
+    GCRef<SweepNode> late(kept);
+    while (!GC::incrementalCollectStep()) {}
+
+    REQUIRE(late.get() == kept);
+    REQUIRE(late->next.get() == nullptr);
+
+    late = nullptr;
+    anchor = nullptr;
+    GC::collectNow(true);
+}
+
+class CountedNode : public GCObject {
+public:
+    GCRef<CountedNode> next;
+    static std::atomic<int> live;
+
+    CountedNode() : next(this, nullptr) { ++live; }
+    ~CountedNode() override { --live; }
+};
+
+std::atomic<int> CountedNode::live{0};
+
+static void buildGarbage(int n) {
+    for (int i = 0; i < n; ++i) GC::make<CountedNode>();
+}
+
+TEST_CASE("Lazy sweep defers destructors until cells are needed") {
+    GC::init(50, 50, 1000000, 50);
+    GC::setSweepMode(GCSweepMode::Lazy);
+
+    GCRef<CountedNode> kept(GC::make<CountedNode>());
+    buildGarbage(10000);
+    GC::collectNow(true);
+
+    // Marking is done but nothing has been swept yet.
+    REQUIRE(CountedNode::live == 10001);
+
+    // Allocating sweeps pages of the size class one at a time.
+    size_t mapped = GCHeap::mappedBytes();
+    buildGarbage(2000);
+    REQUIRE(CountedNode::live < 10001 + 2000);
+    REQUIRE(CountedNode::live > 2001);
+    REQUIRE(GCHeap::mappedBytes() == mapped);
+
+    // The next collection finishes the leftovers before marking.
+    GC::collectNow(true);
+    GC::setSweepMode(GCSweepMode::Incremental);
+    REQUIRE(CountedNode::live == 1);
+    REQUIRE(kept->next.get() == nullptr);
+
+    kept = nullptr;
+    GC::collectNow(true);
+    REQUIRE(CountedNode::live == 0);
+}
+
+TEST_CASE("Background sweep runs destructors off the mutator") {
+    GC::init(50, 50, 1000000, 50);
+    GC::setSweepMode(GCSweepMode::Background);
+
+    GCRef<CountedNode> kept(GC::make<CountedNode>());
+    buildGarbage(20000);
+    GC::collectNow(true);
+
+    // The mutator keeps allocating while the sweeper works.
+    GCRef<CountedNode> fresh(GC::make<CountedNode>());
+    for (int i = 0; i < 1000; ++i) fresh->next = GC::make<CountedNode>();
+    while (!GC::incrementalCollectStep()) {}
+
+    REQUIRE(CountedNode::live == 2 + 1000);
+    REQUIRE(fresh->next.get() != nullptr);
+
+    kept = nullptr;
+    fresh = nullptr;
+    GC::collectNow(true);
+    GC::collectNow(true);
+    GC::setSweepMode(GCSweepMode::Incremental);
+    REQUIRE(CountedNode::live == 0);
+}
@@ -0,0 +1,140 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: tests/test_gc_threads.cpp
+// ----------------------------------
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "GC.h"
+#include "GCObject.h"
+#include "GCRef.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+class SharedNode : public GCObject {
+public:
+    GCRef<SharedNode> next;
+    int value;
+    static std::atomic<int> live;
+
+    explicit SharedNode(int v = 0) : next(this, nullptr), value(v) { ++live; }
+    ~SharedNode() override { --live; }
+};
+
+std::atomic<int> SharedNode::live{0};
+
+class MovableLink : public GCObject {
+public:
+    static constexpr bool gcMovable = true;
+
+    GCRef<MovableLink> next;
+    int value;
+
+    explicit MovableLink(int v = 0) : next(this, nullptr), value(v) {}
+};
+
+template <typename T>
+static T* buildList(int n) {
+    T* head = GC::make<T>(0);
+    T* tail = head;
+    for (int i = 1; i < n; ++i) {
+        tail->next = GC::make<T>(i);
+        tail = tail->next.get();
+    }
+    return head;
+}
+
+template <typename T>
+static bool listIntact(const GCRef<T>& head, int n) {
+    int i = 0;
+    for (T* node = head.get(); node; node = node->next.get(), ++i) {
+        if (node->value != i) return false;
+    }
+    return i == n;
+}
+
+TEST_CASE("Threads allocate and hold roots while another thread collects") {
+    GC::init(50, 50, 1000000, 50);
+
+    const int threads = 4;
+    const int rounds = 200;
+    const int length = 20;
+    std::atomic<int> running{threads};
+    std::atomic<int> broken{0};
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            std::vector<GCRef<SharedNode>> kept(4);
+            std::vector<GCRef<MovableLink>> moved(4);
+            for (int r = 0; r < rounds; ++r) {
+                kept[r % kept.size()] = buildList<SharedNode>(length);
+                moved[r % moved.size()] = buildList<MovableLink>(length);
+                GC::safepoint();
+                for (size_t k = 0; k < kept.size(); ++k) {
+                    if (kept[k] && !listIntact(kept[k], length)) ++broken;
+                    if (moved[k] && !listIntact(moved[k], length)) ++broken;
+                }
+            }
+            --running;
+        });
+    }
+
+    bool major = false;
+    while (running > 0) {
+        GC::collectNow(major);
+        major = !major;
+        std::this_thread::yield();
+    }
+    for (std::thread& w : workers) w.join();
+
+    REQUIRE(broken == 0);
+    GC::collectNow(true);
+    REQUIRE(SharedNode::live == 0);
+}
+
+TEST_CASE("A root registered on one thread can be released on another") {
+    GC::init(50, 50, 1000000, 50);
+
+    GCRef<SharedNode>* ref = nullptr;
+    std::thread([&] { ref = new GCRef<SharedNode>(buildList<SharedNode>(10)); }).join();
+
+    // The thread has exited; its root table keeps the list alive.
+    GC::collectNow(true);
+    REQUIRE(SharedNode::live == 10);
+    REQUIRE(listIntact(*ref, 10));
+
+    delete ref;
+    GC::collectNow(true);
+    REQUIRE(SharedNode::live == 0);
+}
+
+TEST_CASE("A thread inside a safe region does not hold up collections") {
+    GC::init(50, 50, 1000000, 50);
+
+    std::atomic<bool> entered{false};
+    std::atomic<bool> release{false};
+    GCRef<SharedNode> kept;
+
+    std::thread blocked([&] {
+        kept = buildList<SharedNode>(5);
+        GCSafeRegion region;
+        entered = true;
+        while (!release) std::this_thread::yield();
+    });
+    while (!entered) std::this_thread::yield();
+
+    GC::make<SharedNode>();
+    GC::collectNow(true);
+    REQUIRE(SharedNode::live == 5);
+
+    release = true;
+    blocked.join();
+    kept = nullptr;
+    GC::collectNow(true);
+    REQUIRE(SharedNode::live == 0);
+}
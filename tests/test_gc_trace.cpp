@@ -0,0 +1,74 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: tests/test_gc_trace.cpp
+// ----------------------------------
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "GC.h"
+#include "GCMember.h"
+#include "GCObject.h"
+#include "GCRef.h"
+#include "GCTrace.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+class TraceNode : public GCObject {
+public:
+    GCMember<TraceNode> next;
+
+    GC_FIELDS(&TraceNode::next)
+};
+
+static std::string readFile(const std::string& path) {
+    std::ifstream in(path);
+    std::stringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+TEST_CASE("The trace dumps as Chrome trace JSON") {
+    GC::init(50, 50, 0, 50);
+    GCTrace::clear();
+
+    GCRef<TraceNode> kept(GC::make<TraceNode>());
+    for (int i = 0; i < 100; ++i) GC::make<TraceNode>();
+    GC::collectNow(true);
+
+    const std::string path = "gc_trace_test.json";
+    REQUIRE(GCTrace::dump(path));
+    std::string json = readFile(path);
+    std::remove(path.c_str());
+
+    REQUIRE(json.find("\"traceEvents\":[") != std::string::npos);
+    if (GCTrace::enabled) {
+        REQUIRE(json.find("\"name\":\"Collection\",\"cat\":\"gc\",\"ph\":\"B\"") != std::string::npos);
+        REQUIRE(json.find("\"name\":\"BlockingMark\"") != std::string::npos);
+        REQUIRE(json.find("\"ph\":\"E\"") != std::string::npos);
+    } else {
+        REQUIRE(json.find("\"name\"") == std::string::npos);
+    }
+}
+
+TEST_CASE("A full ring keeps only its newest records") {
+    if (!GCTrace::enabled) return;
+    GCTrace::clear();
+    for (std::size_t i = 0; i < GCTraceRing::kRecords + 10; ++i) {
+        GCTrace::record(GCTracePoint::Promotion, GCTraceKind::Instant, static_cast<std::uint32_t>(i));
+    }
+
+    const std::string path = "gc_trace_ring.json";
+    REQUIRE(GCTrace::dump(path));
+    std::string json = readFile(path);
+    std::remove(path.c_str());
+
+    // The oldest slot is dropped too, since the next record goes there.
+    REQUIRE(json.find("\"value\":10}") == std::string::npos);
+    REQUIRE(json.find("\"value\":11}") != std::string::npos);
+    REQUIRE(json.find("\"value\":" + std::to_string(GCTraceRing::kRecords + 9) + "}") != std::string::npos);
+}
@@ -0,0 +1,110 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: tests/test_gc_tracer.cpp
+// ----------------------------------
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "GC.h"
+#include "GCObject.h"
+#include "GCRef.h"
+#include "GCTracer.h"
+
+#include <vector>
+
+class TracedLeaf : public GCObject {
+public:
+    static int live;
+
+    TracedLeaf() { ++live; }
+    ~TracedLeaf() override { --live; }
+};
+
+int TracedLeaf::live = 0;
+
+// Holds children both in a GCRef member and in a raw pointer only
+// reported through trace().
+class TracedHolder : public GCObject {
+public:
+    GCRef<TracedLeaf> member;
+    TracedLeaf* hidden = nullptr;
+
+    TracedHolder() : member(this, nullptr) {}
+
+    void trace(GCTracer& tracer) const override {
+        traceMembers(tracer);
+        tracer.visit(hidden);
+    }
+};
+
+// Reports its children through the old list-based override.
+class LegacyHolder : public GCObject {
+public:
+    std::vector<TracedLeaf*> hidden;
+
+    void traceChildren(std::vector<GCObject*>& out) const override {
+        for (TracedLeaf* leaf : hidden) out.push_back(leaf);
+    }
+};
+
+TEST_CASE("A trace() override keeps member and extra children alive") {
+    GC::init(50, 50, 1000000, 50);
+
+    GCRef<TracedHolder> holder(GC::make<TracedHolder>());
+    holder->member = GC::make<TracedLeaf>();
+    holder->hidden = GC::make<TracedLeaf>();
+    GC::make<TracedLeaf>();
+
+    GC::collectNow(true);
+    REQUIRE(TracedLeaf::live == 2);
+
+    holder->hidden = nullptr;
+    GC::collectNow(true);
+    REQUIRE(TracedLeaf::live == 1);
+
+    holder = nullptr;
+    GC::collectNow(true);
+    REQUIRE(TracedLeaf::live == 0);
+}
+
+TEST_CASE("traceChildren() overrides are still traced") {
+    GC::init(50, 50, 1000000, 50);
+
+    GCRef<LegacyHolder> holder(GC::make<LegacyHolder>());
+    for (int i = 0; i < 3; ++i) holder->hidden.push_back(GC::make<TracedLeaf>());
+
+    GC::collectNow(true);
+    REQUIRE(TracedLeaf::live == 3);
+
+    holder->hidden.pop_back();
+    GC::collectNow(true);
+    REQUIRE(TracedLeaf::live == 2);
+
+    holder = nullptr;
+    GC::collectNow(true);
+    REQUIRE(TracedLeaf::live == 0);
+}
+
+TEST_CASE("Tracers mark children as they are visited") {
+    GC::init(50, 50, 1000000, 50);
+
+    GCRef<TracedHolder> holder(GC::make<TracedHolder>());
+    holder->member = GC::make<TracedLeaf>();
+    holder->hidden = GC::make<TracedLeaf>();
+
+    std::vector<GCObject*> found;
+    GCTracer collect(GCTracer::Mode::Collect, &found);
+    holder->trace(collect);
+    REQUIRE(found.size() == 2);
+
+    GC::setMarkWorkers(2);
+    GC::collectNow(true);
+    GC::setMarkWorkers(1);
+    REQUIRE(TracedLeaf::live == 2);
+
+    holder = nullptr;
+    GC::collectNow(true);
+    REQUIRE(TracedLeaf::live == 0);
+}
@@ -0,0 +1,203 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: tests/test_gc_vector.cpp
+// ----------------------------------
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "GC.h"
+#include "GCHeap.h"
+#include "GCObject.h"
+#include "GCRef.h"
+#include "GCVector.h"
+
+#include <cstdint>
+#include <vector>
+
+class VecNode : public GCObject {
+public:
+    int value;
+    static int live;
+
+    explicit VecNode(int v = 0) : value(v) { ++live; }
+    ~VecNode() override { --live; }
+};
+
+int VecNode::live = 0;
+
+class MovableVecNode : public GCObject {
+public:
+    static constexpr bool gcMovable = true;
+    int value;
+
+    explicit MovableVecNode(int v = 0) : value(v) {}
+};
+
+// A graph vertex holding its out-edges in a GCVector.
+class Vertex : public GCObject {
+public:
+    GCRef<GCVector<Vertex>> edges;
+    int id;
+
+    explicit Vertex(int id) : edges(this, GC::make<GCVector<Vertex>>()), id(id) {}
+};
+
+TEST_CASE("A vector keeps its elements alive until they are removed") {
+    GC::init(50, 50, 0, 50);
+    GCRef<GCVector<VecNode>> vec(GC::make<GCVector<VecNode>>());
+    const int n = 100000;
+    for (int i = 0; i < n; ++i) vec->push_back(GC::make<VecNode>(i));
+
+    GC::collectNow(true);
+    REQUIRE(vec->size() == n);
+    REQUIRE(VecNode::live == n);
+    int expected = 0;
+    for (VecNode* node : *vec) REQUIRE(node->value == expected++);
+
+    vec->resize(10);
+    vec->pop_back();
+    GC::collectNow(true);
+    REQUIRE(VecNode::live == 9);
+    REQUIRE(vec->back()->value == 8);
+
+    vec->clear();
+    GC::collectNow(true);
+    REQUIRE(VecNode::live == 0);
+}
+
+TEST_CASE("Bulk stores into an old vector are seen by minor collections") {
+    GC::init(50, 50, 0, 50);
+    GCRef<GCVector<VecNode>> vec(GC::make<GCVector<VecNode>>());
+    GC::collectNow(true);
+    GC::collectNow(true);
+    REQUIRE(vec->generation() == Generation::Old);
+
+    std::vector<VecNode*> fresh;
+    for (int i = 0; i < 100; ++i) fresh.push_back(GC::make<VecNode>(i));
+    vec->append(std::span<VecNode* const>(fresh));
+    vec->resize(150);
+    vec->fill(100, 150, GC::make<VecNode>(-1));
+    vec->copy(0, *vec, 50, 100);
+    fresh.clear();
+
+    GC::collectNow(false);
+    REQUIRE(VecNode::live == 51);
+    REQUIRE(vec->get(0)->value == 50);
+    REQUIRE(vec->get(49)->value == 99);
+    REQUIRE(vec->get(50)->value == -1);
+    REQUIRE(vec->get(99)->value == -1);
+    REQUIRE(vec->get(100)->value == -1);
+
+    vec = nullptr;
+    GC::collectNow(true);
+    REQUIRE(VecNode::live == 0);
+}
+
+TEST_CASE("Arrays have a fixed length and copy overlapping ranges") {
+    GC::init(50, 50, 0, 50);
+    GCRef<GCArray<VecNode>> arr(GC::make<GCArray<VecNode>>(8));
+    REQUIRE(arr->size() == 8);
+    for (VecNode* node : *arr) REQUIRE(node == nullptr);
+
+    std::vector<VecNode*> values;
+    for (int i = 0; i < 4; ++i) values.push_back(GC::make<VecNode>(i));
+    arr->assign(0, std::span<VecNode* const>(values));
+    arr->copy(2, *arr, 0, 4);
+    REQUIRE(arr->get(2)->value == 0);
+    REQUIRE(arr->get(5)->value == 3);
+    REQUIRE(arr->get(1)->value == 1);
+
+    arr->set(1, nullptr);
+    GC::collectNow(true);
+    REQUIRE(VecNode::live == 4);
+
+    arr->fill(nullptr);
+    GC::collectNow(true);
+    REQUIRE(VecNode::live == 0);
+}
+
+TEST_CASE("Vector elements follow movable objects when they move") {
+    GC::init(50, 50, 0, 50);
+    GCRef<GCVector<MovableVecNode>> vec(GC::make<GCVector<MovableVecNode>>());
+    for (int i = 0; i < 20000; ++i) vec->push_back(GC::make<MovableVecNode>(i));
+    REQUIRE(GCHeap::inNursery(vec->get(0)));
+
+    GC::collectNow(false);
+    for (std::size_t i = 0; i < vec->size(); ++i) {
+        REQUIRE_FALSE(GCHeap::inNursery(vec->get(i)));
+        REQUIRE(vec->get(i)->value == static_cast<int>(i));
+    }
+
+    // Leave every eighth element, then let compaction move the survivors.
+    GC::setCompaction(true);
+    for (std::size_t i = 0; i < vec->size(); ++i) {
+        if (i % 8 != 0) vec->set(i, nullptr);
+    }
+    GCStats before = GC::stats();
+    GC::collectNow(true);
+    REQUIRE(GC::stats().objectsCompacted > before.objectsCompacted);
+    for (std::size_t i = 0; i < vec->size(); i += 8) REQUIRE(vec->get(i)->value == static_cast<int>(i));
+    GC::setCompaction(false);
+
+    vec = nullptr;
+    GC::collectNow(true);
+}
+
+TEST_CASE("Incremental marking traces vector elements as one range") {
+    GC::init(50, 1000, 1000000, 50);
+    GCRef<GCVector<VecNode>> vec(GC::make<GCVector<VecNode>>());
+    GC::collectNow(true);
+    GC::collectNow(true);
+    REQUIRE(vec->generation() == Generation::Old);
+
+    // The incremental mark tracer tracks young children, which must not
+    // push it off the range loop.
+    const int n = 5000;
+    for (int i = 0; i < n; ++i) vec->push_back(GC::make<VecNode>(i));
+    GCStats before = GC::stats();
+    GC::startIncrementalCollect();
+    while (!GC::incrementalCollectStep()) {}
+    REQUIRE(GC::stats().rangeSlotsMarked - before.rangeSlotsMarked >= static_cast<std::uint64_t>(n));
+
+    GC::collectNow(false);
+    REQUIRE(VecNode::live == n);
+    for (int i = 0; i < n; ++i) REQUIRE(vec->get(i)->value == i);
+
+    vec = nullptr;
+    GC::collectNow(true);
+    REQUIRE(VecNode::live == 0);
+}
+
+TEST_CASE("Concurrent marking keeps objects moved into a vector") {
+    GC::init(50, 1000, 1000000, 50);
+    GC::setConcurrentMarking(true);
+    std::vector<GCRef<Vertex>> graph;
+    const int n = 2000;
+    for (int i = 0; i < n; ++i) graph.emplace_back(GC::make<Vertex>(i));
+    for (int i = 0; i < n; ++i) {
+        for (int j = 1; j <= 4; ++j) graph[i]->edges->push_back(graph[(i + j) % n].get());
+    }
+
+    GCRef<GCVector<Vertex>> moved(GC::make<GCVector<Vertex>>());
+    GC::startIncrementalCollect();
+    GC::incrementalCollectStep();
+
+    // The only other paths to the vertices are dropped as the marker runs.
+    std::vector<Vertex*> raw;
+    for (auto& v : graph) raw.push_back(v.get());
+    moved->append(std::span<Vertex* const>(raw));
+    for (auto& v : graph) v->edges->clear();
+    graph.clear();
+
+    while (!GC::incrementalCollectStep()) {}
+    GC::setConcurrentMarking(false);
+
+    GC::collectNow(true);
+    REQUIRE(moved->size() == n);
+    for (int i = 0; i < n; ++i) REQUIRE(moved->get(i)->id == i);
+
+    moved = nullptr;
+    GC::collectNow(true);
+}
@@ -0,0 +1,130 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: tests/test_gc_weak.cpp
+// ----------------------------------
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "GC.h"
+#include "GCHeap.h"
+#include "GCMember.h"
+#include "GCObject.h"
+#include "GCRef.h"
+#include "GCWeak.h"
+
+class WeakNode : public GCObject {
+public:
+    GCMember<WeakNode> next;
+    int value;
+    static int live;
+
+    explicit WeakNode(int v = 0) : value(v) { ++live; }
+    ~WeakNode() override { --live; }
+
+    GC_FIELDS(&WeakNode::next)
+};
+
+int WeakNode::live = 0;
+
+class MovableWeakNode : public GCObject {
+public:
+    static constexpr bool gcMovable = true;
+    GCRef<MovableWeakNode> next;
+    int value;
+
+    explicit MovableWeakNode(int v = 0) : next(this, nullptr), value(v) {}
+};
+
+TEST_CASE("Weak references are cleared once their object dies") {
+    GC::init(50, 50, 0, 50);
+    GCRef<WeakNode> strong(GC::make<WeakNode>(1));
+    GCWeakRef<WeakNode> weak(strong.get());
+    GCWeakRef<WeakNode> orphan(GC::make<WeakNode>(2));
+
+    GC::collectNow(true);
+    REQUIRE(weak.get() == strong.get());
+    REQUIRE(orphan.expired());
+
+    strong = nullptr;
+    GC::collectNow(true);
+    REQUIRE(weak.expired());
+    REQUIRE(WeakNode::live == 0);
+}
+
+TEST_CASE("Minor collections clear young weak targets and follow evacuated ones") {
+    GC::init(50, 50, 0, 50);
+    GCRef<MovableWeakNode> kept(GC::make<MovableWeakNode>(7));
+    REQUIRE(GCHeap::inNursery(kept.get()));
+    GCWeakRef<MovableWeakNode> toKept(kept.get());
+    GCWeakRef<MovableWeakNode> toDead(GC::make<MovableWeakNode>(8));
+    GCWeakRef<WeakNode> toDeadPage(GC::make<WeakNode>(9));
+
+    GC::collectNow(false);
+    REQUIRE_FALSE(GCHeap::inNursery(kept.get()));
+    REQUIRE(toKept.get() == kept.get());
+    REQUIRE(toKept.get()->value == 7);
+    REQUIRE(toDead.expired());
+    REQUIRE(toDeadPage.expired());
+}
+
+TEST_CASE("Incremental cycles clear weak references after marking") {
+    GC::init(50, 50, 0, 50);
+    GCWeakRef<WeakNode> weak(GC::make<WeakNode>(3));
+    GCRef<WeakNode> strong(GC::make<WeakNode>(4));
+    GCWeakRef<WeakNode> weakToStrong(strong.get());
+
+    GC::startIncrementalCollect();
+    while (!GC::incrementalCollectStep()) {}
+    REQUIRE(weak.expired());
+    REQUIRE(weakToStrong.get() == strong.get());
+
+    strong = nullptr;
+    GC::collectNow(true);
+}
+
+TEST_CASE("Ephemeron values live exactly as long as their keys") {
+    GC::init(50, 50, 0, 50);
+    GCEphemeronMap<WeakNode, WeakNode> map;
+    GCRef<WeakNode> key(GC::make<WeakNode>(1));
+    map.set(key.get(), GC::make<WeakNode>(10));
+
+    // The value points back at its key; that must not keep the entry alive.
+    WeakNode* doomed = GC::make<WeakNode>(2);
+    WeakNode* doomedValue = GC::make<WeakNode>(20);
+    doomedValue->next = doomed;
+    map.set(doomed, doomedValue);
+
+    // A chain: key1 -> value1 is itself the key of another entry.
+    WeakNode* chained = GC::make<WeakNode>(30);
+    map.set(map.get(key.get()), chained);
+
+    GC::collectNow(true);
+    REQUIRE(map.size() == 2);
+    REQUIRE(map.get(key.get())->value == 10);
+    REQUIRE(map.get(map.get(key.get()))->value == 30);
+    REQUIRE(WeakNode::live == 3);
+
+    key = nullptr;
+    GC::collectNow(true);
+    REQUIRE(map.size() == 0);
+    REQUIRE(WeakNode::live == 0);
+}
+
+TEST_CASE("Minor collections keep ephemeron values of surviving keys") {
+    GC::init(50, 50, 0, 50);
+    GCEphemeronMap<MovableWeakNode, WeakNode> map;
+    GCRef<MovableWeakNode> key(GC::make<MovableWeakNode>(1));
+    map.set(key.get(), GC::make<WeakNode>(5));
+    map.set(GC::make<MovableWeakNode>(2), GC::make<WeakNode>(6));
+
+    GC::collectNow(false);
+    REQUIRE_FALSE(GCHeap::inNursery(key.get()));
+    REQUIRE(map.size() == 1);
+    REQUIRE(map.get(key.get())->value == 5);
+
+    key = nullptr;
+    GC::collectNow(true);
+    REQUIRE(map.size() == 0);
+}
@@ -0,0 +1,352 @@
+// ----------------------------------
+// Course: CSC 2210
+// Section: 002
+// Name: Keagan Weinstock
+// File: tools/gc_analyze.cpp
+// ----------------------------------
+
+// Reads a heap snapshot written by GC::dumpHeap() and reports what keeps
+// memory alive: object counts and retained sizes per type, the objects
+// that retain the most, and the shortest chain of references from a root
+// to each of them. Retained sizes come from the dominator tree, computed
+// with the Lengauer-Tarjan algorithm, so multi-million-object snapshots
+// are analyzed in seconds.
+//
+// Usage: gc_analyze [--top=N] [--type=NAME] [--path=ADDRESS] SNAPSHOT
+//   --top=N         list N types and N objects (default 10)
+//   --type=NAME     list only objects of the named type
+//   --path=ADDRESS  print the shortest root path to one object
+
+#include "GCHeapSnapshot.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <span>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    constexpr uint32_t kNone = UINT32_MAX;
+
+    // The snapshot's objects plus a virtual root, numbered after them,
+    // whose successors are the objects held by roots.
+    class Graph {
+    public:
+        explicit Graph(const GCHeapSnapshot& snap) : snap(snap), root(static_cast<uint32_t>(snap.objects().size())) {}
+
+        uint32_t vertices() const { return root + 1; }
+
+        span<const uint32_t> successors(uint32_t v) const { return v == root ? snap.roots() : snap.edges(v); }
+
+        const GCHeapSnapshot& snap;
+        const uint32_t root;
+    };
+
+    struct Dominators {
+        // Reached vertices in depth-first preorder; order[0] is the root.
+        vector<uint32_t> order;
+        // Immediate dominator of each vertex, or kNone if unreachable.
+        vector<uint32_t> idom;
+    };
+
+    // Lengauer-Tarjan with path compression, O(m log n).
+    Dominators dominators(const Graph& g) {
+        uint32_t n = g.vertices();
+        Dominators d;
+        vector<uint32_t> dfn(n, kNone);
+        vector<uint32_t> parent(n, kNone);
+        vector<uint32_t>& order = d.order;
+
+        struct Frame {
+            uint32_t v;
+            uint32_t next;
+        };
+        vector<Frame> stack{{g.root, 0}};
+        dfn[g.root] = 0;
+        order.push_back(g.root);
+        while (!stack.empty()) {
+            Frame& f = stack.back();
+            span<const uint32_t> succ = g.successors(f.v);
+            if (f.next == succ.size()) {
+                stack.pop_back();
+                continue;
+            }
+            uint32_t from = f.v;
+            uint32_t w = succ[f.next++];
+            if (dfn[w] != kNone) continue;
+            dfn[w] = static_cast<uint32_t>(order.size());
+            order.push_back(w);
+            parent[w] = from;
+            stack.push_back({w, 0});
+        }
+
+        // Predecessors of reached vertices, as offsets into one array.
+        vector<uint64_t> predStart(n + 1, 0);
+        for (uint32_t v : order) {
+            for (uint32_t w : g.successors(v)) ++predStart[w + 1];
+        }
+        for (uint32_t v = 0; v < n; ++v) predStart[v + 1] += predStart[v];
+        vector<uint32_t> preds(predStart[n]);
+        vector<uint64_t> fill(predStart.begin(), predStart.end() - 1);
+        for (uint32_t v : order) {
+            for (uint32_t w : g.successors(v)) preds[fill[w]++] = v;
+        }
+
+        vector<uint32_t> semi(n, kNone);
+        vector<uint32_t> label(n);
+        vector<uint32_t> ancestor(n, kNone);
+        vector<uint32_t> bucketHead(n, kNone);
+        vector<uint32_t> bucketNext(n, kNone);
+        d.idom.assign(n, kNone);
+        vector<uint32_t>& idom = d.idom;
+        for (uint32_t v : order) {
+            semi[v] = dfn[v];
+            label[v] = v;
+        }
+
+        vector<uint32_t> path;
+        auto eval = [&](uint32_t v) {
+            if (ancestor[v] == kNone) return v;
+            // Compress the forest path above v, nearest the tree root first.
+            path.clear();
+            for (uint32_t x = v; ancestor[ancestor[x]] != kNone; x = ancestor[x]) path.push_back(x);
+            for (size_t k = path.size(); k-- > 0;) {
+                uint32_t y = path[k];
+                uint32_t a = ancestor[y];
+                if (semi[label[a]] < semi[label[y]]) label[y] = label[a];
+                ancestor[y] = ancestor[a];
+            }
+            return label[v];
+        };
+
+        for (size_t i = order.size(); i-- > 1;) {
+            uint32_t w = order[i];
+            for (uint64_t k = predStart[w]; k < predStart[w + 1]; ++k) {
+                uint32_t u = eval(preds[k]);
+                if (semi[u] < semi[w]) semi[w] = semi[u];
+            }
+            uint32_t s = order[semi[w]];
+            bucketNext[w] = bucketHead[s];
+            bucketHead[s] = w;
+
+            uint32_t p = parent[w];
+            ancestor[w] = p;
+            for (uint32_t v = bucketHead[p]; v != kNone; v = bucketNext[v]) {
+                uint32_t u = eval(v);
+                idom[v] = semi[u] < semi[v] ? u : p;
+            }
+            bucketHead[p] = kNone;
+        }
+        for (size_t i = 1; i < order.size(); ++i) {
+            uint32_t w = order[i];
+            if (idom[w] != order[semi[w]]) idom[w] = idom[idom[w]];
+        }
+        return d;
+    }
+
+    // Breadth-first search from the roots; the parent of each object on
+    // one of its shortest root paths, or kNone if it is unreachable.
+    vector<uint32_t> shortestPathParents(const Graph& g) {
+        vector<uint32_t> parent(g.vertices(), kNone);
+        vector<uint32_t> queue{g.root};
+        parent[g.root] = g.root;
+        for (size_t head = 0; head < queue.size(); ++head) {
+            uint32_t v = queue[head];
+            for (uint32_t w : g.successors(v)) {
+                if (parent[w] != kNone) continue;
+                parent[w] = v;
+                queue.push_back(w);
+            }
+        }
+        return parent;
+    }
+
+    string formatBytes(uint64_t bytes) {
+        char text[32];
+        if (bytes >= 1024 * 1024) {
+            snprintf(text, sizeof(text), "%.1f MiB", static_cast<double>(bytes) / (1024.0 * 1024.0));
+        } else if (bytes >= 1024) {
+            snprintf(text, sizeof(text), "%.1f KiB", static_cast<double>(bytes) / 1024.0);
+        } else {
+            snprintf(text, sizeof(text), "%" PRIu64 " B", bytes);
+        }
+        return text;
+    }
+
+    void printObject(const GCHeapSnapshot& snap, uint32_t v) {
+        const GCSnapshotObject& o = snap.objects()[v];
+        string_view name = snap.typeName(o.type);
+        printf("%.*s@0x%" PRIx64, static_cast<int>(name.size()), name.data(), o.address);
+    }
+
+    // Prints root -> ... -> v, eliding the middle of very long chains.
+    void printPath(const Graph& g, const vector<uint32_t>& parent, uint32_t v) {
+        constexpr size_t kMaxShown = 12;
+        vector<uint32_t> chain;
+        for (uint32_t x = v; x != g.root; x = parent[x]) chain.push_back(x);
+        reverse(chain.begin(), chain.end());
+        printf("    root");
+        for (size_t i = 0; i < chain.size(); ++i) {
+            if (chain.size() > kMaxShown && i == kMaxShown / 2) {
+                size_t skipped = chain.size() - kMaxShown;
+                printf(" -> ... %zu more ...", skipped);
+                i += skipped - 1;
+                continue;
+            }
+            printf(" -> ");
+            printObject(g.snap, chain[i]);
+        }
+        printf("\n");
+    }
+
+    struct TypeRow {
+        uint32_t type;
+        uint64_t count = 0;
+        uint64_t shallow = 0;
+        uint64_t retained = 0;
+    };
+
+    // Per-type totals. An object's retained size counts toward its type
+    // unless an object of the same type dominates it, so nested structures
+    // such as lists are not counted once per node.
+    vector<TypeRow> typeRows(const GCHeapSnapshot& snap, const Dominators& d, const vector<uint64_t>& retained,
+                             uint32_t root) {
+        vector<TypeRow> rows(snap.typeCount());
+        for (uint32_t t = 0; t < rows.size(); ++t) rows[t].type = t;
+        for (const GCSnapshotObject& o : snap.objects()) {
+            ++rows[o.type].count;
+            rows[o.type].shallow += o.size;
+        }
+
+        // Dominator tree children, then a depth-first walk that knows how
+        // many objects of each type are on the current tree path.
+        vector<uint32_t> childStart(root + 2, 0);
+        for (size_t i = 1; i < d.order.size(); ++i) ++childStart[d.idom[d.order[i]] + 1];
+        for (uint32_t v = 0; v <= root; ++v) childStart[v + 1] += childStart[v];
+        vector<uint32_t> children(childStart[root + 1]);
+        vector<uint32_t> fill(childStart.begin(), childStart.end() - 1);
+        for (size_t i = 1; i < d.order.size(); ++i) children[fill[d.idom[d.order[i]]]++] = d.order[i];
+
+        vector<uint32_t> onPath(snap.typeCount(), 0);
+        struct Frame {
+            uint32_t v;
+            uint32_t next;
+        };
+        vector<Frame> stack{{root, childStart[root]}};
+        while (!stack.empty()) {
+            Frame& f = stack.back();
+            if (f.next == childStart[f.v + 1]) {
+                if (f.v != root) --onPath[snap.objects()[f.v].type];
+                stack.pop_back();
+                continue;
+            }
+            uint32_t w = children[f.next++];
+            uint32_t type = snap.objects()[w].type;
+            if (onPath[type]++ == 0) rows[type].retained += retained[w];
+            stack.push_back({w, childStart[w]});
+        }
+        return rows;
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t top = 10;
+    string onlyType;
+    const char* pathTo = nullptr;
+    const char* file = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--top=", 6) == 0) {
+            top = strtoul(argv[i] + 6, nullptr, 10);
+        } else if (strncmp(argv[i], "--type=", 7) == 0) {
+            onlyType = argv[i] + 7;
+        } else if (strncmp(argv[i], "--path=", 7) == 0) {
+            pathTo = argv[i] + 7;
+        } else if (argv[i][0] != '-' && !file) {
+            file = argv[i];
+        } else {
+            file = nullptr;
+            break;
+        }
+    }
+    if (!file) {
+        fprintf(stderr, "usage: %s [--top=N] [--type=NAME] [--path=ADDRESS] SNAPSHOT\n", argv[0]);
+        return 2;
+    }
+
+    GCHeapSnapshot snap;
+    if (!snap.open(file)) {
+        fprintf(stderr, "%s: %s\n", argv[0], snap.error().c_str());
+        return 1;
+    }
+    Graph g(snap);
+    span<const GCSnapshotObject> objects = snap.objects();
+
+    if (pathTo) {
+        int64_t index = snap.find(strtoull(pathTo, nullptr, 0));
+        if (index < 0) {
+            fprintf(stderr, "%s: no object at %s\n", argv[0], pathTo);
+            return 1;
+        }
+        vector<uint32_t> parent = shortestPathParents(g);
+        auto v = static_cast<uint32_t>(index);
+        if (parent[v] == kNone) {
+            printObject(snap, v);
+            printf(" is not reachable from any root\n");
+        } else {
+            printPath(g, parent, v);
+        }
+        return 0;
+    }
+
+    Dominators d = dominators(g);
+    vector<uint64_t> retained(g.vertices(), 0);
+    for (uint32_t v : d.order) {
+        if (v != g.root) retained[v] = objects[v].size;
+    }
+    // Children come after their immediate dominator in preorder.
+    for (size_t i = d.order.size(); i-- > 1;) retained[d.idom[d.order[i]]] += retained[d.order[i]];
+
+    uint64_t totalBytes = 0;
+    for (const GCSnapshotObject& o : objects) totalBytes += o.size;
+    size_t reachable = d.order.size() - 1;
+    printf("%zu objects (%s), %zu edges, %zu roots, %zu types\n", objects.size(), formatBytes(totalBytes).c_str(),
+           snap.allEdges().size(), snap.roots().size(), snap.typeCount());
+    printf("reachable %zu objects (%s), unreachable %zu objects (%s)\n\n", reachable,
+           formatBytes(retained[g.root]).c_str(), objects.size() - reachable,
+           formatBytes(totalBytes - retained[g.root]).c_str());
+
+    vector<TypeRow> rows = typeRows(snap, d, retained, g.root);
+    sort(rows.begin(), rows.end(), [](const TypeRow& a, const TypeRow& b) { return a.retained > b.retained; });
+    printf("%12s %12s %12s  %s\n", "count", "shallow", "retained", "type");
+    for (size_t i = 0; i < rows.size() && i < top; ++i) {
+        string_view name = snap.typeName(rows[i].type);
+        printf("%12" PRIu64 " %12s %12s  %.*s\n", rows[i].count, formatBytes(rows[i].shallow).c_str(),
+               formatBytes(rows[i].retained).c_str(), static_cast<int>(name.size()), name.data());
+    }
+
+    vector<uint32_t> largest;
+    for (size_t i = 1; i < d.order.size(); ++i) {
+        uint32_t v = d.order[i];
+        if (onlyType.empty() || snap.typeName(objects[v].type) == onlyType) largest.push_back(v);
+    }
+    size_t shown = min(top, largest.size());
+    partial_sort(largest.begin(), largest.begin() + static_cast<ptrdiff_t>(shown), largest.end(),
+                 [&retained](uint32_t a, uint32_t b) { return retained[a] > retained[b]; });
+    largest.resize(shown);
+
+    vector<uint32_t> parent = shortestPathParents(g);
+    printf("\n%12s %12s  %s\n", "retained", "shallow", "object");
+    for (uint32_t v : largest) {
+        printf("%12s %12s  ", formatBytes(retained[v]).c_str(), formatBytes(objects[v].size).c_str());
+        printObject(snap, v);
+        printf("\n");
+        printPath(g, parent, v);
+    }
+    return 0;
+}